@@ -9,7 +9,20 @@
  * - Create & delete symbol table
  * - Add & remove key-value pairs
  * - Retrieve, replace, check for keys
+ * - Find or add a key's binding in one pass
+ * - Look up many keys in one batch
  * - Apply a user-defined function to every entry
+ * - Apply it with several threads at once
+ * - Walk the entries one at a time with a cursor
+ * - Visit the entries of a key range or prefix in key order
+ * - Intern keys and look them up by handle
+ * - Choose the hash function of a table
+ * - Size a table in advance for a known number of bindings
+ * - Compact a table after many of its bindings are removed
+ * - Let a linked list move its most looked-up keys to the front
+ * - Let a hash table turn away most missing keys with a filter
+ * - Look up keys given by their length, without a '\0'
+ * - Hash a key once and look it up in several tables
  */
 
 #ifndef SYMTABLE_INCLUDED
@@ -24,12 +37,114 @@
  * arbitrary data types */
 typedef struct SymTable *SymTable_T;
 
+/*
+ * SymTableKey_T is a handle to the canonical ("interned") copy of a
+ * key string. interning equal strings always returns the same
+ * handle, and the handle carries the key's precomputed hash, so
+ * tables can look it up without hashing or comparing characters.
+ * handles stay valid until the program exits.
+ */
+typedef const struct SymTableKey *SymTableKey_T;
+
+/*
+ * struct SymTableIter is a cursor over the bindings of a symbol
+ * table, opened by SymTable_begin, moved along by SymTable_next and
+ * closed by SymTable_end. the caller owns it, so opening one
+ * allocates nothing, and it is copied by assignment; a copy goes
+ * on from the same place. what its members hold depends on the
+ * implementation, and clients must not use them
+ */
+struct SymTableIter {
+    SymTable_T oSymTable;
+    void *pvNode;
+    void *pvArray;
+    void *pvReader;
+    size_t uIndex;
+    size_t uCount;
+};
+
 /* 
  * creates a empty SymTable, allocates memory for it, 
  * and returns it 
  */
 SymTable_T SymTable_new(void);
 
+/*
+ * like SymTable_new, but the table hashes keys with pfHash instead
+ * of the built-in hash function. pfHash must return the same code
+ * for equal strings. unlike the built-in hash function it is not
+ * keyed with a secret, so keys chosen to collide under pfHash
+ * collide in the table too. implementations that do not hash
+ * ignore it
+ */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey));
+
+/*
+ * like SymTable_new, but the table starts out with room for
+ * uCapacity bindings, so that putting that many never makes it
+ * grow. returns NULL if memory allocation fails
+ */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/*
+ * makes room in oSymTable for uCapacity bindings in all, so that
+ * adding bindings up to that count does not make it grow; worth
+ * calling before putting many bindings at once. never shrinks
+ * oSymTable. returns 1 if successful and 0 if memory allocation
+ * fails. the bindings of oSymTable are unchanged either way
+ */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity);
+
+/*
+ * shrinks oSymTable to the smallest size that holds its bindings
+ * and gives back the memory it no longer needs; worth calling
+ * after removing many bindings. returns 1 if successful and 0 if
+ * memory allocation fails, in which case oSymTable is as it was.
+ * the bindings of oSymTable are unchanged either way
+ */
+int SymTable_compact(SymTable_T oSymTable);
+
+/*
+ * policies by which lookups may reorder the bindings of a table,
+ * for SymTable_setPolicy
+ */
+#define SYMTABLE_POLICY_STATIC 0
+#define SYMTABLE_POLICY_MOVE_TO_FRONT 1
+#define SYMTABLE_POLICY_TRANSPOSE 2
+
+/*
+ * makes every lookup that finds a key in oSymTable, by
+ * SymTable_get, SymTable_contains, SymTable_replace,
+ * SymTable_findOrInsert or any of their variants, reorder the
+ * bindings by iPolicy, so that the keys looked up most come to be
+ * found soonest. SYMTABLE_POLICY_MOVE_TO_FRONT moves the binding
+ * found to the front; SYMTABLE_POLICY_TRANSPOSE swaps it with the
+ * binding before it, which adapts more slowly but is not thrown off
+ * by a key looked up once. SYMTABLE_POLICY_STATIC, the default,
+ * never reorders. only the linked list implementation reorders;
+ * the others find a key in the same time wherever it is, and
+ * ignore iPolicy. with a policy other than the default, lookups
+ * change oSymTable, so they must not be made by several threads at
+ * once. lookups leave the order alone while a cursor is open on
+ * oSymTable or SymTable_map is under way
+ */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy);
+
+/*
+ * turns the filter of oSymTable on if iEnable is not 0, and off
+ * otherwise. the filter is a Bloom filter of the keys' hashes,
+ * kept up to date by every put and remove, that tells most keys
+ * oSymTable does not hold from those it does; SymTable_get,
+ * SymTable_contains and their variants then answer for such a key
+ * without looking at the bindings. worth turning on for a table
+ * that is mostly asked for keys it does not hold. it is off by
+ * default. only the hash table with separate chaining keeps a
+ * filter; the others ignore iEnable. returns 1 if successful and 0
+ * if memory allocation fails, in which case the filter stays off.
+ * the bindings of oSymTable are unchanged either way
+ */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable);
+
 /* frees memory needed for symbol table oSymTable */
 void SymTable_free(SymTable_T oSymTable);
 
@@ -54,6 +169,23 @@ int SymTable_put(SymTable_T oSymTable,
 void *SymTable_replace(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue);
 
+/*
+ * returns the address of the value of key pcKey in oSymTable. if
+ * pcKey doesn't exist, a binding of pcKey and pvValue is added
+ * first. the key is hashed and looked up only once, so this
+ * replaces SymTable_contains followed by SymTable_put or
+ * SymTable_replace. if piCreated is not NULL, *piCreated is set to
+ * 1 if the binding was added and 0 if it already existed.
+ * the address stays valid until the next call that adds or removes
+ * a binding of oSymTable or compacts it. in the thread-safe
+ * implementations the key is found or added atomically, but the
+ * caller must keep other threads from changing oSymTable while it
+ * uses the address.
+ * returns NULL if memory allocation fails
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated);
+
 /* 
  * checks if given key pcKey exists within oSymTable. 
  * returns 1 if pcKey exists, if else returns 0 
@@ -67,6 +199,17 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey);
  */
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey);
 
+/*
+ * looks up each of the uNumKeys keys in apcKeys within oSymTable
+ * and stores its value at the same position of apvValues, or NULL
+ * if the key doesn't exist. gives the same results as calling
+ * SymTable_get on each key in turn, but interleaves the lookups so
+ * that their cache misses overlap; worthwhile for many keys in a
+ * table larger than the cache
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]);
+
 /* 
  * removes binding associated with given pcKey from the
  * symbol table (oSymTable) and frees memory.
@@ -78,10 +221,173 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
 /* 
  * to each binding in oSymTable, apply function (pfApply) given by
  * the user. user is able to input additional parameter pvExtra
- * if needed for the user defined function. 
+ * if needed for the user defined function. the radix tree
+ * implementation rebuilds each key for the call, so pcKey is only
+ * valid until pfApply returns
  */
 void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra);
 
+/*
+ * like SymTable_map, but the bindings are split among up to
+ * iThreadCount threads, the calling one included, which apply
+ * pfApply to them at the same time; returns once pfApply has been
+ * applied to every binding. pfApply is called from several threads
+ * at once with the same pvExtra, so it must be safe to do so,
+ * typically by only reading shared data or by writing only to
+ * memory that belongs to the binding it is given. neither pfApply
+ * nor any other thread may change oSymTable meanwhile. with
+ * iThreadCount at most 1, the calling thread applies pfApply to
+ * every binding itself, as do the implementations whose bindings
+ * cannot be split without walking them all
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount);
+
+/*
+ * opens cursor *psIter over the bindings of oSymTable, in no
+ * particular order except in the B-tree and radix tree
+ * implementations, which return them in key order. every binding
+ * that is in oSymTable from SymTable_begin until SymTable_end is
+ * returned by SymTable_next exactly once. while the cursor is
+ * open, values may be replaced and the binding the cursor returned
+ * last may be removed;
+ * bindings removed or put meanwhile may or may not be returned.
+ * the linked list, hash table and B-tree implementations also
+ * allow putting bindings: a hash table still grows meanwhile, but
+ * leaves its bindings where they are until its last cursor is
+ * closed, and is not compacted before that. the thread-safe
+ * implementations allow any change by any thread; the cursor must
+ * be used and closed by the thread that opened it, and the memory
+ * of removed bindings is not freed until it is closed. no other
+ * change is allowed while a cursor is open
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter);
+
+/*
+ * moves cursor *psIter to the next binding of its table and
+ * returns 1, setting *ppcKey to the binding's key and *ppvValue to
+ * its value unless they are NULL. returns 0, setting neither, once
+ * every binding has been returned. the radix tree implementation
+ * rebuilds the key in the cursor, so *ppcKey is only valid until
+ * the cursor or any copy of it returns another key
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue);
+
+/*
+ * closes cursor *psIter. must be called once for every
+ * SymTable_begin, with the cursor or any copy of it, after which
+ * none of them may be used
+ */
+void SymTable_end(struct SymTableIter *psIter);
+
+/*
+ * to each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function (pfApply) given by the user, with
+ * pvExtra as its extra argument, in increasing order of the keys as
+ * strcmp compares them. a NULL pcLow or pcHigh leaves that end of
+ * the range open. the B-tree implementation finds the first binding
+ * in O(log n) and visits the k in range in O(k), and the radix tree
+ * one finds it in time proportional to the length of the bound;
+ * the others collect and sort the bindings in range, which takes
+ * O(n + k log k) and memory for k bindings. as in SymTable_map,
+ * the keys of the radix tree implementation are only valid until
+ * pfApply returns. pfApply must not change oSymTable, but other
+ * threads may change a thread-safe one meanwhile, in which case
+ * bindings put or removed meanwhile may or may not be visited.
+ * returns 1 if successful and 0 if memory allocation fails, in
+ * which case pfApply was not applied to any binding
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*
+ * like SymTable_mapRange, but visits the bindings of oSymTable
+ * whose keys start with pcPrefix, in key order. every key starts
+ * with the empty string
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*
+ * returns the canonical handle for key string pcKey, creating it
+ * if pcKey was never interned before. the intern pool is shared by
+ * all symbol tables, and may be used by several threads at once.
+ * returns NULL if memory allocation fails
+ */
+SymTableKey_T SymTable_intern(const char *pcKey);
+
+/* returns the key string of interned key oKey */
+const char *SymTable_keyString(SymTableKey_T oKey);
+
+/*
+ * the following work like SymTable_put, SymTable_replace,
+ * SymTable_contains, SymTable_get, and SymTable_remove with the key
+ * string of oKey. bindings put with either kind of key can be found
+ * with either kind; bindings put by handle are matched by address.
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue);
+
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue);
+
+int SymTable_containsInterned(SymTable_T oSymTable, SymTableKey_T oKey);
+
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey);
+
+void *SymTable_removeInterned(SymTable_T oSymTable, SymTableKey_T oKey);
+
+/*
+ * the following work like SymTable_put, SymTable_contains,
+ * SymTable_get, and SymTable_remove with the key made of the
+ * uLength characters at pcKey, which need not be followed by '\0'
+ * but must not contain one. they read the characters in place, so
+ * a key can be looked up straight out of a larger buffer;
+ * SymTable_putN copies them and adds the '\0'. a table with its
+ * own hash function hashes a copy of a long key, so there
+ * SymTable_containsN, SymTable_getN, and SymTable_removeN also
+ * return 0 or NULL if memory allocation fails
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue);
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength);
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength);
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength);
+
+/*
+ * returns the hash code of key string pcKey for the functions
+ * below. the code depends only on pcKey, not on any table, so a key
+ * looked up in a chain of tables need only be hashed once. it stays
+ * the same until the program exits
+ */
+size_t SymTable_hashKey(const char *pcKey);
+
+/*
+ * the following work like SymTable_put, SymTable_get, and
+ * SymTable_remove, but take uHash, which must be
+ * SymTable_hashKey(pcKey), instead of hashing pcKey again. a table
+ * with its own hash function ignores uHash and hashes pcKey itself
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue);
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash);
+
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1767 @@
+/*
+ * symtableart.c
+ *
+ * Symbol table module implementation via an adaptive radix tree.
+ * Keys are spelled out one character per level, with the '\0' that
+ * ends each key as a character too, so no key lies on the path to
+ * another. A run of characters shared by every key under a node is
+ * stored once, as the node's prefix, and a leaf stores only the
+ * characters of its key that no other key shares, so keys with long
+ * common prefixes cost little more than their differences. Each
+ * inner node takes the smallest of four layouts that fits its
+ * children, from four sorted slots up to a direct array of 256, so
+ * a lookup costs one small node search per character that tells
+ * keys apart, whatever the number of bindings. Children are kept in
+ * character order, which is the order of strcmp, so a key range or
+ * prefix is found in one descent and read off leaf by leaf.
+ * functionalities include:
+ * - creating and deleting a symbol table
+ * - adding and removing key-value pairs
+ * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
+ * - applying a user-defined function to each entry
+ * - applying it with several threads at once
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - compacting a table to the size of its bindings
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablekey.h"
+#include "symtablepool.h"
+/* layouts of a node */
+#define NODE_LEAF 0
+#define NODE_4 1
+#define NODE_16 2
+#define NODE_48 3
+#define NODE_256 4
+/* an inner node shrinks to the next smaller layout once it has no
+   more than this many children; the margin below the smaller
+   layout's capacity keeps a node from changing layout at every put
+   and remove around the boundary */
+#define SHRINK_TO_4 3
+#define SHRINK_TO_16 12
+#define SHRINK_TO_48 40
+
+/* fields every node starts with */
+struct SymTableNode {
+    /* NODE_LEAF for a leaf, or the layout of an inner node */
+    unsigned char ucType;
+    /* character of the key under which the node hangs from its
+       parent */
+    unsigned char ucByte;
+    /* number of children of an inner node; unused in a leaf */
+    unsigned short usNumChildren;
+    /* parent, or NULL for the root */
+    struct SymTableNode *psParent;
+    /* position in the keys under the node of the first character of
+       its prefix, or for a leaf of the first character of its
+       suffix */
+    size_t uDepth;
+    /* number of characters in the prefix of an inner node, which
+       follows the layout's struct in the same allocation; for a
+       leaf, the length of its whole key */
+    size_t uLength;
+};
+
+/* node holding a binding */
+struct SymTableLeaf {
+    /* common fields */
+    struct SymTableNode sNode;
+    /* value for key */
+    void *pvValue;
+    /* handle the binding was put with, or NULL if it was put with a
+       key string. if not NULL, acSuffix is empty and the key's
+       characters are read from the handle */
+    SymTableKey_T oKey;
+    /* the characters of the key from position sNode.uDepth to its
+       end, without the '\0' */
+    char acSuffix[];
+};
+
+/* inner node with up to 4 children, in character order */
+struct SymTableNode4 {
+    struct SymTableNode sNode;
+    unsigned char aucBytes[4];
+    struct SymTableNode *apsChildren[4];
+};
+
+/* inner node with up to 16 children, in character order */
+struct SymTableNode16 {
+    struct SymTableNode sNode;
+    unsigned char aucBytes[16];
+    struct SymTableNode *apsChildren[16];
+};
+
+/* inner node with up to 48 children in any slots; aucSlots maps
+   each character to one more than the slot of its child, or to 0 if
+   it has none */
+struct SymTableNode48 {
+    struct SymTableNode sNode;
+    unsigned char aucSlots[256];
+    struct SymTableNode *apsChildren[48];
+};
+
+/* inner node with a child slot for every character */
+struct SymTableNode256 {
+    struct SymTableNode sNode;
+    struct SymTableNode *apsChildren[256];
+};
+
+/* one SymTable_mapParallel call, shared by all of its threads */
+struct SymTableMapping {
+    /* table being mapped */
+    SymTable_T oSymTable;
+    /* function applied to each binding, and its extra argument */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+    /* children of the root, in character order */
+    struct SymTableNode *apsChildren[256];
+    /* one buffer per child for rebuilding keys in, each uBufferSize
+       characters long */
+    char *pcBuffers;
+    size_t uBufferSize;
+};
+
+/* symbol table structure */
+struct SymTable {
+    /* root node, or NULL if the table is empty */
+    struct SymTableNode *psRoot;
+    /* number of bindings */
+    size_t uNumBindings;
+    /* length of the longest key ever put */
+    size_t uMaxLength;
+    /* room for the longest key ever put, for rebuilding keys in when
+       no other buffer can be allocated */
+    char *pcBuffer;
+    /* number of cursors open on the table; while there are any,
+       leaves stay where they are */
+    size_t uNumCursors;
+};
+
+/* Returns the size of the struct of a node of layout ucType. */
+static size_t SymTable_nodeSize(unsigned char ucType) {
+    switch (ucType) {
+    case NODE_4:
+        return sizeof(struct SymTableNode4);
+    case NODE_16:
+        return sizeof(struct SymTableNode16);
+    case NODE_48:
+        return sizeof(struct SymTableNode48);
+    case NODE_256:
+        return sizeof(struct SymTableNode256);
+    default:
+        return sizeof(struct SymTableLeaf);
+    }
+}
+
+/* Returns the most children an inner node of layout ucType holds. */
+static size_t SymTable_capacity(unsigned char ucType) {
+    switch (ucType) {
+    case NODE_4:
+        return 4;
+    case NODE_16:
+        return 16;
+    case NODE_48:
+        return 48;
+    default:
+        return 256;
+    }
+}
+
+/* Returns the prefix of inner node psNode. */
+static char *SymTable_prefix(struct SymTableNode *psNode) {
+    return (char *)psNode + SymTable_nodeSize(psNode->ucType);
+}
+
+/*
+ * Returns the number of suffix characters a leaf at position uDepth
+ * stores for a key of uLength characters. A leaf hanging under the
+ * '\0' that ends its key is one past the end and stores none.
+ */
+static size_t SymTable_suffixLength(size_t uLength, size_t uDepth) {
+    return uDepth < uLength ? uLength - uDepth : 0;
+}
+
+/*
+ * Returns character uIndex of the key of psLeaf, which must be at
+ * least the leaf's depth, and '\0' at or past the key's end.
+ */
+static unsigned char SymTable_leafByte(
+    const struct SymTableLeaf *psLeaf, size_t uIndex) {
+    if (uIndex >= psLeaf->sNode.uLength)
+        return '\0';
+    if (psLeaf->oKey != NULL)
+        return (unsigned char)psLeaf->oKey->acKey[uIndex];
+    return (unsigned char)
+        psLeaf->acSuffix[uIndex - psLeaf->sNode.uDepth];
+}
+
+/*
+ * Returns character uIndex of the key made of the uLength characters
+ * at pcKey, or '\0' at or past its end.
+ */
+static unsigned char SymTable_keyByte(const char *pcKey, size_t uLength,
+    size_t uIndex) {
+    return uIndex < uLength ? (unsigned char)pcKey[uIndex] : '\0';
+}
+
+/*
+ * Returns the address of the slot of inner node psNode holding its
+ * child under character ucByte, or NULL if there is none.
+ */
+static struct SymTableNode **SymTable_findChild(
+    struct SymTableNode *psNode, unsigned char ucByte) {
+    struct SymTableNode4 *psNode4;
+    struct SymTableNode16 *psNode16;
+    struct SymTableNode48 *psNode48;
+    size_t i;
+
+    switch (psNode->ucType) {
+    case NODE_4:
+        psNode4 = (struct SymTableNode4 *)psNode;
+        for (i = 0; i < psNode->usNumChildren; i++) {
+            if (psNode4->aucBytes[i] == ucByte)
+                return &psNode4->apsChildren[i];
+        }
+        return NULL;
+    case NODE_16:
+        psNode16 = (struct SymTableNode16 *)psNode;
+        for (i = 0; i < psNode->usNumChildren; i++) {
+            if (psNode16->aucBytes[i] >= ucByte) {
+                if (psNode16->aucBytes[i] == ucByte)
+                    return &psNode16->apsChildren[i];
+                return NULL;
+            }
+        }
+        return NULL;
+    case NODE_48:
+        psNode48 = (struct SymTableNode48 *)psNode;
+        if (psNode48->aucSlots[ucByte] == 0)
+            return NULL;
+        return &psNode48->apsChildren[psNode48->aucSlots[ucByte] - 1];
+    default:
+        if (((struct SymTableNode256 *)psNode)->apsChildren[ucByte]
+            == NULL)
+            return NULL;
+        return &((struct SymTableNode256 *)psNode)->apsChildren[ucByte];
+    }
+}
+
+/*
+ * Returns the child of inner node psNode under the smallest
+ * character greater than iByte, or NULL if there is none. iByte -1
+ * gives the first child.
+ */
+static struct SymTableNode *SymTable_childAfter(
+    const struct SymTableNode *psNode, int iByte) {
+    const struct SymTableNode4 *psNode4;
+    const struct SymTableNode16 *psNode16;
+    const struct SymTableNode48 *psNode48;
+    const struct SymTableNode256 *psNode256;
+    size_t i;
+
+    switch (psNode->ucType) {
+    case NODE_4:
+        psNode4 = (const struct SymTableNode4 *)psNode;
+        for (i = 0; i < psNode->usNumChildren; i++) {
+            if ((int)psNode4->aucBytes[i] > iByte)
+                return psNode4->apsChildren[i];
+        }
+        return NULL;
+    case NODE_16:
+        psNode16 = (const struct SymTableNode16 *)psNode;
+        for (i = 0; i < psNode->usNumChildren; i++) {
+            if ((int)psNode16->aucBytes[i] > iByte)
+                return psNode16->apsChildren[i];
+        }
+        return NULL;
+    case NODE_48:
+        psNode48 = (const struct SymTableNode48 *)psNode;
+        for (i = (size_t)(iByte + 1); i < 256; i++) {
+            if (psNode48->aucSlots[i] != 0)
+                return psNode48->apsChildren[psNode48->aucSlots[i] - 1];
+        }
+        return NULL;
+    default:
+        psNode256 = (const struct SymTableNode256 *)psNode;
+        for (i = (size_t)(iByte + 1); i < 256; i++) {
+            if (psNode256->apsChildren[i] != NULL)
+                return psNode256->apsChildren[i];
+        }
+        return NULL;
+    }
+}
+
+/*
+ * Adds psChild to inner node psNode, which must have room for it and
+ * no child under its character yet, and makes psNode its parent.
+ */
+static void SymTable_addChild(struct SymTableNode *psNode,
+    struct SymTableNode *psChild) {
+    struct SymTableNode4 *psNode4;
+    struct SymTableNode16 *psNode16;
+    struct SymTableNode48 *psNode48;
+    unsigned char *pucBytes;
+    struct SymTableNode **ppsChildren;
+    unsigned char ucByte = psChild->ucByte;
+    size_t uNumChildren = psNode->usNumChildren;
+    size_t i;
+
+    assert(uNumChildren < SymTable_capacity(psNode->ucType));
+
+    switch (psNode->ucType) {
+    case NODE_4:
+    case NODE_16:
+        if (psNode->ucType == NODE_4) {
+            psNode4 = (struct SymTableNode4 *)psNode;
+            pucBytes = psNode4->aucBytes;
+            ppsChildren = psNode4->apsChildren;
+        }
+        else {
+            psNode16 = (struct SymTableNode16 *)psNode;
+            pucBytes = psNode16->aucBytes;
+            ppsChildren = psNode16->apsChildren;
+        }
+        /* keep the characters sorted */
+        for (i = uNumChildren; i > 0 && pucBytes[i - 1] > ucByte; i--) {
+            pucBytes[i] = pucBytes[i - 1];
+            ppsChildren[i] = ppsChildren[i - 1];
+        }
+        pucBytes[i] = ucByte;
+        ppsChildren[i] = psChild;
+        break;
+    case NODE_48:
+        psNode48 = (struct SymTableNode48 *)psNode;
+        /* removals leave free slots anywhere */
+        for (i = 0; psNode48->apsChildren[i] != NULL; i++)
+            ;
+        psNode48->apsChildren[i] = psChild;
+        psNode48->aucSlots[ucByte] = (unsigned char)(i + 1);
+        break;
+    default:
+        ((struct SymTableNode256 *)psNode)->apsChildren[ucByte] =
+            psChild;
+        break;
+    }
+    psNode->usNumChildren++;
+    psChild->psParent = psNode;
+}
+
+/*
+ * Removes the child under character ucByte from inner node psNode,
+ * which must have one.
+ */
+static void SymTable_removeChild(struct SymTableNode *psNode,
+    unsigned char ucByte) {
+    struct SymTableNode4 *psNode4;
+    struct SymTableNode16 *psNode16;
+    struct SymTableNode48 *psNode48;
+    unsigned char *pucBytes;
+    struct SymTableNode **ppsChildren;
+    size_t uNumChildren = psNode->usNumChildren;
+    size_t i;
+
+    switch (psNode->ucType) {
+    case NODE_4:
+    case NODE_16:
+        if (psNode->ucType == NODE_4) {
+            psNode4 = (struct SymTableNode4 *)psNode;
+            pucBytes = psNode4->aucBytes;
+            ppsChildren = psNode4->apsChildren;
+        }
+        else {
+            psNode16 = (struct SymTableNode16 *)psNode;
+            pucBytes = psNode16->aucBytes;
+            ppsChildren = psNode16->apsChildren;
+        }
+        for (i = 0; pucBytes[i] != ucByte; i++)
+            assert(i + 1 < uNumChildren);
+        memmove(&pucBytes[i], &pucBytes[i + 1], uNumChildren - i - 1);
+        memmove(&ppsChildren[i], &ppsChildren[i + 1],
+                (uNumChildren - i - 1) * sizeof(struct SymTableNode *));
+        break;
+    case NODE_48:
+        psNode48 = (struct SymTableNode48 *)psNode;
+        assert(psNode48->aucSlots[ucByte] != 0);
+        psNode48->apsChildren[psNode48->aucSlots[ucByte] - 1] = NULL;
+        psNode48->aucSlots[ucByte] = 0;
+        break;
+    default:
+        ((struct SymTableNode256 *)psNode)->apsChildren[ucByte] = NULL;
+        break;
+    }
+    psNode->usNumChildren--;
+}
+
+/*
+ * Returns a new inner node of layout ucType without children, at
+ * position uDepth, with room for a prefix of uLength characters,
+ * which are copied from pcPrefix unless it is NULL. Returns NULL if
+ * memory allocation fails.
+ */
+static struct SymTableNode *SymTable_newInner(unsigned char ucType,
+    size_t uDepth, const char *pcPrefix, size_t uLength) {
+    struct SymTableNode *psNode;
+    size_t uSize = SymTable_nodeSize(ucType);
+
+    if (uLength > ((size_t)-1) - uSize)
+        return NULL;
+    psNode = malloc(uSize + uLength);
+    if (psNode == NULL)
+        return NULL;
+    /* also empties the slots of the larger layouts */
+    memset(psNode, 0, uSize);
+    psNode->ucType = ucType;
+    psNode->uDepth = uDepth;
+    psNode->uLength = uLength;
+    if (pcPrefix != NULL)
+        memcpy(SymTable_prefix(psNode), pcPrefix, uLength);
+    return psNode;
+}
+
+/*
+ * Returns a new leaf binding the key made of the uLength characters
+ * at pcKey to pvValue, at position uDepth under character ucByte.
+ * If oKey is not NULL, pcKey is its string and the leaf refers to
+ * the handle instead of copying the characters. Returns NULL if
+ * memory allocation fails.
+ */
+static struct SymTableLeaf *SymTable_newLeaf(const char *pcKey,
+    size_t uLength, SymTableKey_T oKey, const void *pvValue,
+    size_t uDepth, unsigned char ucByte) {
+    struct SymTableLeaf *psLeaf;
+    size_t uSuffixLength = 0;
+
+    if (oKey == NULL)
+        uSuffixLength = SymTable_suffixLength(uLength, uDepth);
+    psLeaf = malloc(sizeof(struct SymTableLeaf) + uSuffixLength);
+    if (psLeaf == NULL)
+        return NULL;
+    psLeaf->sNode.ucType = NODE_LEAF;
+    psLeaf->sNode.ucByte = ucByte;
+    psLeaf->sNode.usNumChildren = 0;
+    psLeaf->sNode.psParent = NULL;
+    psLeaf->sNode.uDepth = uDepth;
+    psLeaf->sNode.uLength = uLength;
+    psLeaf->pvValue = (void *)pvValue;
+    psLeaf->oKey = oKey;
+    memcpy(psLeaf->acSuffix, pcKey + uDepth, uSuffixLength);
+    return psLeaf;
+}
+
+/*
+ * Makes psNew, which is not in the tree, take the place of psOld in
+ * oSymTable: the slot of psOld's parent or the root now holds
+ * psNew, which hangs under psOld's character.
+ */
+static void SymTable_replaceNode(SymTable_T oSymTable,
+    struct SymTableNode *psOld, struct SymTableNode *psNew) {
+    psNew->psParent = psOld->psParent;
+    psNew->ucByte = psOld->ucByte;
+    if (psOld->psParent == NULL)
+        oSymTable->psRoot = psNew;
+    else
+        *SymTable_findChild(psOld->psParent, psOld->ucByte) = psNew;
+}
+
+/*
+ * Returns a copy of inner node psNode in layout ucType, which must
+ * have room for all of its children, with the same prefix and
+ * children, or NULL if memory allocation fails. The copy is not in
+ * the tree yet, but the children already point to it.
+ */
+static struct SymTableNode *SymTable_relayout(
+    struct SymTableNode *psNode, unsigned char ucType) {
+    struct SymTableNode *psNew;
+    struct SymTableNode *psChild;
+
+    psNew = SymTable_newInner(ucType, psNode->uDepth,
+                              SymTable_prefix(psNode), psNode->uLength);
+    if (psNew == NULL)
+        return NULL;
+    for (psChild = SymTable_childAfter(psNode, -1); psChild != NULL;
+         psChild = SymTable_childAfter(psNode, psChild->ucByte))
+        SymTable_addChild(psNew, psChild);
+    return psNew;
+}
+
+/*
+ * Moves inner node psNode of oSymTable into layout ucType and
+ * returns the moved node, which takes psNode's place. Returns NULL
+ * if memory allocation fails, in which case psNode stays as it was.
+ */
+static struct SymTableNode *SymTable_changeLayout(SymTable_T oSymTable,
+    struct SymTableNode *psNode, unsigned char ucType) {
+    struct SymTableNode *psNew;
+
+    psNew = SymTable_relayout(psNode, ucType);
+    if (psNew == NULL)
+        return NULL;
+    SymTable_replaceNode(oSymTable, psNode, psNew);
+    free(psNode);
+    return psNew;
+}
+
+/*
+ * Returns the leftmost leaf of the subtree rooted at psNode, which
+ * holds its smallest key.
+ */
+static struct SymTableLeaf *SymTable_firstLeaf(
+    struct SymTableNode *psNode) {
+    while (psNode->ucType != NODE_LEAF)
+        psNode = SymTable_childAfter(psNode, -1);
+    return (struct SymTableLeaf *)psNode;
+}
+
+/*
+ * Returns the first leaf after the subtree rooted at psNode in key
+ * order, or NULL if there is none. Goes up until an ancestor has a
+ * later child, then down that child's first branches.
+ */
+static struct SymTableLeaf *SymTable_leafAfter(
+    const struct SymTableNode *psNode) {
+    struct SymTableNode *psNext;
+
+    for (; psNode->psParent != NULL; psNode = psNode->psParent) {
+        psNext = SymTable_childAfter(psNode->psParent, psNode->ucByte);
+        if (psNext != NULL)
+            return SymTable_firstLeaf(psNext);
+    }
+    return NULL;
+}
+
+/*
+ * Writes the key of psLeaf, with its '\0', into pcBuffer, which has
+ * room for the longest key of the table, and returns it: the suffix
+ * from the leaf, then the prefix and character of every ancestor
+ * from the leaf up. The key of a leaf put by handle is the handle's
+ * string and is returned as is.
+ */
+static const char *SymTable_leafKey(const struct SymTableLeaf *psLeaf,
+    char *pcBuffer) {
+    const struct SymTableNode *psNode;
+    const struct SymTableNode *psParent;
+    size_t uLength = psLeaf->sNode.uLength;
+    size_t uDepth = psLeaf->sNode.uDepth;
+
+    if (psLeaf->oKey != NULL)
+        return psLeaf->oKey->acKey;
+
+    memcpy(pcBuffer + uDepth, psLeaf->acSuffix,
+           SymTable_suffixLength(uLength, uDepth));
+    pcBuffer[uLength] = '\0';
+    for (psNode = &psLeaf->sNode; psNode->psParent != NULL;
+         psNode = psParent) {
+        psParent = psNode->psParent;
+        /* a leaf under the '\0' ends the key right there */
+        pcBuffer[psParent->uDepth + psParent->uLength] =
+            (char)psNode->ucByte;
+        memcpy(pcBuffer + psParent->uDepth,
+               SymTable_prefix((struct SymTableNode *)psParent),
+               psParent->uLength);
+    }
+    return pcBuffer;
+}
+
+/*
+ * Returns a new buffer with room for any key of oSymTable, for a
+ * walk to rebuild keys in, so that walks may nest. If memory
+ * allocation fails, returns the table's own buffer instead.
+ */
+static char *SymTable_walkBuffer(SymTable_T oSymTable) {
+    char *pcBuffer;
+
+    pcBuffer = malloc(oSymTable->uMaxLength + 1);
+    if (pcBuffer == NULL)
+        return oSymTable->pcBuffer;
+    return pcBuffer;
+}
+
+/* Frees pcBuffer, from SymTable_walkBuffer on oSymTable. */
+static void SymTable_dropBuffer(SymTable_T oSymTable, char *pcBuffer) {
+    if (pcBuffer != oSymTable->pcBuffer)
+        free(pcBuffer);
+}
+
+/*
+ * Returns 1 if psLeaf, at the position uDepth reached by a lookup,
+ * holds the key made of the uLength characters at pcKey, and 0
+ * otherwise. The characters before uDepth matched on the way down.
+ */
+static int SymTable_leafIsKey(const struct SymTableLeaf *psLeaf,
+    const char *pcKey, size_t uLength, size_t uDepth) {
+    if (psLeaf->sNode.uLength != uLength)
+        return 0;
+    if (uDepth >= uLength)
+        return 1;
+    if (psLeaf->oKey != NULL)
+        return memcmp(psLeaf->oKey->acKey + uDepth, pcKey + uDepth,
+                      uLength - uDepth) == 0;
+    return memcmp(psLeaf->acSuffix, pcKey + uDepth, uLength - uDepth)
+           == 0;
+}
+
+/*
+ * Returns the number of characters of the prefix of inner node
+ * psNode that match the key made of the uLength characters at pcKey,
+ * starting at the node's position.
+ */
+static size_t SymTable_prefixMatch(struct SymTableNode *psNode,
+    const char *pcKey, size_t uLength) {
+    const char *pcPrefix = SymTable_prefix(psNode);
+    size_t uDepth = psNode->uDepth;
+    size_t i;
+
+    for (i = 0; i < psNode->uLength; i++) {
+        if (uDepth + i >= uLength || pcKey[uDepth + i] != pcPrefix[i])
+            break;
+    }
+    return i;
+}
+
+/*
+ * Returns the leaf of oSymTable holding the key made of the uLength
+ * characters at pcKey, or NULL if there is none. Each level costs a
+ * comparison of the node's prefix and a search of its few children.
+ */
+static struct SymTableLeaf *SymTable_find(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength) {
+    struct SymTableNode *psNode = oSymTable->psRoot;
+    struct SymTableNode **ppsChild;
+    size_t uDepth;
+
+    while (psNode != NULL && psNode->ucType != NODE_LEAF) {
+        if (SymTable_prefixMatch(psNode, pcKey, uLength)
+            != psNode->uLength)
+            return NULL;
+        uDepth = psNode->uDepth + psNode->uLength;
+        ppsChild = SymTable_findChild(psNode,
+            SymTable_keyByte(pcKey, uLength, uDepth));
+        if (ppsChild == NULL)
+            return NULL;
+        psNode = *ppsChild;
+    }
+    if (psNode == NULL
+        || !SymTable_leafIsKey((struct SymTableLeaf *)psNode, pcKey,
+                               uLength, psNode->uDepth))
+        return NULL;
+    return (struct SymTableLeaf *)psNode;
+}
+
+/*
+ * Merges inner node psNode of oSymTable, which has a single child,
+ * into that child: the child takes the node's place, with the
+ * node's prefix and the child's character put in front of its own
+ * prefix or suffix. Returns the node now in psNode's place, which is
+ * psNode itself if memory allocation fails. A leaf put with a key
+ * string has to move for its longer suffix, so while cursors are
+ * open such a leaf is left where it is.
+ */
+static struct SymTableNode *SymTable_collapse(SymTable_T oSymTable,
+    struct SymTableNode *psNode) {
+    struct SymTableNode *psChild = SymTable_childAfter(psNode, -1);
+    struct SymTableNode *psNew;
+    struct SymTableLeaf *psLeaf;
+    size_t uPrefixLength = psNode->uLength;
+    size_t uJoined;
+
+    assert(psNode->usNumChildren == 1);
+
+    if (psChild->ucType == NODE_LEAF) {
+        psLeaf = (struct SymTableLeaf *)psChild;
+        if (psLeaf->oKey != NULL) {
+            /* only the position changes */
+            psLeaf->sNode.uDepth = psNode->uDepth;
+            psNew = psChild;
+        }
+        else {
+            if (oSymTable->uNumCursors > 0)
+                return psNode;
+            uJoined = SymTable_suffixLength(psChild->uLength,
+                                            psNode->uDepth);
+            psNew = malloc(sizeof(struct SymTableLeaf) + uJoined);
+            if (psNew == NULL)
+                return psNode;
+            memcpy(psNew, psChild, sizeof(struct SymTableLeaf));
+            psNew->uDepth = psNode->uDepth;
+            /* the suffix grows by the prefix and the character, or
+               by the prefix alone under the '\0' */
+            memcpy(((struct SymTableLeaf *)psNew)->acSuffix,
+                   SymTable_prefix(psNode), uPrefixLength);
+            if (uJoined > uPrefixLength) {
+                ((struct SymTableLeaf *)psNew)
+                    ->acSuffix[uPrefixLength] = (char)psChild->ucByte;
+                memcpy(((struct SymTableLeaf *)psNew)->acSuffix
+                       + uPrefixLength + 1, psLeaf->acSuffix,
+                       uJoined - uPrefixLength - 1);
+            }
+            free(psChild);
+        }
+    }
+    else {
+        if (psChild->uLength > ((size_t)-1) - uPrefixLength - 1)
+            return psNode;
+        psNew = SymTable_newInner(psChild->ucType, psNode->uDepth, NULL,
+                                  uPrefixLength + 1 + psChild->uLength);
+        if (psNew == NULL)
+            return psNode;
+        memcpy((char *)psNew + sizeof(struct SymTableNode),
+               (char *)psChild + sizeof(struct SymTableNode),
+               SymTable_nodeSize(psChild->ucType)
+               - sizeof(struct SymTableNode));
+        psNew->usNumChildren = psChild->usNumChildren;
+        memcpy(SymTable_prefix(psNew), SymTable_prefix(psNode),
+               uPrefixLength);
+        SymTable_prefix(psNew)[uPrefixLength] = (char)psChild->ucByte;
+        memcpy(SymTable_prefix(psNew) + uPrefixLength + 1,
+               SymTable_prefix(psChild), psChild->uLength);
+        /* the grandchildren now hang from the merged node */
+        for (psChild = SymTable_childAfter(psNew, -1); psChild != NULL;
+             psChild = SymTable_childAfter(psNew, psChild->ucByte))
+            psChild->psParent = psNew;
+        free(SymTable_childAfter(psNode, -1));
+    }
+
+    SymTable_replaceNode(oSymTable, psNode, psNew);
+    free(psNode);
+    return psNew;
+}
+
+/*
+ * Puts inner node psNode of oSymTable, which just lost a child, back
+ * in shape: a node with no children left is removed from its parent,
+ * which is then put in shape in turn; a node with a single child is
+ * merged into it; and a node with few children moves into a smaller
+ * layout. Memory allocation failures leave nodes as they are, which
+ * costs room but not correctness.
+ */
+static void SymTable_tidy(SymTable_T oSymTable,
+    struct SymTableNode *psNode) {
+    struct SymTableNode *psParent;
+    size_t uNumChildren;
+
+    for (;;) {
+        uNumChildren = psNode->usNumChildren;
+        if (uNumChildren == 0) {
+            psParent = psNode->psParent;
+            if (psParent == NULL)
+                oSymTable->psRoot = NULL;
+            else
+                SymTable_removeChild(psParent, psNode->ucByte);
+            free(psNode);
+            if (psParent == NULL)
+                return;
+            psNode = psParent;
+            continue;
+        }
+        /* a merged node has the shape of the child it was */
+        if (uNumChildren == 1
+            && SymTable_collapse(oSymTable, psNode) != psNode)
+            return;
+        if (psNode->ucType == NODE_16 && uNumChildren <= SHRINK_TO_4)
+            (void)SymTable_changeLayout(oSymTable, psNode, NODE_4);
+        else if (psNode->ucType == NODE_48
+                 && uNumChildren <= SHRINK_TO_16)
+            (void)SymTable_changeLayout(oSymTable, psNode, NODE_16);
+        else if (psNode->ucType == NODE_256
+                 && uNumChildren <= SHRINK_TO_48)
+            (void)SymTable_changeLayout(oSymTable, psNode, NODE_48);
+        return;
+    }
+}
+
+/*
+ * Makes room in the buffer of oSymTable for a key of uLength
+ * characters. Returns 1 if successful, and 0 if memory allocation
+ * fails.
+ */
+static int SymTable_fitBuffer(SymTable_T oSymTable, size_t uLength) {
+    char *pcBuffer;
+
+    if (uLength <= oSymTable->uMaxLength)
+        return 1;
+    if (uLength == (size_t)-1)
+        return 0;
+    pcBuffer = realloc(oSymTable->pcBuffer, uLength + 1);
+    if (pcBuffer == NULL)
+        return 0;
+    oSymTable->pcBuffer = pcBuffer;
+    oSymTable->uMaxLength = uLength;
+    return 1;
+}
+
+/*
+ * Helper function that returns the leaf of oSymTable holding the
+ * key made of the uLength characters at pcKey, adding a binding of
+ * the key and pvValue first if the key doesn't exist in oSymTable.
+ * If oKey is not NULL, pcKey is its string and a new leaf refers to
+ * the handle. Sets *piCreated to 1 if the binding was added and 0
+ * otherwise. Where the key leaves the tree, a new leaf is hung from
+ * the node it left at; where it parts from a leaf or from a node's
+ * prefix, a new node with the shared characters as its prefix takes
+ * the place of the leaf or node, which keeps only what follows. All
+ * memory is allocated before the tree changes, so returns NULL if
+ * memory allocation fails, with oSymTable as it was.
+ */
+static struct SymTableLeaf *SymTable_findOrAddKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey,
+    const void *pvValue, int *piCreated) {
+    struct SymTableNode *psNode = oSymTable->psRoot;
+    struct SymTableNode **ppsChild;
+    struct SymTableNode *psSplit;
+    struct SymTableNode *psGrown;
+    struct SymTableLeaf *psLeaf;
+    struct SymTableLeaf *psOld;
+    unsigned char ucByte;
+    size_t uDepth;
+    size_t uMatch = 0;
+
+    *piCreated = 0;
+    while (psNode != NULL && psNode->ucType != NODE_LEAF) {
+        uMatch = SymTable_prefixMatch(psNode, pcKey, uLength);
+        if (uMatch < psNode->uLength)
+            break;
+        uDepth = psNode->uDepth + psNode->uLength;
+        ppsChild = SymTable_findChild(psNode,
+            SymTable_keyByte(pcKey, uLength, uDepth));
+        if (ppsChild == NULL)
+            break;
+        psNode = *ppsChild;
+    }
+    if (psNode != NULL && psNode->ucType == NODE_LEAF
+        && SymTable_leafIsKey((struct SymTableLeaf *)psNode, pcKey,
+                              uLength, psNode->uDepth))
+        return (struct SymTableLeaf *)psNode;
+
+    if (!SymTable_fitBuffer(oSymTable, uLength))
+        return NULL;
+
+    if (psNode == NULL) {
+        /* the first binding */
+        psLeaf = SymTable_newLeaf(pcKey, uLength, oKey, pvValue, 0, 0);
+        if (psLeaf == NULL)
+            return NULL;
+        oSymTable->psRoot = &psLeaf->sNode;
+    }
+    else if (psNode->ucType == NODE_LEAF) {
+        /* the keys part at the first character they differ in */
+        psOld = (struct SymTableLeaf *)psNode;
+        for (uDepth = psNode->uDepth;
+             SymTable_leafByte(psOld, uDepth)
+             == SymTable_keyByte(pcKey, uLength, uDepth); uDepth++)
+            ;
+        ucByte = SymTable_keyByte(pcKey, uLength, uDepth);
+        psSplit = SymTable_newInner(NODE_4, psNode->uDepth,
+                                    pcKey + psNode->uDepth,
+                                    uDepth - psNode->uDepth);
+        psLeaf = SymTable_newLeaf(pcKey, uLength, oKey, pvValue,
+                                  uDepth + 1, ucByte);
+        if (psSplit == NULL || psLeaf == NULL) {
+            free(psSplit);
+            free(psLeaf);
+            return NULL;
+        }
+        SymTable_replaceNode(oSymTable, psNode, psSplit);
+        psNode->ucByte = SymTable_leafByte(psOld, uDepth);
+        if (psOld->oKey == NULL)
+            memmove(psOld->acSuffix,
+                    psOld->acSuffix + (uDepth + 1 - psNode->uDepth),
+                    SymTable_suffixLength(psNode->uLength, uDepth + 1));
+        psNode->uDepth = uDepth + 1;
+        SymTable_addChild(psSplit, psNode);
+        SymTable_addChild(psSplit, &psLeaf->sNode);
+    }
+    else if (uMatch < psNode->uLength) {
+        /* the key parts from the node's prefix */
+        uDepth = psNode->uDepth + uMatch;
+        ucByte = SymTable_keyByte(pcKey, uLength, uDepth);
+        psSplit = SymTable_newInner(NODE_4, psNode->uDepth,
+                                    SymTable_prefix(psNode), uMatch);
+        psLeaf = SymTable_newLeaf(pcKey, uLength, oKey, pvValue,
+                                  uDepth + 1, ucByte);
+        if (psSplit == NULL || psLeaf == NULL) {
+            free(psSplit);
+            free(psLeaf);
+            return NULL;
+        }
+        SymTable_replaceNode(oSymTable, psNode, psSplit);
+        psNode->ucByte = (unsigned char)SymTable_prefix(psNode)[uMatch];
+        memmove(SymTable_prefix(psNode),
+                SymTable_prefix(psNode) + uMatch + 1,
+                psNode->uLength - uMatch - 1);
+        psNode->uLength -= uMatch + 1;
+        psNode->uDepth = uDepth + 1;
+        SymTable_addChild(psSplit, psNode);
+        SymTable_addChild(psSplit, &psLeaf->sNode);
+    }
+    else {
+        /* the key leaves the tree below psNode */
+        uDepth = psNode->uDepth + psNode->uLength;
+        psLeaf = SymTable_newLeaf(pcKey, uLength, oKey, pvValue,
+                                  uDepth + 1,
+                                  SymTable_keyByte(pcKey, uLength,
+                                                   uDepth));
+        if (psLeaf == NULL)
+            return NULL;
+        if (psNode->usNumChildren
+            == SymTable_capacity(psNode->ucType)) {
+            psGrown = SymTable_changeLayout(oSymTable, psNode,
+                (unsigned char)(psNode->ucType + 1));
+            if (psGrown == NULL) {
+                free(psLeaf);
+                return NULL;
+            }
+            psNode = psGrown;
+        }
+        SymTable_addChild(psNode, &psLeaf->sNode);
+    }
+
+    oSymTable->uNumBindings++;
+    *piCreated = 1;
+    return psLeaf;
+}
+
+/*
+ * Helper function that removes the binding of the key made of the
+ * uLength characters at pcKey from oSymTable, then puts the leaf's
+ * parent back in shape. Returns the value of the removed binding,
+ * or NULL if the key doesn't exist in oSymTable.
+ */
+static void *SymTable_removeKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength) {
+    struct SymTableLeaf *psLeaf;
+    struct SymTableNode *psParent;
+    void *pvValue;
+
+    psLeaf = SymTable_find(oSymTable, pcKey, uLength);
+    if (psLeaf == NULL)
+        return NULL;
+
+    pvValue = psLeaf->pvValue;
+    psParent = psLeaf->sNode.psParent;
+    if (psParent == NULL)
+        oSymTable->psRoot = NULL;
+    else
+        SymTable_removeChild(psParent, psLeaf->sNode.ucByte);
+    free(psLeaf);
+    oSymTable->uNumBindings--;
+    if (psParent != NULL)
+        SymTable_tidy(oSymTable, psParent);
+    return pvValue;
+}
+
+/*
+ * Returns the first leaf of oSymTable whose key is at least the key
+ * made of the uLength characters at pcKey, or NULL if there is
+ * none. Characters compare as unsigned char, as in strcmp, and the
+ * '\0' after each key is smaller than any other character, so the
+ * first child, prefix or leaf character that differs from the key
+ * decides on the way down whether the answer lies in that subtree or
+ * after it.
+ */
+static struct SymTableLeaf *SymTable_lowerBound(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength) {
+    struct SymTableNode *psNode = oSymTable->psRoot;
+    struct SymTableNode **ppsChild;
+    struct SymTableNode *psNext;
+    struct SymTableLeaf *psLeaf;
+    const unsigned char *pucPrefix;
+    unsigned char ucKey;
+    unsigned char ucStored;
+    size_t uDepth;
+    size_t i;
+
+    if (psNode == NULL)
+        return NULL;
+
+    while (psNode->ucType != NODE_LEAF) {
+        pucPrefix = (const unsigned char *)SymTable_prefix(psNode);
+        for (i = 0; i < psNode->uLength; i++) {
+            ucKey = SymTable_keyByte(pcKey, uLength,
+                                     psNode->uDepth + i);
+            if (pucPrefix[i] > ucKey)
+                return SymTable_firstLeaf(psNode);
+            if (pucPrefix[i] < ucKey)
+                return SymTable_leafAfter(psNode);
+        }
+        ucKey = SymTable_keyByte(pcKey, uLength,
+                                 psNode->uDepth + psNode->uLength);
+        ppsChild = SymTable_findChild(psNode, ucKey);
+        if (ppsChild == NULL) {
+            psNext = SymTable_childAfter(psNode, ucKey);
+            if (psNext == NULL)
+                return SymTable_leafAfter(psNode);
+            return SymTable_firstLeaf(psNext);
+        }
+        psNode = *ppsChild;
+    }
+
+    psLeaf = (struct SymTableLeaf *)psNode;
+    for (uDepth = psNode->uDepth;; uDepth++) {
+        ucStored = SymTable_leafByte(psLeaf, uDepth);
+        ucKey = SymTable_keyByte(pcKey, uLength, uDepth);
+        if (ucStored != ucKey)
+            return ucStored > ucKey ? psLeaf
+                                    : SymTable_leafAfter(psNode);
+        if (ucStored == '\0')
+            return psLeaf;
+    }
+}
+
+/*
+ * Frees the nodes of the subtree rooted at psNode, and psNode
+ * itself, deepest first, without a stack: each node freed is taken
+ * off its parent, which is freed in turn once it has no children
+ * left.
+ */
+static void SymTable_freeTree(struct SymTableNode *psNode) {
+    struct SymTableNode *psParent;
+    struct SymTableNode *psTop;
+
+    if (psNode == NULL)
+        return;
+    psTop = psNode->psParent;
+    while (psNode != psTop) {
+        if (psNode->ucType != NODE_LEAF && psNode->usNumChildren > 0) {
+            psNode = SymTable_childAfter(psNode, -1);
+            continue;
+        }
+        psParent = psNode->psParent;
+        if (psParent != psTop)
+            SymTable_removeChild(psParent, psNode->ucByte);
+        free(psNode);
+        psNode = psParent;
+    }
+}
+
+/* creates a empty SymTable, allocates memory for it,
+   and returns it. returns NULL if memory allocation fails */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+    oSymTable->pcBuffer = malloc(1);
+    if (oSymTable->pcBuffer == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->psRoot = NULL;
+    oSymTable->uNumBindings = 0;
+    oSymTable->uMaxLength = 0;
+    oSymTable->uNumCursors = 0;
+    return oSymTable;
+}
+
+/* creates a empty SymTable like SymTable_new. a radix tree follows
+   the characters of its keys instead of hashing them, so pfHash is
+   accepted and ignored */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    assert(pfHash != NULL);
+    return SymTable_new();
+}
+
+/* creates a empty SymTable like SymTable_new. a radix tree grows
+   one node at a time, so uCapacity is accepted and ignored */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    (void)uCapacity;
+    return SymTable_new();
+}
+
+/* a radix tree has no room to make in advance, so this does nothing
+   and returns 1 */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    assert(oSymTable != NULL);
+    (void)uCapacity;
+    return 1;
+}
+
+/*
+ * Helper function that puts node psNode of oSymTable in its
+ * smallest shape and returns the node now in its place: an inner
+ * node with a single child is merged into it, and one with room to
+ * spare moves into the smallest layout its children fit in; a leaf
+ * put with a key string gives back the room it kept from before its
+ * suffix was shortened. Returns NULL if memory allocation fails, in
+ * which case psNode is still in the tree with its bindings.
+ */
+static struct SymTableNode *SymTable_compactNode(SymTable_T oSymTable,
+    struct SymTableNode *psNode) {
+    struct SymTableNode *psNew;
+    struct SymTableLeaf *psLeaf;
+    unsigned char ucType;
+
+    while (psNode->ucType != NODE_LEAF && psNode->usNumChildren == 1) {
+        psNew = SymTable_collapse(oSymTable, psNode);
+        if (psNew == psNode)
+            return NULL;
+        psNode = psNew;
+    }
+
+    if (psNode->ucType != NODE_LEAF) {
+        for (ucType = NODE_4;
+             psNode->usNumChildren > SymTable_capacity(ucType);
+             ucType++)
+            ;
+        if (ucType < psNode->ucType)
+            psNode = SymTable_changeLayout(oSymTable, psNode, ucType);
+        return psNode;
+    }
+
+    psLeaf = (struct SymTableLeaf *)psNode;
+    if (psLeaf->oKey != NULL)
+        return psNode;
+    psNew = realloc(psNode, sizeof(struct SymTableLeaf)
+        + SymTable_suffixLength(psNode->uLength, psNode->uDepth));
+    if (psNew == NULL)
+        return NULL;
+    if (psNew->psParent == NULL)
+        oSymTable->psRoot = psNew;
+    else
+        *SymTable_findChild(psNew->psParent, psNew->ucByte) = psNew;
+    return psNew;
+}
+
+/*
+ * Puts every node of oSymTable in its smallest shape, from the root
+ * down: inner nodes left with a single child by removals made while
+ * cursors were open are merged into it, inner nodes move into the
+ * smallest layout their children fit in, and leaves whose suffix
+ * was shortened give back the room left over. Each node is changed
+ * on its own, so if memory allocation fails, the nodes before it
+ * stay compacted and the rest as they were, and 0 is returned; the
+ * bindings of oSymTable are unchanged either way. Returns 1 if
+ * successful.
+ */
+int SymTable_compact(SymTable_T oSymTable) {
+    struct SymTableNode *psNode;
+    struct SymTableNode *psNext;
+
+    assert(oSymTable != NULL);
+
+    psNode = oSymTable->psRoot;
+    while (psNode != NULL) {
+        psNode = SymTable_compactNode(oSymTable, psNode);
+        if (psNode == NULL)
+            return 0;
+        /* the first child, or else the next child of the nearest
+           ancestor that has one */
+        psNext = NULL;
+        if (psNode->ucType != NODE_LEAF)
+            psNext = SymTable_childAfter(psNode, -1);
+        for (; psNext == NULL && psNode->psParent != NULL;
+             psNode = psNode->psParent)
+            psNext = SymTable_childAfter(psNode->psParent,
+                                         psNode->ucByte);
+        psNode = psNext;
+    }
+    return 1;
+}
+
+/* a radix tree places each key by its characters, so iPolicy is
+   accepted and ignored */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    (void)iPolicy;
+}
+
+/* a miss in a radix tree mostly ends at the first byte no key
+   shares, without comparing whole keys, so iEnable is accepted and
+   ignored */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+    (void)iEnable;
+    return 1;
+}
+
+/* frees memory needed for the SymTable */
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    SymTable_freeTree(oSymTable->psRoot);
+    free(oSymTable->pcBuffer);
+    free(oSymTable);
+}
+
+/* returns number of bindings in the symbol table (oSymTable) */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->uNumBindings;
+}
+
+/*
+ * Helper function that adds a binding of the key made of the
+ * uLength characters at pcKey, and pvValue, to oSymTable if the key
+ * doesn't exist in oSymTable. If oKey is not NULL, pcKey is its
+ * string. Returns 1 if the binding was added, and 0 if memory
+ * allocation fails or the key already exists.
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, SymTableKey_T oKey, const void *pvValue) {
+    int iCreated;
+
+    if (SymTable_findOrAddKey(oSymTable, pcKey, uLength, oKey, pvValue,
+                              &iCreated) == NULL)
+        return 0;
+    return iCreated;
+}
+
+/*
+ * adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable. the leaf copies only
+ * the characters no other key shares.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_putKey(oSymTable, pcKey, strlen(pcKey), NULL,
+                           pvValue);
+}
+
+/*
+ * adds new binding of interned key oKey, pvValue to oSymTable if
+ * the key doesn't exist in oSymTable. the leaf refers to the
+ * handle's string instead of copying any of it.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength, oKey,
+                           pvValue);
+}
+
+/*
+ * Helper function that returns the address of the value of the key
+ * made of the uLength characters at pcKey in oSymTable, or NULL if
+ * the key doesn't exist in oSymTable.
+ */
+static void **SymTable_findValue(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength) {
+    struct SymTableLeaf *psLeaf;
+
+    psLeaf = SymTable_find(oSymTable, pcKey, uLength);
+    if (psLeaf == NULL)
+        return NULL;
+    return &psLeaf->pvValue;
+}
+
+/*
+ * Helper function that replaces the value at ppvValue with pvValue
+ * and returns the old value. Returns NULL if ppvValue is NULL.
+ */
+static void *SymTable_replaceValue(void **ppvValue,
+    const void *pvValue) {
+    void *pvOldValue;
+
+    if (ppvValue == NULL)
+        return NULL;
+    pvOldValue = *ppvValue;
+    *ppvValue = (void *)pvValue;
+    return pvOldValue;
+}
+
+/*
+ * replace old value (pvOldValue) of key pcKey in oSymTable
+ * with new value pvValue and returns pvOldValue.
+ * if the given pcKey doesn't exist within oSymTable,
+ * returns NULL
+ */
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_replaceValue(
+        SymTable_findValue(oSymTable, pcKey, strlen(pcKey)), pvValue);
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_replaceValue(
+        SymTable_findValue(oSymTable, oKey->acKey, oKey->uLength),
+        pvValue);
+}
+
+/*
+ * Returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. Sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. The address is the value's
+ * place in its leaf, which stays put until bindings are removed or
+ * the table is compacted. Returns NULL if memory allocation fails.
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    struct SymTableLeaf *psLeaf;
+    int iCreated;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_findOrAddKey(oSymTable, pcKey, strlen(pcKey),
+                                   NULL, pvValue, &iCreated);
+    if (psLeaf == NULL)
+        return NULL;
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &psLeaf->pvValue;
+}
+
+/*
+ * checks if given key pcKey exists within oSymTable.
+ * returns 1 if pcKey exists, if else returns 0
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_findValue(oSymTable, pcKey, strlen(pcKey)) != NULL;
+}
+
+/*
+ * checks if interned key oKey exists within oSymTable.
+ * returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    return SymTable_findValue(oSymTable, oKey->acKey, oKey->uLength)
+           != NULL;
+}
+
+/*
+ * returns value associated with key pcKey if it exists
+ * within oSymTable, returns NULL if can't find given pcKey
+ * in oSymTable
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    void **ppvValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    ppvValue = SymTable_findValue(oSymTable, pcKey, strlen(pcKey));
+    if (ppvValue == NULL)
+        return NULL;
+    return *ppvValue;
+}
+
+/*
+ * returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
+ */
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
+    void **ppvValue;
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    ppvValue = SymTable_findValue(oSymTable, oKey->acKey,
+                                  oKey->uLength);
+    if (ppvValue == NULL)
+        return NULL;
+    return *ppvValue;
+}
+
+/*
+ * Stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. Every lookup descends from the same root, whose
+ * upper levels stay cached from one key to the next, so the keys
+ * are simply looked up in turn.
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    size_t i;
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+    for (i = 0; i < uNumKeys; i++)
+        apvValues[i] = SymTable_get(oSymTable, apcKeys[i]);
+}
+
+/*
+ * removes binding associated with given pcKey from the
+ * symbol table (oSymTable) and frees memory.
+ * return value associated with removed key if key existed
+ * in oSymTable. return NULL otherwise.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeKey(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*
+ * removes binding associated with interned key oKey from
+ * oSymTable and frees memory. return value associated with
+ * removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    return SymTable_removeKey(oSymTable, oKey->acKey, oKey->uLength);
+}
+
+/*
+ * adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. the characters no other key shares are copied.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_putKey(oSymTable, pcKey, uLength, NULL, pvValue);
+}
+
+/*
+ * checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable. returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_findValue(oSymTable, pcKey, uLength) != NULL;
+}
+
+/*
+ * returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    void **ppvValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    ppvValue = SymTable_findValue(oSymTable, pcKey, uLength);
+    if (ppvValue == NULL)
+        return NULL;
+    return *ppvValue;
+}
+
+/*
+ * removes binding of the key made of the uLength characters at
+ * pcKey from oSymTable and frees memory. return value associated
+ * with removed key if it existed in oSymTable. return NULL
+ * otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeKey(oSymTable, pcKey, uLength);
+}
+
+/*
+ * Works like SymTable_put. A radix tree does not hash its keys, so
+ * uHash, the code SymTable_hashKey returns for pcKey, is ignored.
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    (void)uHash;
+    return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+/*
+ * Works like SymTable_get; uHash is ignored.
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    (void)uHash;
+    return SymTable_get(oSymTable, pcKey);
+}
+
+/*
+ * Works like SymTable_remove; uHash is ignored.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    (void)uHash;
+    return SymTable_remove(oSymTable, pcKey);
+}
+
+/*
+ * Helper function that applies *pfApply, with pvExtra, to the
+ * bindings of the leaves from psLeaf up to but not including psStop,
+ * in key order, rebuilding their keys in pcBuffer.
+ */
+static void SymTable_mapLeaves(struct SymTableLeaf *psLeaf,
+    const struct SymTableLeaf *psStop, char *pcBuffer,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    for (; psLeaf != psStop;
+         psLeaf = SymTable_leafAfter(&psLeaf->sNode))
+        (*pfApply)(SymTable_leafKey(psLeaf, pcBuffer), psLeaf->pvValue,
+                   (void *)pvExtra);
+}
+
+/*
+ * To each binding in oSymTable, apply function (pfApply) given by
+ * the user, in key order. user is able to input additional
+ * parameter pvExtra if needed for the user defined function. keys
+ * put with a key string are rebuilt in a buffer for the call.
+ */
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    char *pcBuffer;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->psRoot == NULL)
+        return;
+    pcBuffer = SymTable_walkBuffer(oSymTable);
+    SymTable_mapLeaves(SymTable_firstLeaf(oSymTable->psRoot), NULL,
+                       pcBuffer, pfApply, pvExtra);
+    SymTable_dropBuffer(oSymTable, pcBuffer);
+}
+
+/*
+ * Applies the function of mapping pvMapping to the bindings under
+ * the children uFirst to uLimit - 1 of the root of its table, each
+ * child's keys rebuilt in the child's own buffer.
+ */
+static void SymTable_mapChildren(size_t uFirst, size_t uLimit,
+    void *pvMapping) {
+    struct SymTableMapping *psMapping = pvMapping;
+    struct SymTableNode *psChild;
+    size_t i;
+
+    for (i = uFirst; i < uLimit; i++) {
+        psChild = psMapping->apsChildren[i];
+        SymTable_mapLeaves(SymTable_firstLeaf(psChild),
+                           SymTable_leafAfter(psChild),
+                           psMapping->pcBuffers
+                           + i * psMapping->uBufferSize,
+                           psMapping->pfApply, psMapping->pvExtra);
+    }
+}
+
+/*
+ * To each binding in oSymTable, apply function *pfApply with
+ * pvExtra as extra argument, in up to iThreadCount threads at once.
+ * The subtrees under the root are shared out one at a time. A tree
+ * that is a single leaf, or whose buffers for rebuilding keys cannot
+ * be allocated, is mapped by the calling thread.
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    struct SymTableMapping *psMapping;
+    struct SymTableNode *psRoot;
+    struct SymTableNode *psChild;
+    size_t uNumChildren = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    psRoot = oSymTable->psRoot;
+    if (psRoot == NULL || psRoot->ucType == NODE_LEAF
+        || iThreadCount <= 1) {
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+
+    psMapping = malloc(sizeof(struct SymTableMapping));
+    if (psMapping == NULL) {
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+    for (psChild = SymTable_childAfter(psRoot, -1); psChild != NULL;
+         psChild = SymTable_childAfter(psRoot, psChild->ucByte))
+        psMapping->apsChildren[uNumChildren++] = psChild;
+    psMapping->uBufferSize = oSymTable->uMaxLength + 1;
+    psMapping->pcBuffers = NULL;
+    if (psMapping->uBufferSize <= ((size_t)-1) / uNumChildren)
+        psMapping->pcBuffers =
+            malloc(psMapping->uBufferSize * uNumChildren);
+    if (psMapping->pcBuffers == NULL) {
+        free(psMapping);
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+
+    psMapping->oSymTable = oSymTable;
+    psMapping->pfApply = pfApply;
+    psMapping->pvExtra = pvExtra;
+    SymTable_runParallel(uNumChildren, 1, iThreadCount,
+                         SymTable_mapChildren, psMapping);
+    free(psMapping->pcBuffers);
+    free(psMapping);
+}
+
+/*
+ * To each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function *pfApply with pvExtra as extra
+ * argument, in key order. A NULL bound leaves that end open. Both
+ * ends are found with one descent each, and the leaves between them
+ * are read in turn. Returns 1.
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableLeaf *psFirst;
+    struct SymTableLeaf *psStop = NULL;
+    char *pcBuffer;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->psRoot == NULL)
+        return 1;
+    /* an empty range would have its end before its start */
+    if (pcLow != NULL && pcHigh != NULL && strcmp(pcLow, pcHigh) >= 0)
+        return 1;
+
+    psFirst = SymTable_firstLeaf(oSymTable->psRoot);
+    if (pcLow != NULL)
+        psFirst = SymTable_lowerBound(oSymTable, pcLow, strlen(pcLow));
+    if (pcHigh != NULL)
+        psStop = SymTable_lowerBound(oSymTable, pcHigh, strlen(pcHigh));
+
+    pcBuffer = SymTable_walkBuffer(oSymTable);
+    SymTable_mapLeaves(psFirst, psStop, pcBuffer, pfApply, pvExtra);
+    SymTable_dropBuffer(oSymTable, pcBuffer);
+    return 1;
+}
+
+/*
+ * To each binding of oSymTable whose key starts with pcPrefix,
+ * apply function *pfApply with pvExtra as extra argument, in key
+ * order. Those keys are exactly the ones under the node the prefix
+ * ends in, so this descends along the prefix and walks that
+ * subtree. Returns 1.
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableNode *psNode;
+    struct SymTableNode **ppsChild;
+    struct SymTableLeaf *psLeaf;
+    size_t uLength;
+    size_t uMatch;
+    size_t uEnd;
+    char *pcBuffer;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    uLength = strlen(pcPrefix);
+    psNode = oSymTable->psRoot;
+    while (psNode != NULL && psNode->ucType != NODE_LEAF) {
+        uMatch = SymTable_prefixMatch(psNode, pcPrefix, uLength);
+        uEnd = psNode->uDepth + psNode->uLength;
+        if (uEnd >= uLength && psNode->uDepth + uMatch == uLength)
+            break;
+        if (uMatch < psNode->uLength)
+            return 1;
+        ppsChild = SymTable_findChild(psNode,
+                                      (unsigned char)pcPrefix[uEnd]);
+        if (ppsChild == NULL)
+            return 1;
+        psNode = *ppsChild;
+    }
+    if (psNode == NULL)
+        return 1;
+
+    if (psNode->ucType == NODE_LEAF) {
+        psLeaf = (struct SymTableLeaf *)psNode;
+        for (uEnd = psNode->uDepth; uEnd < uLength; uEnd++) {
+            if (SymTable_leafByte(psLeaf, uEnd)
+                != (unsigned char)pcPrefix[uEnd])
+                return 1;
+        }
+    }
+
+    pcBuffer = SymTable_walkBuffer(oSymTable);
+    SymTable_mapLeaves(SymTable_firstLeaf(psNode),
+                       SymTable_leafAfter(psNode), pcBuffer, pfApply,
+                       pvExtra);
+    SymTable_dropBuffer(oSymTable, pcBuffer);
+    return 1;
+}
+
+/*
+ * Opens cursor *psIter over the bindings of oSymTable, which it
+ * returns in key order. The cursor keeps the leaf it returns next
+ * in pvNode and a buffer to rebuild keys in in pvReader. While
+ * cursors are open, removals leave every other leaf where it is.
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    oSymTable->uNumCursors++;
+    psIter->oSymTable = oSymTable;
+    psIter->pvNode = NULL;
+    if (oSymTable->psRoot != NULL)
+        psIter->pvNode = SymTable_firstLeaf(oSymTable->psRoot);
+    psIter->pvArray = NULL;
+    psIter->pvReader = SymTable_walkBuffer(oSymTable);
+    psIter->uIndex = 0;
+    psIter->uCount = 0;
+}
+
+/*
+ * Moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. A key put with a key
+ * string is rebuilt in the cursor's buffer, where it stays until the
+ * next call. Returns 0 once every binding has been returned.
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    struct SymTableLeaf *psLeaf;
+
+    assert(psIter != NULL);
+
+    psLeaf = psIter->pvNode;
+    if (psLeaf == NULL)
+        return 0;
+
+    if (ppcKey != NULL)
+        *ppcKey = SymTable_leafKey(psLeaf, psIter->pvReader);
+    if (ppvValue != NULL)
+        *ppvValue = psLeaf->pvValue;
+
+    /* look ahead, since the caller may remove this binding */
+    psIter->pvNode = SymTable_leafAfter(&psLeaf->sNode);
+    return 1;
+}
+
+/* Closes cursor *psIter and frees its buffer. */
+void SymTable_end(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+    psIter->oSymTable->uNumCursors--;
+    SymTable_dropBuffer(psIter->oSymTable, psIter->pvReader);
+    psIter->pvReader = NULL;
+}
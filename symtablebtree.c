@@ -0,0 +1,1450 @@
+/*
+ * symtablebtree.c
+ *
+ * Symbol table module implementation via a B+ tree ordered by key.
+ * Every binding sits in a leaf, the leaves are linked in key order,
+ * and the inner nodes only route lookups, so a range of keys is
+ * found with one descent and then read leaf after leaf. Each node
+ * keeps the first characters of its keys inline, packed into
+ * integers next to the key pointers, so a search within a node
+ * compares integers in a few cache lines and follows a key pointer
+ * only when two prefixes tie.
+ * functionalities include:
+ * - creating and deleting a symbol table
+ * - adding and removing key-value pairs
+ * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
+ * - applying a user-defined function to each entry
+ * - applying it with several threads at once
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - compacting a table to the size of its bindings
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablekey.h"
+#include "symtablepool.h"
+/* most keys a node holds: a leaf holds that many bindings and an
+   inner node one more child than keys. the prefixes of a full node
+   fill four cache lines */
+#define MAX_KEYS 32
+/* fewest keys a node other than the root holds; a node that falls
+   below borrows a key from a sibling or merges with it */
+#define MIN_KEYS (MAX_KEYS / 2 - 1)
+/* number of characters of a key packed into its prefix */
+#define PREFIX_LENGTH 8
+/* deepest a tree can get, since every inner node but the root has
+   more than MIN_KEYS children */
+#define MAX_HEIGHT 32
+
+/* fields every node starts with */
+struct SymTableNode {
+    /* 1 if the node is a leaf, 0 if it is an inner node */
+    int iLeaf;
+    /* number of keys in the node */
+    size_t uNumKeys;
+    /* first PREFIX_LENGTH characters of each key, the first one in
+       the highest byte and padded with zero bytes, so that prefixes
+       compared as integers order keys as strcmp does */
+    uint64_t auPrefixes[MAX_KEYS];
+    /* key strings, in increasing order. a leaf's are the keys of its
+       bindings; an inner node's are separators, each the smallest
+       key in the subtree after it, and point to that binding's key
+       string instead of copying it */
+    const char *apcKeys[MAX_KEYS];
+};
+
+/* node holding bindings */
+struct SymTableLeaf {
+    /* keys of the bindings */
+    struct SymTableNode sNode;
+    /* values of the bindings, at the positions of their keys */
+    void *apvValues[MAX_KEYS];
+    /* handles the bindings were put with, or NULL for a binding put
+       with a key string, whose key string the leaf owns */
+    SymTableKey_T aoKeys[MAX_KEYS];
+    /* next leaf in key order, or NULL for the last one */
+    struct SymTableLeaf *psNext;
+};
+
+/* node routing lookups to its children */
+struct SymTableInner {
+    /* separators */
+    struct SymTableNode sNode;
+    /* children; the keys under apsChildren[i] are at least separator
+       i - 1 and less than separator i */
+    struct SymTableNode *apsChildren[MAX_KEYS + 1];
+};
+
+/* key looked for, with its prefix packed once */
+struct SymTableTarget {
+    /* characters of the key, not necessarily followed by '\0' */
+    const char *pcKey;
+    /* number of characters at pcKey */
+    size_t uLength;
+    /* packed first PREFIX_LENGTH characters of the key */
+    uint64_t uPrefix;
+};
+
+/* one SymTable_mapParallel call, shared by all of its threads */
+struct SymTableMapping {
+    /* table being mapped */
+    SymTable_T oSymTable;
+    /* function applied to each binding, and its extra argument */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+/* symbol table structure */
+struct SymTable {
+    /* root node, a leaf until the first leaf fills up */
+    struct SymTableNode *psRoot;
+    /* leftmost leaf, where the walks in key order start */
+    struct SymTableLeaf *psFirst;
+    /* number of bindings */
+    size_t uNumBindings;
+    /* changes whenever bindings move between or within leaves, so a
+       cursor can tell that the place it kept is stale */
+    size_t uVersion;
+};
+
+/*
+ * Returns the prefix of the key made of the uLength characters at
+ * pcKey: its first PREFIX_LENGTH characters, packed big-endian and
+ * padded with zero bytes.
+ */
+static uint64_t SymTable_prefix(const char *pcKey, size_t uLength) {
+    uint64_t uPrefix = 0;
+    size_t i;
+
+    for (i = 0; i < PREFIX_LENGTH; i++) {
+        uPrefix <<= 8;
+        if (i < uLength)
+            uPrefix |= (unsigned char)pcKey[i];
+    }
+    return uPrefix;
+}
+
+/*
+ * Sets *psTarget to the key made of the uLength characters at pcKey.
+ */
+static void SymTable_target(struct SymTableTarget *psTarget,
+    const char *pcKey, size_t uLength) {
+    psTarget->pcKey = pcKey;
+    psTarget->uLength = uLength;
+    psTarget->uPrefix = SymTable_prefix(pcKey, uLength);
+}
+
+/*
+ * Compares the key of *psTarget with key uIndex of psNode in the
+ * order of strcmp. Returns a negative number, 0, or a positive
+ * number if the target is less than, equal to, or greater than it.
+ * The characters are only read when the prefixes are equal, and
+ * then from the first one past the prefix.
+ */
+static int SymTable_compare(const struct SymTableTarget *psTarget,
+    const struct SymTableNode *psNode, size_t uIndex) {
+    uint64_t uPrefix = psNode->auPrefixes[uIndex];
+    const char *pcStored;
+    size_t i;
+
+    if (psTarget->uPrefix != uPrefix)
+        return psTarget->uPrefix < uPrefix ? -1 : 1;
+    /* equal prefixes hold the whole of a shorter key, '\0' included */
+    if (psTarget->uLength < PREFIX_LENGTH)
+        return 0;
+
+    pcStored = psNode->apcKeys[uIndex];
+    for (i = PREFIX_LENGTH; i < psTarget->uLength; i++) {
+        if (psTarget->pcKey[i] != pcStored[i])
+            return (unsigned char)psTarget->pcKey[i]
+                   < (unsigned char)pcStored[i] ? -1 : 1;
+    }
+    return pcStored[i] == '\0' ? 0 : -1;
+}
+
+/*
+ * Returns the position of the first key of psNode that is not less
+ * than the key of *psTarget, which is the target's own position if
+ * psNode holds it, or psNode's number of keys if there is none.
+ */
+static size_t SymTable_lowerBound(const struct SymTableNode *psNode,
+    const struct SymTableTarget *psTarget) {
+    size_t uLow = 0;
+    size_t uHigh = psNode->uNumKeys;
+    size_t uMiddle;
+
+    while (uLow < uHigh) {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if (SymTable_compare(psTarget, psNode, uMiddle) > 0)
+            uLow = uMiddle + 1;
+        else
+            uHigh = uMiddle;
+    }
+    return uLow;
+}
+
+/*
+ * Returns the position of the child of inner node psNode whose
+ * subtree holds the key of *psTarget if any does: the number of
+ * separators not greater than the key.
+ */
+static size_t SymTable_childIndex(const struct SymTableNode *psNode,
+    const struct SymTableTarget *psTarget) {
+    size_t uLow = 0;
+    size_t uHigh = psNode->uNumKeys;
+    size_t uMiddle;
+
+    while (uLow < uHigh) {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if (SymTable_compare(psTarget, psNode, uMiddle) >= 0)
+            uLow = uMiddle + 1;
+        else
+            uHigh = uMiddle;
+    }
+    return uLow;
+}
+
+/*
+ * Returns the leaf of oSymTable that holds the key of *psTarget if
+ * oSymTable does, and where it would be added otherwise.
+ */
+static struct SymTableLeaf *SymTable_findLeaf(SymTable_T oSymTable,
+    const struct SymTableTarget *psTarget) {
+    struct SymTableNode *psNode = oSymTable->psRoot;
+
+    while (!psNode->iLeaf)
+        psNode = ((struct SymTableInner *)psNode)
+                 ->apsChildren[SymTable_childIndex(psNode, psTarget)];
+    return (struct SymTableLeaf *)psNode;
+}
+
+/*
+ * Returns the leaf of oSymTable holding the key of *psTarget and
+ * stores the key's position in it at *puIndex, or returns NULL if
+ * the key doesn't exist in oSymTable.
+ */
+static struct SymTableLeaf *SymTable_find(SymTable_T oSymTable,
+    const struct SymTableTarget *psTarget, size_t *puIndex) {
+    struct SymTableLeaf *psLeaf;
+    size_t uIndex;
+
+    psLeaf = SymTable_findLeaf(oSymTable, psTarget);
+    uIndex = SymTable_lowerBound(&psLeaf->sNode, psTarget);
+    if (uIndex == psLeaf->sNode.uNumKeys
+        || SymTable_compare(psTarget, &psLeaf->sNode, uIndex) != 0)
+        return NULL;
+    *puIndex = uIndex;
+    return psLeaf;
+}
+
+/* Returns the leftmost leaf of the subtree rooted at psNode. */
+static struct SymTableLeaf *SymTable_leftmostLeaf(
+    struct SymTableNode *psNode) {
+    while (!psNode->iLeaf)
+        psNode = ((struct SymTableInner *)psNode)->apsChildren[0];
+    return (struct SymTableLeaf *)psNode;
+}
+
+/*
+ * Moves uCount keys with their prefixes from position uFrom of
+ * psFrom to position uTo of psTo. The two may be the same node, and
+ * the ranges may overlap.
+ */
+static void SymTable_moveKeys(struct SymTableNode *psTo, size_t uTo,
+    struct SymTableNode *psFrom, size_t uFrom, size_t uCount) {
+    memmove(&psTo->auPrefixes[uTo], &psFrom->auPrefixes[uFrom],
+            uCount * sizeof(uint64_t));
+    memmove(&psTo->apcKeys[uTo], &psFrom->apcKeys[uFrom],
+            uCount * sizeof(const char *));
+}
+
+/*
+ * Moves uCount bindings from position uFrom of leaf psFrom to
+ * position uTo of leaf psTo, like SymTable_moveKeys.
+ */
+static void SymTable_moveBindings(struct SymTableLeaf *psTo, size_t uTo,
+    struct SymTableLeaf *psFrom, size_t uFrom, size_t uCount) {
+    SymTable_moveKeys(&psTo->sNode, uTo, &psFrom->sNode, uFrom, uCount);
+    memmove(&psTo->apvValues[uTo], &psFrom->apvValues[uFrom],
+            uCount * sizeof(void *));
+    memmove(&psTo->aoKeys[uTo], &psFrom->aoKeys[uFrom],
+            uCount * sizeof(SymTableKey_T));
+}
+
+/*
+ * Moves uCount children from position uFrom of inner node psFrom to
+ * position uTo of inner node psTo, like SymTable_moveKeys.
+ */
+static void SymTable_moveChildren(struct SymTableInner *psTo,
+    size_t uTo, struct SymTableInner *psFrom, size_t uFrom,
+    size_t uCount) {
+    memmove(&psTo->apsChildren[uTo], &psFrom->apsChildren[uFrom],
+            uCount * sizeof(struct SymTableNode *));
+}
+
+/* Returns a new empty leaf, or NULL if memory allocation fails. */
+static struct SymTableLeaf *SymTable_newLeaf(void) {
+    struct SymTableLeaf *psLeaf;
+
+    psLeaf = malloc(sizeof(struct SymTableLeaf));
+    if (psLeaf == NULL)
+        return NULL;
+    psLeaf->sNode.iLeaf = 1;
+    psLeaf->sNode.uNumKeys = 0;
+    psLeaf->psNext = NULL;
+    return psLeaf;
+}
+
+/*
+ * Returns a new inner node without keys or children, or NULL if
+ * memory allocation fails.
+ */
+static struct SymTableInner *SymTable_newInner(void) {
+    struct SymTableInner *psInner;
+
+    psInner = malloc(sizeof(struct SymTableInner));
+    if (psInner == NULL)
+        return NULL;
+    psInner->sNode.iLeaf = 0;
+    psInner->sNode.uNumKeys = 0;
+    return psInner;
+}
+
+/*
+ * Frees the subtree rooted at psNode, along with the key strings its
+ * leaves own if iWithKeys is not 0.
+ */
+static void SymTable_freeTree(struct SymTableNode *psNode,
+    int iWithKeys) {
+    struct SymTableLeaf *psLeaf;
+    struct SymTableInner *psInner;
+    size_t i;
+
+    if (psNode->iLeaf) {
+        psLeaf = (struct SymTableLeaf *)psNode;
+        for (i = 0; iWithKeys && i < psNode->uNumKeys; i++) {
+            if (psLeaf->aoKeys[i] == NULL)
+                free((char *)psNode->apcKeys[i]);
+        }
+    }
+    else {
+        psInner = (struct SymTableInner *)psNode;
+        for (i = 0; i <= psNode->uNumKeys; i++)
+            SymTable_freeTree(psInner->apsChildren[i], iWithKeys);
+    }
+    free(psNode);
+}
+
+/*
+ * Splits the full child uChild of inner node psParent, which is not
+ * full, in two halves, and adds the separator between them to
+ * psParent. The right half of a leaf keeps all of its keys, the
+ * first of them becoming the separator; the middle key of an inner
+ * node moves up. Returns 1 if successful, and 0 if memory allocation
+ * fails, in which case nothing changed.
+ */
+static int SymTable_splitChild(struct SymTableInner *psParent,
+    size_t uChild) {
+    struct SymTableNode *psChild = psParent->apsChildren[uChild];
+    struct SymTableNode *psNew;
+    struct SymTableLeaf *psLeft;
+    struct SymTableLeaf *psRight;
+    struct SymTableInner *psLeftInner;
+    struct SymTableInner *psRightInner;
+    size_t uHalf = MAX_KEYS / 2;
+    size_t uNumKeys = psParent->sNode.uNumKeys;
+
+    assert(psChild->uNumKeys == MAX_KEYS);
+    assert(uNumKeys < MAX_KEYS);
+
+    if (psChild->iLeaf) {
+        psLeft = (struct SymTableLeaf *)psChild;
+        psRight = SymTable_newLeaf();
+        if (psRight == NULL)
+            return 0;
+        SymTable_moveBindings(psRight, 0, psLeft, uHalf,
+                              MAX_KEYS - uHalf);
+        psRight->sNode.uNumKeys = MAX_KEYS - uHalf;
+        psRight->psNext = psLeft->psNext;
+        psLeft->psNext = psRight;
+        psNew = &psRight->sNode;
+    }
+    else {
+        psLeftInner = (struct SymTableInner *)psChild;
+        psRightInner = SymTable_newInner();
+        if (psRightInner == NULL)
+            return 0;
+        SymTable_moveKeys(&psRightInner->sNode, 0, psChild, uHalf + 1,
+                          MAX_KEYS - uHalf - 1);
+        SymTable_moveChildren(psRightInner, 0, psLeftInner, uHalf + 1,
+                              MAX_KEYS - uHalf);
+        psRightInner->sNode.uNumKeys = MAX_KEYS - uHalf - 1;
+        psNew = &psRightInner->sNode;
+    }
+
+    /* make room for the separator and the new child */
+    SymTable_moveKeys(&psParent->sNode, uChild + 1, &psParent->sNode,
+                      uChild, uNumKeys - uChild);
+    SymTable_moveChildren(psParent, uChild + 2, psParent, uChild + 1,
+                          uNumKeys - uChild);
+    if (psChild->iLeaf)
+        SymTable_moveKeys(&psParent->sNode, uChild, psNew, 0, 1);
+    else
+        SymTable_moveKeys(&psParent->sNode, uChild, psChild, uHalf, 1);
+    psParent->apsChildren[uChild + 1] = psNew;
+    psParent->sNode.uNumKeys++;
+    psChild->uNumKeys = uHalf;
+    return 1;
+}
+
+/*
+ * Moves the last key of the left sibling of child uChild of inner
+ * node psParent into the child, which is short of keys, and updates
+ * the separator between them.
+ */
+static void SymTable_borrowLeft(struct SymTableInner *psParent,
+    size_t uChild) {
+    struct SymTableNode *psLeft = psParent->apsChildren[uChild - 1];
+    struct SymTableNode *psChild = psParent->apsChildren[uChild];
+    struct SymTableInner *psLeftInner;
+    struct SymTableInner *psChildInner;
+
+    if (psChild->iLeaf) {
+        SymTable_moveBindings((struct SymTableLeaf *)psChild, 1,
+                              (struct SymTableLeaf *)psChild, 0,
+                              psChild->uNumKeys);
+        SymTable_moveBindings((struct SymTableLeaf *)psChild, 0,
+                              (struct SymTableLeaf *)psLeft,
+                              psLeft->uNumKeys - 1, 1);
+        SymTable_moveKeys(&psParent->sNode, uChild - 1, psChild, 0, 1);
+    }
+    else {
+        psLeftInner = (struct SymTableInner *)psLeft;
+        psChildInner = (struct SymTableInner *)psChild;
+        /* the separator comes down and the left key goes up */
+        SymTable_moveKeys(psChild, 1, psChild, 0, psChild->uNumKeys);
+        SymTable_moveChildren(psChildInner, 1, psChildInner, 0,
+                              psChild->uNumKeys + 1);
+        SymTable_moveKeys(psChild, 0, &psParent->sNode, uChild - 1, 1);
+        psChildInner->apsChildren[0] =
+            psLeftInner->apsChildren[psLeft->uNumKeys];
+        SymTable_moveKeys(&psParent->sNode, uChild - 1, psLeft,
+                          psLeft->uNumKeys - 1, 1);
+    }
+    psLeft->uNumKeys--;
+    psChild->uNumKeys++;
+}
+
+/*
+ * Moves the first key of the right sibling of child uChild of inner
+ * node psParent into the child, which is short of keys, and updates
+ * the separator between them.
+ */
+static void SymTable_borrowRight(struct SymTableInner *psParent,
+    size_t uChild) {
+    struct SymTableNode *psChild = psParent->apsChildren[uChild];
+    struct SymTableNode *psRight = psParent->apsChildren[uChild + 1];
+    struct SymTableInner *psChildInner;
+    struct SymTableInner *psRightInner;
+
+    if (psChild->iLeaf) {
+        SymTable_moveBindings((struct SymTableLeaf *)psChild,
+                              psChild->uNumKeys,
+                              (struct SymTableLeaf *)psRight, 0, 1);
+        SymTable_moveBindings((struct SymTableLeaf *)psRight, 0,
+                              (struct SymTableLeaf *)psRight, 1,
+                              psRight->uNumKeys - 1);
+        SymTable_moveKeys(&psParent->sNode, uChild, psRight, 0, 1);
+    }
+    else {
+        psChildInner = (struct SymTableInner *)psChild;
+        psRightInner = (struct SymTableInner *)psRight;
+        /* the separator comes down and the right key goes up */
+        SymTable_moveKeys(psChild, psChild->uNumKeys, &psParent->sNode,
+                          uChild, 1);
+        psChildInner->apsChildren[psChild->uNumKeys + 1] =
+            psRightInner->apsChildren[0];
+        SymTable_moveKeys(&psParent->sNode, uChild, psRight, 0, 1);
+        SymTable_moveKeys(psRight, 0, psRight, 1,
+                          psRight->uNumKeys - 1);
+        SymTable_moveChildren(psRightInner, 0, psRightInner, 1,
+                              psRight->uNumKeys);
+    }
+    psChild->uNumKeys++;
+    psRight->uNumKeys--;
+}
+
+/*
+ * Merges child uChild + 1 of inner node psParent into child uChild,
+ * removing the separator between them from psParent, and frees it.
+ * The two together must fit in one node.
+ */
+static void SymTable_mergeChildren(struct SymTableInner *psParent,
+    size_t uChild) {
+    struct SymTableNode *psLeft = psParent->apsChildren[uChild];
+    struct SymTableNode *psRight = psParent->apsChildren[uChild + 1];
+    size_t uNumKeys = psParent->sNode.uNumKeys;
+
+    if (psLeft->iLeaf) {
+        assert(psLeft->uNumKeys + psRight->uNumKeys <= MAX_KEYS);
+        SymTable_moveBindings((struct SymTableLeaf *)psLeft,
+                              psLeft->uNumKeys,
+                              (struct SymTableLeaf *)psRight, 0,
+                              psRight->uNumKeys);
+        psLeft->uNumKeys += psRight->uNumKeys;
+        ((struct SymTableLeaf *)psLeft)->psNext =
+            ((struct SymTableLeaf *)psRight)->psNext;
+    }
+    else {
+        assert(psLeft->uNumKeys + psRight->uNumKeys + 1 <= MAX_KEYS);
+        /* the separator comes down between the two */
+        SymTable_moveKeys(psLeft, psLeft->uNumKeys, &psParent->sNode,
+                          uChild, 1);
+        SymTable_moveKeys(psLeft, psLeft->uNumKeys + 1, psRight, 0,
+                          psRight->uNumKeys);
+        SymTable_moveChildren((struct SymTableInner *)psLeft,
+                              psLeft->uNumKeys + 1,
+                              (struct SymTableInner *)psRight, 0,
+                              psRight->uNumKeys + 1);
+        psLeft->uNumKeys += psRight->uNumKeys + 1;
+    }
+    free(psRight);
+
+    SymTable_moveKeys(&psParent->sNode, uChild, &psParent->sNode,
+                      uChild + 1, uNumKeys - uChild - 1);
+    SymTable_moveChildren(psParent, uChild + 1, psParent, uChild + 2,
+                          uNumKeys - uChild - 1);
+    psParent->sNode.uNumKeys--;
+}
+
+/*
+ * Brings child uChild of inner node psParent, which has fallen below
+ * MIN_KEYS keys, back up to MIN_KEYS, by borrowing a key from a
+ * sibling that can spare one or else merging with a sibling.
+ */
+static void SymTable_refill(struct SymTableInner *psParent,
+    size_t uChild) {
+    struct SymTableNode *psLeft = NULL;
+    struct SymTableNode *psRight = NULL;
+
+    if (uChild > 0)
+        psLeft = psParent->apsChildren[uChild - 1];
+    if (uChild < psParent->sNode.uNumKeys)
+        psRight = psParent->apsChildren[uChild + 1];
+
+    if (psLeft != NULL && psLeft->uNumKeys > MIN_KEYS)
+        SymTable_borrowLeft(psParent, uChild);
+    else if (psRight != NULL && psRight->uNumKeys > MIN_KEYS)
+        SymTable_borrowRight(psParent, uChild);
+    else if (psLeft != NULL)
+        SymTable_mergeChildren(psParent, uChild - 1);
+    else
+        SymTable_mergeChildren(psParent, uChild);
+}
+
+/* creates a empty SymTable, allocates memory for it,
+   and returns it. returns NULL if memory allocation fails */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+    struct SymTableLeaf *psLeaf;
+
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+    psLeaf = SymTable_newLeaf();
+    if (psLeaf == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->psRoot = &psLeaf->sNode;
+    oSymTable->psFirst = psLeaf;
+    oSymTable->uNumBindings = 0;
+    oSymTable->uVersion = 0;
+    return oSymTable;
+}
+
+/* creates a empty SymTable like SymTable_new. a B-tree orders its
+   keys instead of hashing them, so pfHash is accepted and ignored */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    assert(pfHash != NULL);
+    return SymTable_new();
+}
+
+/* creates a empty SymTable like SymTable_new. a B-tree grows one
+   node at a time, so uCapacity is accepted and ignored */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    (void)uCapacity;
+    return SymTable_new();
+}
+
+/* a B-tree has no room to make in advance, so this does nothing
+   and returns 1 */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    assert(oSymTable != NULL);
+    (void)uCapacity;
+    return 1;
+}
+
+/*
+ * Rebuilds oSymTable with every node full, or as close to full as
+ * the number of bindings allows. Nodes are only kept at least half
+ * full as bindings come and go, and keys put in increasing order
+ * leave every leaf half full, so this can halve the number of nodes.
+ * The new nodes are all allocated before the old ones are freed.
+ * Returns 1 if successful, and 0 if memory allocation fails, in
+ * which case oSymTable is as it was.
+ */
+int SymTable_compact(SymTable_T oSymTable) {
+    struct SymTableNode **ppsNodes;
+    struct SymTableLeaf *psFrom;
+    struct SymTableLeaf *psTo;
+    struct SymTableInner *psInner;
+    size_t uNumBindings;
+    size_t uNumLeaves;
+    size_t uNumNodes;
+    size_t uLevel;
+    size_t uLevelCount;
+    size_t uParentCount;
+    size_t uIndex;
+    size_t uChild;
+    size_t i;
+    size_t j;
+
+    assert(oSymTable != NULL);
+
+    /* a single leaf is as small as it gets */
+    if (oSymTable->psRoot->iLeaf)
+        return 1;
+
+    /* leaves, then each level of inner nodes up to the root */
+    uNumBindings = oSymTable->uNumBindings;
+    uNumLeaves = (uNumBindings - 1) / MAX_KEYS + 1;
+    uNumNodes = uNumLeaves;
+    for (uLevelCount = uNumLeaves; uLevelCount > 1;
+         uLevelCount = uParentCount) {
+        uParentCount = (uLevelCount - 1) / (MAX_KEYS + 1) + 1;
+        uNumNodes += uParentCount;
+    }
+
+    ppsNodes = calloc(uNumNodes, sizeof(struct SymTableNode *));
+    if (ppsNodes == NULL)
+        return 0;
+    for (i = 0; i < uNumNodes; i++) {
+        if (i < uNumLeaves)
+            ppsNodes[i] = (struct SymTableNode *)SymTable_newLeaf();
+        else
+            ppsNodes[i] = (struct SymTableNode *)SymTable_newInner();
+        if (ppsNodes[i] == NULL) {
+            while (i > 0)
+                free(ppsNodes[--i]);
+            free(ppsNodes);
+            return 0;
+        }
+    }
+
+    /* spread the bindings evenly, so that no leaf is short of keys */
+    psFrom = oSymTable->psFirst;
+    uIndex = 0;
+    for (i = 0; i < uNumLeaves; i++) {
+        psTo = (struct SymTableLeaf *)ppsNodes[i];
+        psTo->sNode.uNumKeys = (i + 1) * uNumBindings / uNumLeaves
+                               - i * uNumBindings / uNumLeaves;
+        for (j = 0; j < psTo->sNode.uNumKeys; j++) {
+            while (uIndex == psFrom->sNode.uNumKeys) {
+                psFrom = psFrom->psNext;
+                uIndex = 0;
+            }
+            SymTable_moveBindings(psTo, j, psFrom, uIndex++, 1);
+        }
+        if (i + 1 < uNumLeaves)
+            psTo->psNext = (struct SymTableLeaf *)ppsNodes[i + 1];
+    }
+
+    /* spread each level's nodes evenly among their parents */
+    uLevel = 0;
+    for (uLevelCount = uNumLeaves; uLevelCount > 1;
+         uLevelCount = uParentCount) {
+        uParentCount = (uLevelCount - 1) / (MAX_KEYS + 1) + 1;
+        uChild = uLevel;
+        for (i = 0; i < uParentCount; i++) {
+            psInner = (struct SymTableInner *)
+                      ppsNodes[uLevel + uLevelCount + i];
+            psInner->sNode.uNumKeys =
+                (i + 1) * uLevelCount / uParentCount
+                - i * uLevelCount / uParentCount - 1;
+            for (j = 0; j <= psInner->sNode.uNumKeys; j++) {
+                psInner->apsChildren[j] = ppsNodes[uChild++];
+                if (j > 0)
+                    SymTable_moveKeys(&psInner->sNode, j - 1,
+                        &SymTable_leftmostLeaf(
+                            psInner->apsChildren[j])->sNode, 0, 1);
+            }
+        }
+        uLevel += uLevelCount;
+    }
+
+    SymTable_freeTree(oSymTable->psRoot, 0);
+    oSymTable->psRoot = ppsNodes[uNumNodes - 1];
+    oSymTable->psFirst = (struct SymTableLeaf *)ppsNodes[0];
+    oSymTable->uVersion++;
+    free(ppsNodes);
+    return 1;
+}
+
+/* a B-tree keeps its keys in key order, so iPolicy is accepted
+   and ignored */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    (void)iPolicy;
+}
+
+/* a miss in a B-tree visits one node per level, mostly telling keys
+   apart by their cached prefixes, so iEnable is accepted and
+   ignored */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+    (void)iEnable;
+    return 1;
+}
+
+/* frees memory needed for the SymTable */
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    SymTable_freeTree(oSymTable->psRoot, 1);
+    free(oSymTable);
+}
+
+/* returns number of bindings in the symbol table (oSymTable) */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->uNumBindings;
+}
+
+/*
+ * Helper function that returns the leaf of oSymTable holding the
+ * key of *psTarget, and stores the key's position in it at *puIndex,
+ * adding a binding of the key and pvValue first if the key doesn't
+ * exist in oSymTable. If oKey is not NULL, the key is its string and
+ * the leaf refers to the handle instead of copying the key. Sets
+ * *piCreated to 1 if the binding was added and 0 otherwise. Returns
+ * NULL if memory allocation fails.
+ */
+static struct SymTableLeaf *SymTable_findOrAddKey(SymTable_T oSymTable,
+    const struct SymTableTarget *psTarget, SymTableKey_T oKey,
+    const void *pvValue, size_t *puIndex, int *piCreated) {
+    struct SymTableNode *psNode;
+    struct SymTableInner *psInner;
+    struct SymTableLeaf *psLeaf;
+    char *pcCopy = NULL;
+    const char *pcKey;
+    size_t uChild;
+    size_t uIndex;
+
+    *piCreated = 0;
+
+    /* does not insert key if it already exists */
+    psLeaf = SymTable_find(oSymTable, psTarget, puIndex);
+    if (psLeaf != NULL)
+        return psLeaf;
+
+    /* defensive copy, unless the handle already is one */
+    if (oKey != NULL)
+        pcKey = oKey->acKey;
+    else {
+        if (psTarget->uLength == (size_t)-1)
+            return NULL;
+        pcCopy = malloc(psTarget->uLength + 1);
+        if (pcCopy == NULL)
+            return NULL;
+        memcpy(pcCopy, psTarget->pcKey, psTarget->uLength);
+        pcCopy[psTarget->uLength] = '\0';
+        pcKey = pcCopy;
+    }
+
+    /* bindings move from here on, even if the add fails later */
+    oSymTable->uVersion++;
+
+    /* a full root is split under a new root, so the tree grows one
+       level taller */
+    if (oSymTable->psRoot->uNumKeys == MAX_KEYS) {
+        psInner = SymTable_newInner();
+        if (psInner == NULL) {
+            free(pcCopy);
+            return NULL;
+        }
+        psInner->apsChildren[0] = oSymTable->psRoot;
+        if (!SymTable_splitChild(psInner, 0)) {
+            free(psInner);
+            free(pcCopy);
+            return NULL;
+        }
+        oSymTable->psRoot = &psInner->sNode;
+    }
+
+    /* every full node on the way down is split before it is entered,
+       so the parent of a split node always has room for one more */
+    psNode = oSymTable->psRoot;
+    while (!psNode->iLeaf) {
+        psInner = (struct SymTableInner *)psNode;
+        uChild = SymTable_childIndex(psNode, psTarget);
+        if (psInner->apsChildren[uChild]->uNumKeys == MAX_KEYS) {
+            if (!SymTable_splitChild(psInner, uChild)) {
+                free(pcCopy);
+                return NULL;
+            }
+            if (SymTable_compare(psTarget, psNode, uChild) >= 0)
+                uChild++;
+        }
+        psNode = psInner->apsChildren[uChild];
+    }
+
+    psLeaf = (struct SymTableLeaf *)psNode;
+    uIndex = SymTable_lowerBound(psNode, psTarget);
+    SymTable_moveBindings(psLeaf, uIndex + 1, psLeaf, uIndex,
+                          psNode->uNumKeys - uIndex);
+    psNode->auPrefixes[uIndex] = psTarget->uPrefix;
+    psNode->apcKeys[uIndex] = pcKey;
+    psLeaf->apvValues[uIndex] = (void *)pvValue;
+    psLeaf->aoKeys[uIndex] = oKey;
+    psNode->uNumKeys++;
+    oSymTable->uNumBindings++;
+
+    *puIndex = uIndex;
+    *piCreated = 1;
+    return psLeaf;
+}
+
+/*
+ * Helper function that adds a binding of the key made of the
+ * uLength characters at pcKey and pvValue to oSymTable if the key
+ * doesn't exist in oSymTable. If oKey is not NULL, pcKey is its
+ * string and the leaf refers to the handle instead of copying it.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, SymTableKey_T oKey, const void *pvValue) {
+    struct SymTableTarget sTarget;
+    size_t uIndex;
+    int iCreated;
+
+    SymTable_target(&sTarget, pcKey, uLength);
+    if (SymTable_findOrAddKey(oSymTable, &sTarget, oKey, pvValue,
+                              &uIndex, &iCreated) == NULL)
+        return 0;
+    return iCreated;
+}
+
+/*
+ * adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_putKey(oSymTable, pcKey, strlen(pcKey), NULL,
+                           pvValue);
+}
+
+/*
+ * adds new binding of interned key oKey, pvValue to oSymTable if
+ * the key doesn't exist in oSymTable. the leaf refers to the
+ * handle's string instead of copying it.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength, oKey,
+                           pvValue);
+}
+
+/*
+ * Helper function that returns the address of the value of the key
+ * made of the uLength characters at pcKey in oSymTable, or NULL if
+ * the key doesn't exist in oSymTable.
+ */
+static void **SymTable_findValue(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength) {
+    struct SymTableTarget sTarget;
+    struct SymTableLeaf *psLeaf;
+    size_t uIndex;
+
+    SymTable_target(&sTarget, pcKey, uLength);
+    psLeaf = SymTable_find(oSymTable, &sTarget, &uIndex);
+    if (psLeaf == NULL)
+        return NULL;
+    return &psLeaf->apvValues[uIndex];
+}
+
+/*
+ * Helper function that replaces the value at ppvValue with pvValue
+ * and returns the old value. Returns NULL if ppvValue is NULL.
+ */
+static void *SymTable_replaceValue(void **ppvValue,
+    const void *pvValue) {
+    void *pvOldValue;
+
+    if (ppvValue == NULL)
+        return NULL;
+    pvOldValue = *ppvValue;
+    *ppvValue = (void *)pvValue;
+    return pvOldValue;
+}
+
+/*
+ * replace old value (pvOldValue) of key pcKey in oSymTable
+ * with new value pvValue and returns pvOldValue.
+ * if the given pcKey doesn't exist within oSymTable,
+ * returns NULL
+ */
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_replaceValue(
+        SymTable_findValue(oSymTable, pcKey, strlen(pcKey)), pvValue);
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_replaceValue(
+        SymTable_findValue(oSymTable, oKey->acKey, oKey->uLength),
+        pvValue);
+}
+
+/*
+ * Returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. Sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. The address is the value's
+ * place in its leaf, which stays put until bindings are added or
+ * removed. Returns NULL if memory allocation fails.
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    struct SymTableTarget sTarget;
+    struct SymTableLeaf *psLeaf;
+    size_t uIndex;
+    int iCreated;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_target(&sTarget, pcKey, strlen(pcKey));
+    psLeaf = SymTable_findOrAddKey(oSymTable, &sTarget, NULL, pvValue,
+                                   &uIndex, &iCreated);
+    if (psLeaf == NULL)
+        return NULL;
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &psLeaf->apvValues[uIndex];
+}
+
+/*
+ * checks if given key pcKey exists within oSymTable.
+ * returns 1 if pcKey exists, if else returns 0
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_findValue(oSymTable, pcKey, strlen(pcKey)) != NULL;
+}
+
+/*
+ * checks if interned key oKey exists within oSymTable.
+ * returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    return SymTable_findValue(oSymTable, oKey->acKey, oKey->uLength)
+           != NULL;
+}
+
+/*
+ * returns value associated with key pcKey if it exists
+ * within oSymTable, returns NULL if can't find given pcKey
+ * in oSymTable
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    void **ppvValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    ppvValue = SymTable_findValue(oSymTable, pcKey, strlen(pcKey));
+    if (ppvValue == NULL)
+        return NULL;
+    return *ppvValue;
+}
+
+/*
+ * returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
+ */
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
+    void **ppvValue;
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    ppvValue = SymTable_findValue(oSymTable, oKey->acKey,
+                                  oKey->uLength);
+    if (ppvValue == NULL)
+        return NULL;
+    return *ppvValue;
+}
+
+/*
+ * Stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. Every lookup descends from the same root, whose
+ * upper levels stay cached from one key to the next, so the keys
+ * are simply looked up in turn.
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    size_t i;
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+    for (i = 0; i < uNumKeys; i++)
+        apvValues[i] = SymTable_get(oSymTable, apcKeys[i]);
+}
+
+/*
+ * Helper function that removes the binding of the key of *psTarget
+ * from oSymTable and frees its key string unless it belongs to a
+ * handle. On the way back up from the leaf, the one separator that
+ * pointed to the removed key is pointed to the next key instead, and
+ * every node that fell below MIN_KEYS is refilled; neither
+ * allocates. Returns the value of the removed binding, or NULL if
+ * the key doesn't exist in oSymTable.
+ */
+static void *SymTable_removeKey(SymTable_T oSymTable,
+    const struct SymTableTarget *psTarget) {
+    struct SymTableInner *apsPath[MAX_HEIGHT];
+    size_t auChildren[MAX_HEIGHT];
+    struct SymTableNode *psNode = oSymTable->psRoot;
+    struct SymTableInner *psParent;
+    struct SymTableLeaf *psLeaf;
+    const char *pcRemoved;
+    SymTableKey_T oRemoved;
+    void *pvValue;
+    size_t uDepth = 0;
+    size_t uChild;
+    size_t uIndex;
+
+    /* remember the way down, to fix the nodes on it afterwards */
+    while (!psNode->iLeaf) {
+        assert(uDepth < MAX_HEIGHT);
+        apsPath[uDepth] = (struct SymTableInner *)psNode;
+        auChildren[uDepth] = SymTable_childIndex(psNode, psTarget);
+        psNode = apsPath[uDepth]->apsChildren[auChildren[uDepth]];
+        uDepth++;
+    }
+
+    psLeaf = (struct SymTableLeaf *)psNode;
+    uIndex = SymTable_lowerBound(psNode, psTarget);
+    if (uIndex == psNode->uNumKeys
+        || SymTable_compare(psTarget, psNode, uIndex) != 0)
+        return NULL;
+
+    pcRemoved = psNode->apcKeys[uIndex];
+    oRemoved = psLeaf->aoKeys[uIndex];
+    pvValue = psLeaf->apvValues[uIndex];
+    SymTable_moveBindings(psLeaf, uIndex, psLeaf, uIndex + 1,
+                          psNode->uNumKeys - uIndex - 1);
+    psNode->uNumKeys--;
+    oSymTable->uNumBindings--;
+    oSymTable->uVersion++;
+
+    while (uDepth > 0) {
+        uDepth--;
+        psParent = apsPath[uDepth];
+        uChild = auChildren[uDepth];
+        /* the removed key was the smallest in the child's subtree */
+        if (uChild > 0
+            && psParent->sNode.apcKeys[uChild - 1] == pcRemoved)
+            SymTable_moveKeys(&psParent->sNode, uChild - 1,
+                &SymTable_leftmostLeaf(
+                    psParent->apsChildren[uChild])->sNode, 0, 1);
+        if (psParent->apsChildren[uChild]->uNumKeys < MIN_KEYS)
+            SymTable_refill(psParent, uChild);
+    }
+
+    /* a root left with a single child gives way to it */
+    if (!oSymTable->psRoot->iLeaf && oSymTable->psRoot->uNumKeys == 0) {
+        psParent = (struct SymTableInner *)oSymTable->psRoot;
+        oSymTable->psRoot = psParent->apsChildren[0];
+        free(psParent);
+    }
+
+    if (oRemoved == NULL)
+        free((char *)pcRemoved);
+    return pvValue;
+}
+
+/*
+ * removes binding associated with given pcKey from the
+ * symbol table (oSymTable) and frees memory.
+ * return value associated with removed key if key existed
+ * in oSymTable. return NULL otherwise.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct SymTableTarget sTarget;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_target(&sTarget, pcKey, strlen(pcKey));
+    return SymTable_removeKey(oSymTable, &sTarget);
+}
+
+/*
+ * removes binding associated with interned key oKey from
+ * oSymTable and frees memory. return value associated with
+ * removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    struct SymTableTarget sTarget;
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    SymTable_target(&sTarget, oKey->acKey, oKey->uLength);
+    return SymTable_removeKey(oSymTable, &sTarget);
+}
+
+/*
+ * adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. the characters are copied, with a '\0' added.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_putKey(oSymTable, pcKey, uLength, NULL, pvValue);
+}
+
+/*
+ * checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable. returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_findValue(oSymTable, pcKey, uLength) != NULL;
+}
+
+/*
+ * returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    void **ppvValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    ppvValue = SymTable_findValue(oSymTable, pcKey, uLength);
+    if (ppvValue == NULL)
+        return NULL;
+    return *ppvValue;
+}
+
+/*
+ * removes binding of the key made of the uLength characters at
+ * pcKey from oSymTable and frees memory. return value associated
+ * with removed key if it existed in oSymTable. return NULL
+ * otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    struct SymTableTarget sTarget;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_target(&sTarget, pcKey, uLength);
+    return SymTable_removeKey(oSymTable, &sTarget);
+}
+
+/*
+ * Works like SymTable_put. A B-tree does not hash its keys, so
+ * uHash, the code SymTable_hashKey returns for pcKey, is ignored.
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    (void)uHash;
+    return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+/*
+ * Works like SymTable_get; uHash is ignored.
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    (void)uHash;
+    return SymTable_get(oSymTable, pcKey);
+}
+
+/*
+ * Works like SymTable_remove; uHash is ignored.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    (void)uHash;
+    return SymTable_remove(oSymTable, pcKey);
+}
+
+/*
+ * To each binding in oSymTable, apply function (pfApply) given by
+ * the user, in key order. user is able to input additional
+ * parameter pvExtra if needed for the user defined function.
+ */
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableLeaf *psLeaf;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (psLeaf = oSymTable->psFirst; psLeaf != NULL;
+         psLeaf = psLeaf->psNext) {
+        for (i = 0; i < psLeaf->sNode.uNumKeys; i++)
+            (*pfApply)(psLeaf->sNode.apcKeys[i], psLeaf->apvValues[i],
+                       (void *)pvExtra);
+    }
+}
+
+/*
+ * Applies the function of mapping pvMapping to the bindings under
+ * the children uFirst to uLimit - 1 of the root of its table, which
+ * is an inner node. They are the leaves from the leftmost one under
+ * child uFirst up to the leftmost one under child uLimit.
+ */
+static void SymTable_mapChildren(size_t uFirst, size_t uLimit,
+    void *pvMapping) {
+    struct SymTableMapping *psMapping = pvMapping;
+    struct SymTableInner *psRoot =
+        (struct SymTableInner *)psMapping->oSymTable->psRoot;
+    struct SymTableLeaf *psLeaf;
+    struct SymTableLeaf *psStop = NULL;
+    size_t i;
+
+    psLeaf = SymTable_leftmostLeaf(psRoot->apsChildren[uFirst]);
+    if (uLimit <= psRoot->sNode.uNumKeys)
+        psStop = SymTable_leftmostLeaf(psRoot->apsChildren[uLimit]);
+    for (; psLeaf != psStop; psLeaf = psLeaf->psNext) {
+        for (i = 0; i < psLeaf->sNode.uNumKeys; i++)
+            (*psMapping->pfApply)(psLeaf->sNode.apcKeys[i],
+                                  psLeaf->apvValues[i],
+                                  (void *)psMapping->pvExtra);
+    }
+}
+
+/*
+ * To each binding in oSymTable, apply function *pfApply with
+ * pvExtra as extra argument, in up to iThreadCount threads at once.
+ * The subtrees under the root are shared out one at a time; a tree
+ * that is still a single leaf is mapped by the calling thread.
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    struct SymTableMapping sMapping;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->psRoot->iLeaf) {
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymTable_runParallel(oSymTable->psRoot->uNumKeys + 1, 1,
+                         iThreadCount, SymTable_mapChildren, &sMapping);
+}
+
+/*
+ * To each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function *pfApply with pvExtra as extra
+ * argument, in key order. A NULL bound leaves that end open. The
+ * first binding is found with one descent and the rest are read
+ * from the leaves in turn. Returns 1.
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableTarget sLow;
+    struct SymTableTarget sHigh;
+    struct SymTableLeaf *psLeaf;
+    size_t i = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    psLeaf = oSymTable->psFirst;
+    if (pcLow != NULL) {
+        SymTable_target(&sLow, pcLow, strlen(pcLow));
+        psLeaf = SymTable_findLeaf(oSymTable, &sLow);
+        i = SymTable_lowerBound(&psLeaf->sNode, &sLow);
+    }
+    if (pcHigh != NULL)
+        SymTable_target(&sHigh, pcHigh, strlen(pcHigh));
+
+    for (; psLeaf != NULL; psLeaf = psLeaf->psNext, i = 0) {
+        for (; i < psLeaf->sNode.uNumKeys; i++) {
+            if (pcHigh != NULL
+                && SymTable_compare(&sHigh, &psLeaf->sNode, i) <= 0)
+                return 1;
+            (*pfApply)(psLeaf->sNode.apcKeys[i], psLeaf->apvValues[i],
+                       (void *)pvExtra);
+        }
+    }
+    return 1;
+}
+
+/*
+ * To each binding of oSymTable whose key starts with pcPrefix,
+ * apply function *pfApply with pvExtra as extra argument, in key
+ * order. The keys with a prefix form one run starting where the
+ * prefix itself would be, so this is a range walk that stops at the
+ * first key without it. Returns 1.
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableTarget sPrefix;
+    struct SymTableLeaf *psLeaf;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    SymTable_target(&sPrefix, pcPrefix, strlen(pcPrefix));
+    psLeaf = SymTable_findLeaf(oSymTable, &sPrefix);
+    i = SymTable_lowerBound(&psLeaf->sNode, &sPrefix);
+
+    for (; psLeaf != NULL; psLeaf = psLeaf->psNext, i = 0) {
+        for (; i < psLeaf->sNode.uNumKeys; i++) {
+            if (strncmp(psLeaf->sNode.apcKeys[i], pcPrefix,
+                        sPrefix.uLength) != 0)
+                return 1;
+            (*pfApply)(psLeaf->sNode.apcKeys[i], psLeaf->apvValues[i],
+                       (void *)pvExtra);
+        }
+    }
+    return 1;
+}
+
+/*
+ * Opens cursor *psIter over the bindings of oSymTable, which it
+ * returns in key order. The cursor keeps the key of the binding it
+ * returns next, in pvArray, along with that binding's leaf and
+ * position and the version of the table they were found in. If the
+ * table's version has changed since, the key is looked up again, so
+ * bindings may be put and removed meanwhile: those after the cursor
+ * are returned and those before it are not.
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    struct SymTableLeaf *psFirst;
+
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psFirst = oSymTable->psFirst;
+    psIter->oSymTable = oSymTable;
+    psIter->pvNode = psFirst;
+    psIter->uIndex = 0;
+    psIter->uCount = oSymTable->uVersion;
+    psIter->pvArray = NULL;
+    if (psFirst->sNode.uNumKeys > 0)
+        psIter->pvArray = (char *)psFirst->sNode.apcKeys[0];
+}
+
+/*
+ * Moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. Returns 0 once every
+ * binding has been returned.
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    SymTable_T oSymTable;
+    struct SymTableTarget sTarget;
+    struct SymTableLeaf *psLeaf;
+    const char *pcKey;
+    size_t uIndex;
+
+    assert(psIter != NULL);
+
+    pcKey = psIter->pvArray;
+    if (pcKey == NULL)
+        return 0;
+
+    /* the binding to return may have moved */
+    oSymTable = psIter->oSymTable;
+    if (psIter->uCount != oSymTable->uVersion) {
+        SymTable_target(&sTarget, pcKey, strlen(pcKey));
+        psLeaf = SymTable_findLeaf(oSymTable, &sTarget);
+        psIter->pvNode = psLeaf;
+        psIter->uIndex = SymTable_lowerBound(&psLeaf->sNode, &sTarget);
+        psIter->uCount = oSymTable->uVersion;
+    }
+    psLeaf = psIter->pvNode;
+    uIndex = psIter->uIndex;
+
+    if (ppcKey != NULL)
+        *ppcKey = psLeaf->sNode.apcKeys[uIndex];
+    if (ppvValue != NULL)
+        *ppvValue = psLeaf->apvValues[uIndex];
+
+    /* look ahead, since the caller may remove this binding */
+    if (++uIndex == psLeaf->sNode.uNumKeys) {
+        psLeaf = psLeaf->psNext;
+        uIndex = 0;
+    }
+    psIter->pvNode = psLeaf;
+    psIter->uIndex = uIndex;
+    psIter->pvArray = NULL;
+    if (psLeaf != NULL)
+        psIter->pvArray = (char *)psLeaf->sNode.apcKeys[uIndex];
+    return 1;
+}
+
+/* Closes cursor *psIter, which holds nothing to release. */
+void SymTable_end(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+    psIter->pvArray = NULL;
+}
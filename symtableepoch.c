@@ -0,0 +1,245 @@
+/*
+ * symtableepoch.c
+ *
+ * Epoch-based reclamation shared by the thread-safe symbol table
+ * implementations. Their lookups run without locks while other
+ * threads unlink nodes and bucket arrays, so nothing unlinked may
+ * be freed while a lookup could still be reading it.
+ *
+ * Every thread that reads has a reader record, in which it announces
+ * the global epoch while it is inside a reading stretch. Unlinked
+ * blocks are put on the garbage list of the epoch in which they were
+ * unlinked. The epoch only advances once every thread inside a
+ * stretch has announced the current one, and the garbage of epoch e
+ * is freed when the epoch reaches e + 2: by then every stretch that
+ * could have reached it has ended. The garbage lists and records
+ * serve every table in the process.
+ */
+
+/* for syscall */
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "symtableepoch.h"
+/* keeps other records off the cache line a record's owner writes */
+#define CACHE_LINE_SIZE 64
+/* number of frees deferred before trying to advance the epoch */
+#define GARBAGE_THRESHOLD 64
+
+/* reader record of one thread */
+struct SymTableReader {
+    /* epoch announced by the thread inside a stretch, 0 outside */
+    size_t uEpoch;
+    /* number of stretches the thread is inside; only the owner
+       reads or writes it */
+    size_t uDepth;
+    /* 1 while a thread owns the record, 0 once it can be reused */
+    int iInUse;
+    /* pointer to next record; records are never freed */
+    struct SymTableReader *psNext;
+    /* keeps other records off the cache line the owner writes */
+    char acPadding[CACHE_LINE_SIZE];
+};
+
+/* guards the garbage lists, epoch advances and the record list */
+static pthread_mutex_t sGarbageLock = PTHREAD_MUTEX_INITIALIZER;
+/* current epoch, starting at 1 so that 0 can mean "not reading" */
+static size_t uGlobalEpoch = 1;
+/* blocks unlinked in each of the last three epochs, indexed by the
+   epoch modulo 3 */
+static struct SymTableGarbage *apsGarbage[3];
+/* number of blocks deferred since the epoch last advanced */
+static size_t uNumGarbage = 0;
+/* every reader record ever created */
+static struct SymTableReader *psReaders = NULL;
+/* number of stretches run by threads that have no record. while it
+   is not 0 the epoch cannot advance */
+static size_t uNumAnonymousReaders = 0;
+/* key to each thread's reader record */
+static pthread_key_t sReaderKey;
+static pthread_once_t sReadersOnce = PTHREAD_ONCE_INIT;
+/* 1 if the system can make every thread of the process execute a
+   memory barrier on request, 0 if each stretch needs its own */
+static int iAsymmetricFence = 0;
+
+/* Releases reader record pvReader when its thread exits. */
+static void SymTable_releaseReader(void *pvReader) {
+    struct SymTableReader *psReader = pvReader;
+
+    __atomic_store_n(&psReader->iInUse, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Creates the key to each thread's reader record, and finds out if
+ * membarrier is available: then the rare epoch advance pays for the
+ * memory barrier that each stretch would otherwise need.
+ */
+static void SymTable_initReaders(void) {
+    (void)pthread_key_create(&sReaderKey, SymTable_releaseReader);
+#if defined(__linux__) && defined(SYS_membarrier)
+    iAsymmetricFence =
+        syscall(SYS_membarrier,
+                MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+#endif
+}
+
+/*
+ * Returns the calling thread's reader record, reusing the record of
+ * a thread that has exited or creating one if it has none yet.
+ * Returns NULL if memory allocation fails.
+ */
+static struct SymTableReader *SymTable_reader(void) {
+    struct SymTableReader *psReader;
+
+    (void)pthread_once(&sReadersOnce, SymTable_initReaders);
+    psReader = pthread_getspecific(sReaderKey);
+    if (psReader != NULL)
+        return psReader;
+
+    pthread_mutex_lock(&sGarbageLock);
+    for (psReader = psReaders; psReader != NULL;
+         psReader = psReader->psNext) {
+        if (!__atomic_load_n(&psReader->iInUse, __ATOMIC_ACQUIRE))
+            break;
+    }
+    if (psReader == NULL) {
+        psReader = malloc(sizeof(struct SymTableReader));
+        if (psReader != NULL) {
+            psReader->uEpoch = 0;
+            psReader->psNext = psReaders;
+            psReaders = psReader;
+        }
+    }
+    if (psReader != NULL) {
+        psReader->uDepth = 0;
+        psReader->iInUse = 1;
+        if (pthread_setspecific(sReaderKey, psReader) != 0) {
+            psReader->iInUse = 0;
+            psReader = NULL;
+        }
+    }
+    pthread_mutex_unlock(&sGarbageLock);
+    return psReader;
+}
+
+/*
+ * Marks the start of a reading stretch and returns the calling
+ * thread's record, or NULL if it has none. A memory barrier orders
+ * the announcement before every load of the stretch, so a thread
+ * advancing the epoch either sees the announcement or unlinked its
+ * garbage before the stretch could reach it. With membarrier, the
+ * thread advancing the epoch forces that barrier on this one, and
+ * the stretch itself only has to keep the compiler from reordering.
+ * Release order makes the thread's earlier stretches visible to
+ * whoever sees the announcement.
+ */
+struct SymTableReader *SymTable_enterEpoch(void) {
+    struct SymTableReader *psReader = SymTable_reader();
+
+    /* without a record, hold the epoch back for everyone; the
+       atomic add is a full barrier */
+    if (psReader == NULL) {
+        (void)__atomic_add_fetch(&uNumAnonymousReaders, 1,
+                                 __ATOMIC_SEQ_CST);
+        return NULL;
+    }
+
+    if (psReader->uDepth++ > 0)
+        return psReader;
+    __atomic_store_n(&psReader->uEpoch,
+                     __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED),
+                     __ATOMIC_RELEASE);
+    if (iAsymmetricFence)
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    else
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return psReader;
+}
+
+/* Marks the end of the stretch that SymTable_enterEpoch started. */
+void SymTable_leaveEpoch(struct SymTableReader *psReader) {
+    if (psReader == NULL) {
+        (void)__atomic_sub_fetch(&uNumAnonymousReaders, 1,
+                                 __ATOMIC_RELEASE);
+        return;
+    }
+
+    assert(psReader->uDepth > 0);
+    if (--psReader->uDepth == 0)
+        __atomic_store_n(&psReader->uEpoch, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Helper function that advances the epoch if every thread inside a
+ * stretch has announced the current one, and frees the garbage that
+ * no stretch can still be reading. The caller must hold
+ * sGarbageLock.
+ */
+static void SymTable_advanceEpoch(void) {
+    struct SymTableReader *psReader;
+    struct SymTableGarbage *psGarbage;
+    struct SymTableGarbage *psNextGarbage;
+    size_t uEpoch;
+
+    /* pairs with the barrier in SymTable_enterEpoch */
+    (void)pthread_once(&sReadersOnce, SymTable_initReaders);
+#if defined(__linux__) && defined(SYS_membarrier)
+    if (iAsymmetricFence)
+        (void)syscall(SYS_membarrier,
+                      MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+#endif
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&uNumAnonymousReaders, __ATOMIC_ACQUIRE) != 0)
+        return;
+    for (psReader = psReaders; psReader != NULL;
+         psReader = psReader->psNext) {
+        uEpoch = __atomic_load_n(&psReader->uEpoch, __ATOMIC_ACQUIRE);
+        if (uEpoch != 0 && uEpoch != uGlobalEpoch)
+            return;
+    }
+
+    __atomic_store_n(&uGlobalEpoch, uGlobalEpoch + 1, __ATOMIC_RELEASE);
+    uNumGarbage = 0;
+
+    /* free the garbage of two epochs ago, whose list comes after the
+       new epoch's modulo 3 */
+    for (psGarbage = apsGarbage[(uGlobalEpoch + 1) % 3];
+         psGarbage != NULL; psGarbage = psNextGarbage) {
+        psNextGarbage = psGarbage->psNext;
+        free(psGarbage);
+    }
+    apsGarbage[(uGlobalEpoch + 1) % 3] = NULL;
+}
+
+/*
+ * Frees the blocks of the NULL-terminated list psFirst, linked
+ * through their garbage links, once no stretch can still be reading
+ * them. The blocks must already be unreachable for stretches that
+ * start from now on.
+ */
+void SymTable_deferFree(struct SymTableGarbage *psFirst) {
+    struct SymTableGarbage *psLast;
+    size_t uCount = 1;
+
+    assert(psFirst != NULL);
+
+    for (psLast = psFirst; psLast->psNext != NULL;
+         psLast = psLast->psNext)
+        uCount++;
+
+    pthread_mutex_lock(&sGarbageLock);
+    psLast->psNext = apsGarbage[uGlobalEpoch % 3];
+    apsGarbage[uGlobalEpoch % 3] = psFirst;
+    uNumGarbage += uCount;
+    if (uNumGarbage >= GARBAGE_THRESHOLD)
+        SymTable_advanceEpoch();
+    pthread_mutex_unlock(&sGarbageLock);
+}
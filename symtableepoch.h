@@ -0,0 +1,48 @@
+/*
+ * symtableepoch.h
+ *
+ * Private interface shared by the thread-safe symbol table
+ * implementations and symtableepoch.c. Not for clients; they use
+ * symtable.h. Provides epoch-based reclamation:
+ * - marking the stretches of code that read shared nodes without
+ *   holding a lock
+ * - deferring the free of unlinked blocks until no such stretch
+ *   can still be reading them
+ */
+
+#ifndef SYMTABLEEPOCH_INCLUDED
+#define SYMTABLEEPOCH_INCLUDED
+
+/* link in a list of blocks whose free is deferred. it must be the
+   first member of every block that is deferred, so that its address
+   is the block's address */
+struct SymTableGarbage {
+    struct SymTableGarbage *psNext;
+};
+
+/* per-thread record of whether and since when the thread is reading */
+struct SymTableReader;
+
+/*
+ * marks the start of a stretch of code that reads shared nodes
+ * without a lock, and returns the calling thread's record, to be
+ * passed to SymTable_leaveEpoch at the end. returns NULL if the
+ * thread has no record and cannot get one, in which case the
+ * stretch is protected all the same, only more slowly. stretches
+ * may nest. the only write to memory another thread writes is the
+ * first time a thread enters
+ */
+struct SymTableReader *SymTable_enterEpoch(void);
+
+/* marks the end of the stretch that SymTable_enterEpoch started */
+void SymTable_leaveEpoch(struct SymTableReader *psReader);
+
+/*
+ * frees the blocks of the NULL-terminated list psFirst, linked
+ * through their garbage links, once every stretch that was running
+ * when this is called has ended. the blocks must already be
+ * unreachable for stretches that start from now on
+ */
+void SymTable_deferFree(struct SymTableGarbage *psFirst);
+
+#endif
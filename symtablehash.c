@@ -7,31 +7,93 @@
  * - creating and deleting a symbol table 
  * - adding and removing key-value pairs
  * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
  * - applying a user-defined function to each entry 
+ * - applying it with several threads at once
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - sizing a table in advance for a known number of bindings
+ * - shrinking a table as bindings are removed, and compacting it
+ * - turning away most missing keys with a Bloom filter
  */
 
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "symtable.h"
+#include "symtablekey.h"
+#include "symtablepool.h"
 #define INITIAL_BUCKET_COUNT 509
 #define RESIZE_FACTOR 0.5
+/* load below which a remove shrinks the table, to about twice this
+   load. well under RESIZE_FACTOR, so that a table whose size
+   hovers around a bucket count does not keep resizing */
+#define SHRINK_FACTOR 0.125
+/* number of old buckets migrated by each operation while an
+   incremental rehash is in progress. define as 0 to rehash every
+   node in a single pass instead */
+#define REHASH_STEP 8
+/* nodes are carved from per-table chunks. blocks up to
+   SMALL_BLOCK_LIMIT bytes come in multiples of BLOCK_GRANULE,
+   larger blocks in powers of two */
+#define BLOCK_GRANULE 8
+#define SMALL_BLOCK_LIMIT 256
+#define NUM_SMALL_CLASSES (SMALL_BLOCK_LIMIT / BLOCK_GRANULE)
+/* chunk sizes start small and double up to the maximum */
+#define INITIAL_CHUNK_SIZE 4096
+#define MAX_CHUNK_SIZE (1024 * 1024)
+/* number of lookups SymTable_getBatch keeps in flight at once */
+#define BATCH_SIZE 16
+/* number of buckets a thread of SymTable_mapParallel takes at once */
+#define MAP_GRAIN 256
+/* bits of Bloom filter per bucket, so at least 16 per key at
+   RESIZE_FACTOR; the filter's word count is rounded up to a power
+   of two. each key sets FILTER_PROBES bits of a single word */
+#define FILTER_BITS_PER_BUCKET 8
+#define FILTER_PROBES 4
+/* fraction of the bucket count that removed keys may reach before
+   the filter is refilled without their bits */
+#define FILTER_STALE_FACTOR 0.25
 
-/* array of available bucket sizes, used for hash table resizing */
-static const size_t auAvailBucketSize[] = {509, 1021, 2039, 4093, 
-    8191, 16381, 32749, 65521};
-/* number of elements */
-static size_t uNumBucketSizes = sizeof(auAvailBucketSize) 
-    / sizeof(auAvailBucketSize[0]);
-
-/* key value pair node structure */
+/* key value pair node structure. the node and its key are one
+   allocation, with the key's bytes stored right after the node */
 struct SymTableNode {
-    /* key string */
-    char *pcKey;
     /* value for key */
     void *pvValue;
+    /* full hash code of the key, before reduction to a bucket index */
+    size_t uHash;
     /* pointer to next node in the bucket */
     struct SymTableNode *psNext;  
+    /* handle the binding was put with, or NULL if it was put with a
+       key string. if not NULL, acKey is empty and the key string is
+       the handle's */
+    SymTableKey_T oKey;
+    /* key string, stored inline */
+    char acKey[];
+};
+
+/* header of a chunk of node memory owned by one symbol table.
+   the chunk's blocks follow the header */
+struct SymTableChunk {
+    /* pointer to previously allocated chunk */
+    struct SymTableChunk *psNext;
+    /* keeps the blocks after the header aligned */
+    size_t uPadding;
+};
+
+/* one SymTable_mapParallel call, shared by all of its threads */
+struct SymTableMapping {
+    /* table being mapped */
+    SymTable_T oSymTable;
+    /* function applied to each binding, and its extra argument */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
 };
 
 /* symbol table structure */
@@ -42,82 +104,563 @@ struct SymTable {
     size_t uNumBuckets;
     /* number of bindings */
     size_t uNumBindings;
+    /* hash function applied to key strings */
+    size_t (*pfHash)(const char *pcKey);
+    /* random seed mixed into every hash code before it is reduced
+       to a bucket index, so tables lay out the same keys differently */
+    size_t uSeed;
+    /* bucket array still being drained into ppsBuckets by an
+       incremental rehash, NULL when no rehash is in progress */
+    struct SymTableNode **ppsOldBuckets;
+    /* number of buckets in ppsOldBuckets */
+    size_t uNumOldBuckets;
+    /* old buckets below this index have already been migrated */
+    size_t uMigrateIndex;
+    /* number of open cursors. while it is not 0, no node is
+       migrated, so that the cursors find every node where it was */
+    size_t uNumCursors;
+    /* list of chunks that all nodes are allocated from */
+    struct SymTableChunk *psChunks;
+    /* next unused byte in the newest chunk */
+    char *pcChunkNext;
+    /* number of unused bytes left in the newest chunk */
+    size_t uChunkLeft;
+    /* size of the next chunk to allocate */
+    size_t uNextChunkSize;
+    /* removed nodes available for reuse, linked through psNext.
+       list i holds blocks of SymTable_blockSize(i) bytes */
+    struct SymTableNode *apsFreeNodes[NUM_SMALL_CLASSES
+                                      + sizeof(size_t) * CHAR_BIT];
+    /* Bloom filter of the hash codes of the table's keys, NULL
+       while it is off. a key that misses it is not in the table */
+    uint64_t *puFilter;
+    /* number of words in puFilter, a power of two */
+    size_t uNumFilterWords;
+    /* filter that puFilter replaced when the incremental rehash
+       started, still covering the keys of the old buckets that have
+       not been migrated. NULL when no rehash is in progress */
+    uint64_t *puOldFilter;
+    /* number of words in puOldFilter */
+    size_t uNumOldFilterWords;
+    /* number of keys removed since puFilter was filled, whose bits
+       it may still have set */
+    size_t uNumStaleKeys;
 };
 
 /*
- * Compute hash code for given key string pcKey
- * using the number of buckets provided as uNumBuckets.
- * Return size_t hash index. 
+ * Returns the hash code of key string pcKey, which is uLength
+ * characters long, in oSymTable, computed with the table's hash
+ * function. The default hash function is given the length, so it
+ * does not have to find the '\0' again.
  */
-static size_t SymTable_hash(const char *pcKey, size_t uNumBuckets) {
-    const size_t HASH_MULTIPLIER = 65599;
-    size_t u;
-    size_t uHash = 0;
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return SymTable_hashBytes(pcKey, uLength);
+    return (*oSymTable->pfHash)(pcKey);
+}
 
-    assert(pcKey != NULL);
+/*
+ * Returns the hash code of interned key oKey in oSymTable. A table
+ * using the default hash function reuses the handle's precomputed
+ * hash code; any other table has to hash the handle's string.
+ */
+static size_t SymTable_handleHash(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return oKey->uHash;
+    return (*oSymTable->pfHash)(oKey->acKey);
+}
+
+/*
+ * Returns the hash code in oSymTable of key string pcKey, given the
+ * code uHash that SymTable_hashKey returns for it. A table using the
+ * default hash function takes uHash as is; any other table has to
+ * hash the string.
+ */
+static size_t SymTable_givenHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return uHash;
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns 1 if uNum is prime, and 0 otherwise. Uses trial division
+ * by odd numbers, which is cheap next to the rehash that follows.
+ */
+static int SymTable_isPrime(size_t uNum) {
+    size_t uDivisor;
+
+    if (uNum < 2) return 0;
+    if (uNum % 2 == 0) return uNum == 2;
+    for (uDivisor = 3; uDivisor <= uNum / uDivisor; uDivisor += 2) {
+        if (uNum % uDivisor == 0) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Returns the bucket count that follows uOldBucketSize: the largest
+ * prime below twice the smallest power of two above uOldBucketSize
+ * (509 -> 1021 -> 2039 -> ...). Returns uOldBucketSize if no larger
+ * count can be represented, so the table simply stops growing.
+ */
+static size_t SymTable_nextBucketCount(size_t uOldBucketSize) {
+    size_t uPowerOfTwo = 1;
+    size_t uCandidate;
+
+    while (uPowerOfTwo <= uOldBucketSize) {
+        /* power of two would overflow, so no larger size exists */
+        if (uPowerOfTwo > ((size_t)-1) / 4) return uOldBucketSize;
+        uPowerOfTwo *= 2;
+    }
+    uPowerOfTwo *= 2;
+
+    /* walk down through odd candidates until a prime is found */
+    for (uCandidate = uPowerOfTwo - 1; uCandidate > uOldBucketSize;
+         uCandidate -= 2) {
+        if (SymTable_isPrime(uCandidate)) return uCandidate;
+    }
+    return uOldBucketSize;
+}
 
-    for (u = 0; pcKey[u] != '\0'; u++)
-        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+/*
+ * Returns the bucket count that holds uCapacity bindings without
+ * growing: the first count of the sequence SymTable_nextBucketCount
+ * walks from INITIAL_BUCKET_COUNT that keeps the load at or below
+ * RESIZE_FACTOR, or the largest count of the sequence if none does.
+ */
+static size_t SymTable_bucketCountFor(size_t uCapacity) {
+    size_t uNumBuckets = INITIAL_BUCKET_COUNT;
+    size_t uNextCount;
 
-    return uHash % uNumBuckets;
+    while ((double)uCapacity / uNumBuckets > RESIZE_FACTOR) {
+        uNextCount = SymTable_nextBucketCount(uNumBuckets);
+        if (uNextCount == uNumBuckets) break;
+        uNumBuckets = uNextCount;
+    }
+    return uNumBuckets;
+}
+
+/*
+ * Returns the size class of a node that needs uSize bytes, where
+ * uSize is at least 1. Sizes up to SMALL_BLOCK_LIMIT round up to a
+ * multiple of BLOCK_GRANULE; larger sizes to a power of two.
+ */
+static unsigned int SymTable_blockClass(size_t uSize) {
+    unsigned int uClass = NUM_SMALL_CLASSES;
+    size_t uBlockSize = SMALL_BLOCK_LIMIT * 2;
+
+    if (uSize <= SMALL_BLOCK_LIMIT)
+        return (unsigned int)((uSize + BLOCK_GRANULE - 1)
+                              / BLOCK_GRANULE) - 1;
+    while (uBlockSize < uSize) {
+        uBlockSize *= 2;
+        uClass++;
+    }
+    return uClass;
+}
+
+/* Returns the number of bytes in a block of size class uClass. */
+static size_t SymTable_blockSize(unsigned int uClass) {
+    if (uClass < NUM_SMALL_CLASSES)
+        return (size_t)(uClass + 1) * BLOCK_GRANULE;
+    return (size_t)SMALL_BLOCK_LIMIT
+           << (uClass - NUM_SMALL_CLASSES + 1);
+}
+
+/*
+ * Helper function that returns memory for a node of oSymTable whose
+ * key is uKeySize bytes long, including its '\0'. A removed node of
+ * the same size class is reused if there is one; otherwise a block
+ * is bumped off the newest chunk, allocating a new chunk when it is
+ * used up. Returns NULL if memory allocation fails.
+ */
+static struct SymTableNode *SymTable_allocNode(SymTable_T oSymTable,
+    size_t uKeySize) {
+    struct SymTableNode *psNode;
+    struct SymTableChunk *psChunk;
+    size_t uBlockSize;
+    size_t uChunkSize;
+    unsigned int uClass;
+
+    if (uKeySize > ((size_t)-1) / 4) return NULL;
+    uClass = SymTable_blockClass(sizeof(struct SymTableNode)
+                                 + uKeySize);
+    uBlockSize = SymTable_blockSize(uClass);
+
+    /* reuse a removed node from the free list */
+    psNode = oSymTable->apsFreeNodes[uClass];
+    if (psNode != NULL) {
+        oSymTable->apsFreeNodes[uClass] = psNode->psNext;
+        return psNode;
+    }
+
+    /* newest chunk is used up: start another, doubling the size */
+    if (uBlockSize > oSymTable->uChunkLeft) {
+        uChunkSize = oSymTable->uNextChunkSize;
+        if (uChunkSize < MAX_CHUNK_SIZE)
+            oSymTable->uNextChunkSize *= 2;
+        if (uChunkSize < uBlockSize)
+            uChunkSize = uBlockSize;
+
+        psChunk = malloc(sizeof(struct SymTableChunk) + uChunkSize);
+        if (psChunk == NULL)
+            return NULL;
+        psChunk->psNext = oSymTable->psChunks;
+        oSymTable->psChunks = psChunk;
+        oSymTable->pcChunkNext = (char *)(psChunk + 1);
+        oSymTable->uChunkLeft = uChunkSize;
+    }
+
+    psNode = (struct SymTableNode *)oSymTable->pcChunkNext;
+    oSymTable->pcChunkNext += uBlockSize;
+    oSymTable->uChunkLeft -= uBlockSize;
+    return psNode;
+}
+
+/*
+ * Helper function that puts psNode, a node of oSymTable that is no
+ * longer in any bucket, on the free list of its size class.
+ */
+static void SymTable_freeNode(SymTable_T oSymTable,
+    struct SymTableNode *psNode) {
+    unsigned int uClass;
+
+    uClass = SymTable_blockClass(sizeof(struct SymTableNode)
+                                 + strlen(psNode->acKey) + 1);
+    psNode->psNext = oSymTable->apsFreeNodes[uClass];
+    oSymTable->apsFreeNodes[uClass] = psNode;
+}
+
+/* Returns the key string of the binding stored in psNode. */
+static const char *SymTable_nodeKey(const struct SymTableNode *psNode) {
+    if (psNode->oKey != NULL)
+        return psNode->oKey->acKey;
+    return psNode->acKey;
+}
+
+/*
+ * Returns the number of words of the Bloom filter of a table with
+ * uNumBuckets buckets: the least power of two that gives each
+ * bucket FILTER_BITS_PER_BUCKET bits.
+ */
+static size_t SymTable_filterWordCount(size_t uNumBuckets) {
+    size_t uNumWords = 1;
+
+    while (uNumWords * 64 / FILTER_BITS_PER_BUCKET < uNumBuckets
+           && uNumWords <= ((size_t)-1) / 128)
+        uNumWords *= 2;
+    return uNumWords;
+}
+
+/*
+ * Returns the hash code uHash of a key in oSymTable mixed with the
+ * table's seed, so that the codes of a weak hash function still
+ * spread over the filter. The filter takes its word index and the
+ * bits it sets in that word from different parts of the result.
+ */
+static uint64_t SymTable_filterCode(SymTable_T oSymTable,
+    size_t uHash) {
+    uint64_t uCode = (uint64_t)(uHash ^ oSymTable->uSeed);
+
+    uCode ^= uCode >> 33;
+    uCode *= UINT64_C(0xFF51AFD7ED558CCD);
+    uCode ^= uCode >> 33;
+    return uCode;
+}
+
+/*
+ * Returns the FILTER_PROBES bits that filter code uCode sets in its
+ * word, at positions given by six bits of uCode each.
+ */
+static uint64_t SymTable_filterMask(uint64_t uCode) {
+    uint64_t uMask = 0;
+    int i;
+
+    for (i = 0; i < FILTER_PROBES; i++)
+        uMask |= (uint64_t)1 << ((uCode >> (6 * i)) & 63);
+    return uMask;
+}
+
+/*
+ * Helper function that sets the bits of filter code uCode in the
+ * filter of uNumWords words at puFilter.
+ */
+static void SymTable_filterAdd(uint64_t *puFilter, size_t uNumWords,
+    uint64_t uCode) {
+    puFilter[(size_t)(uCode >> 32) & (uNumWords - 1)]
+        |= SymTable_filterMask(uCode);
+}
+
+/*
+ * Returns 1 if every bit of filter code uCode is set in the filter
+ * of uNumWords words at puFilter, and 0 if its key was never added.
+ */
+static int SymTable_filterHas(const uint64_t *puFilter,
+    size_t uNumWords, uint64_t uCode) {
+    uint64_t uMask = SymTable_filterMask(uCode);
+
+    return (puFilter[(size_t)(uCode >> 32) & (uNumWords - 1)] & uMask)
+           == uMask;
+}
+
+/*
+ * Returns 0 if the filter of oSymTable shows that no key with hash
+ * code uHash is in oSymTable, and 1 if there may be one or the
+ * filter is off. During an incremental rehash, a key may be covered
+ * by the old filter alone.
+ */
+static int SymTable_mayContain(SymTable_T oSymTable, size_t uHash) {
+    uint64_t uCode;
+
+    if (oSymTable->puFilter == NULL)
+        return 1;
+    uCode = SymTable_filterCode(oSymTable, uHash);
+    if (SymTable_filterHas(oSymTable->puFilter,
+                           oSymTable->uNumFilterWords, uCode))
+        return 1;
+    return oSymTable->puOldFilter != NULL
+           && SymTable_filterHas(oSymTable->puOldFilter,
+                                 oSymTable->uNumOldFilterWords, uCode);
+}
+
+/*
+ * Helper function that clears the filter of oSymTable and sets the
+ * bits of every key in both of its bucket arrays, so that the bits
+ * of removed keys are gone and the old filter is no longer needed.
+ */
+static void SymTable_fillFilter(SymTable_T oSymTable) {
+    struct SymTableNode *psNode;
+    size_t i;
+
+    memset(oSymTable->puFilter, 0,
+           oSymTable->uNumFilterWords * sizeof(uint64_t));
+    for (i = 0; i < oSymTable->uNumBuckets; i++) {
+        for (psNode = oSymTable->ppsBuckets[i]; psNode != NULL;
+             psNode = psNode->psNext)
+            SymTable_filterAdd(oSymTable->puFilter,
+                               oSymTable->uNumFilterWords,
+                               SymTable_filterCode(oSymTable,
+                                                   psNode->uHash));
+    }
+    for (i = oSymTable->uMigrateIndex; i < oSymTable->uNumOldBuckets;
+         i++) {
+        for (psNode = oSymTable->ppsOldBuckets[i]; psNode != NULL;
+             psNode = psNode->psNext)
+            SymTable_filterAdd(oSymTable->puFilter,
+                               oSymTable->uNumFilterWords,
+                               SymTable_filterCode(oSymTable,
+                                                   psNode->uHash));
+    }
+
+    free(oSymTable->puOldFilter);
+    oSymTable->puOldFilter = NULL;
+    oSymTable->uNumOldFilterWords = 0;
+    oSymTable->uNumStaleKeys = 0;
+}
+
+/*
+ * Helper function that migrates up to uMaxBuckets buckets of
+ * ppsOldBuckets in oSymTable into ppsBuckets. Once every old bucket
+ * has been migrated, the old bucket array is freed and the
+ * incremental rehash is over. Does nothing if no rehash is pending
+ * or a cursor is open.
+ */
+static void SymTable_migrate(SymTable_T oSymTable, size_t uMaxBuckets) {
+    struct SymTableNode *psNode;
+    struct SymTableNode *psNextNode;
+    size_t uNewIndex;
+    size_t uMigrated = 0;
+
+    if (oSymTable->ppsOldBuckets == NULL || oSymTable->uNumCursors > 0)
+        return;
+
+    while (uMigrated < uMaxBuckets
+           && oSymTable->uMigrateIndex < oSymTable->uNumOldBuckets) {
+        /* move every node of this old bucket to its new bucket */
+        psNode = oSymTable->ppsOldBuckets[oSymTable->uMigrateIndex];
+        while (psNode != NULL) {
+            psNextNode = psNode->psNext;
+            /* cached hash avoids touching the key bytes */
+            uNewIndex = (psNode->uHash ^ oSymTable->uSeed)
+                        % oSymTable->uNumBuckets;
+            psNode->psNext = oSymTable->ppsBuckets[uNewIndex];
+            oSymTable->ppsBuckets[uNewIndex] = psNode;
+            /* the new filter takes over the key from the old one */
+            if (oSymTable->puOldFilter != NULL)
+                SymTable_filterAdd(oSymTable->puFilter,
+                                   oSymTable->uNumFilterWords,
+                                   SymTable_filterCode(oSymTable,
+                                                       psNode->uHash));
+            psNode = psNextNode;
+        }
+        oSymTable->ppsOldBuckets[oSymTable->uMigrateIndex] = NULL;
+        oSymTable->uMigrateIndex++;
+        uMigrated++;
+    }
+
+    /* every old bucket is empty now, so the old array can go, and
+       with it the filter of its keys */
+    if (oSymTable->uMigrateIndex == oSymTable->uNumOldBuckets) {
+        free(oSymTable->ppsOldBuckets);
+        oSymTable->ppsOldBuckets = NULL;
+        oSymTable->uNumOldBuckets = 0;
+        oSymTable->uMigrateIndex = 0;
+        free(oSymTable->puOldFilter);
+        oSymTable->puOldFilter = NULL;
+        oSymTable->uNumOldFilterWords = 0;
+    }
 }
 
 /* 
- * Helper function that resizes symbol table oSymTable by 
- * increasing number of buckets. Then all bindings that already
- * exist are rehashed into new buckets. Returns 1 if resizing is
- * successful, and 0 otherwise. 
- */
-static int SymTable_resize(SymTable_T oSymTable) {
-    size_t uNewBucketSize; 
-    size_t uOldBucketSize = oSymTable->uNumBuckets; 
-    size_t i; 
+ * Helper function that resizes symbol table oSymTable to
+ * uNewBucketSize buckets, more or fewer than it has now.
+ * The current bucket array becomes the old array of an incremental
+ * rehash, whose nodes are moved REHASH_STEP buckets at a time by
+ * later operations. While a cursor holds back a pending rehash, the
+ * table keeps its size. A filter is replaced by an empty one sized
+ * for the new array, which migrated and newly put keys are added
+ * to, so the bits of removed keys are dropped along the way.
+ * Returns 1 if resizing is successful or held back, and 0
+ * otherwise.
+ */
+static int SymTable_resize(SymTable_T oSymTable,
+    size_t uNewBucketSize) {
+    size_t uOldBucketSize;
+    size_t uNumFilterWords = 0;
     struct SymTableNode **ppsNewBuckets; 
+    uint64_t *puNewFilter = NULL;
 
-    size_t uCurrentIndex = 0;
-    /* find the next bucket size that's available */
-    while (uCurrentIndex < uNumBucketSizes 
-            && auAvailBucketSize[uCurrentIndex] 
-            <= uOldBucketSize) {
-        uCurrentIndex++;
-    }
-    /* if reach maximum bucket size, stop resizing */
-    if (uCurrentIndex >= uNumBucketSizes) return 1; 
+    /* if no other size is asked for, keep chaining */
+    if (uNewBucketSize == oSymTable->uNumBuckets) return 1;
+
+    /* a new rehash can only start once the previous one is done */
+    SymTable_migrate(oSymTable, oSymTable->uNumOldBuckets);
+    if (oSymTable->ppsOldBuckets != NULL) return 1;
+    uOldBucketSize = oSymTable->uNumBuckets;
 
-    /* set new bucket size and allocate memory for the new array */
-    uNewBucketSize = auAvailBucketSize[uCurrentIndex];
+    /* allocate memory for the new array */
     ppsNewBuckets = calloc(uNewBucketSize, 
                            sizeof(struct SymTableNode *));
     /* case when memory allocation fails */
     if (!ppsNewBuckets) return 0; 
-
-    /* rehash each node from old to new bucket */
-    for (i = 0; i < uOldBucketSize; i++) {
-    struct SymTableNode *psNode = oSymTable->ppsBuckets[i];
-    while (psNode) {
-        struct SymTableNode *psNextNode = psNode->psNext;
-        size_t newIndex 
-               = SymTable_hash(psNode->pcKey, uNewBucketSize);
-        /* insert node to new bucket at the index calculated */
-        psNode->psNext = ppsNewBuckets[newIndex];
-        ppsNewBuckets[newIndex] = psNode;
-
-        psNode = psNextNode;
+    if (oSymTable->puFilter != NULL) {
+        uNumFilterWords = SymTable_filterWordCount(uNewBucketSize);
+        puNewFilter = calloc(uNumFilterWords, sizeof(uint64_t));
+        if (puNewFilter == NULL) {
+            free(ppsNewBuckets);
+            return 0;
         }
+        /* the last rehash is over, so its old filter is gone */
+        oSymTable->puOldFilter = oSymTable->puFilter;
+        oSymTable->uNumOldFilterWords = oSymTable->uNumFilterWords;
+        oSymTable->puFilter = puNewFilter;
+        oSymTable->uNumFilterWords = uNumFilterWords;
+        oSymTable->uNumStaleKeys = 0;
     }
-    free(oSymTable->ppsBuckets);
+
+    /* current buckets are drained into the new array over time */
+    oSymTable->ppsOldBuckets = oSymTable->ppsBuckets;
+    oSymTable->uNumOldBuckets = uOldBucketSize;
+    oSymTable->uMigrateIndex = 0;
     oSymTable->ppsBuckets = ppsNewBuckets;
     oSymTable->uNumBuckets = uNewBucketSize;
 
+    /* without incremental rehashing, move every node right away */
+    if (REHASH_STEP == 0)
+        SymTable_migrate(oSymTable, uOldBucketSize);
+
     return 1;
 }
 
 /*
- * Creates and returns a empty SymTable_T symbol table, 
- * and allocate memory for the symbol table structure & buckets.
+ * Helper function that returns the address of the bucket in
+ * oSymTable where a key with hash code uHash belongs: its old
+ * bucket if that bucket has not been migrated yet, and its bucket
+ * in ppsBuckets otherwise. Every binding lives in exactly one of
+ * the two arrays.
+ */
+static struct SymTableNode **SymTable_bucket(SymTable_T oSymTable,
+    size_t uHash) {
+    size_t uHashIndex;
+
+    if (oSymTable->ppsOldBuckets != NULL) {
+        uHashIndex = (uHash ^ oSymTable->uSeed)
+                     % oSymTable->uNumOldBuckets;
+        if (uHashIndex >= oSymTable->uMigrateIndex)
+            return &oSymTable->ppsOldBuckets[uHashIndex];
+    }
+    uHashIndex = (uHash ^ oSymTable->uSeed) % oSymTable->uNumBuckets;
+    return &oSymTable->ppsBuckets[uHashIndex];
+}
+
+/*
+ * Helper function that walks the chain linked from *ppsLink looking
+ * for the key made of the uLength characters at pcKey, with hash
+ * code uHash; oKey is the key's handle, or NULL if the caller only
+ * has the characters. Returns the address of
+ * the link that points to the matching node, or of the chain's
+ * final NULL link if there is none. Nodes with a different cached
+ * hash are skipped without calling strcmp, and two handles are
+ * compared by address alone.
+ */
+static struct SymTableNode **SymTable_findLink(
+    struct SymTableNode **ppsLink, const char *pcKey, size_t uLength,
+    size_t uHash, SymTableKey_T oKey) {
+    struct SymTableNode *psCurrentNode;
+
+    for (; (psCurrentNode = *ppsLink) != NULL;
+         ppsLink = &psCurrentNode->psNext) {
+        if (psCurrentNode->uHash != uHash)
+            continue;
+        if (oKey != NULL && psCurrentNode->oKey != NULL) {
+            /* equal strings always intern to the same handle */
+            if (psCurrentNode->oKey == oKey)
+                break;
+        }
+        else if (SymTable_keyEquals(SymTable_nodeKey(psCurrentNode),
+                                    pcKey, uLength))
+            break;
+    }
+    return ppsLink;
+}
+
+/*
+ * Helper function that migrates one step of any pending rehash and
+ * returns the node of oSymTable holding the key made of the uLength
+ * characters at pcKey, with hash code uHash and handle oKey (NULL
+ * if unknown), or NULL if there is none. A key the filter turns
+ * away is not looked for in the buckets.
+ */
+static struct SymTableNode *SymTable_lookup(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash,
+    SymTableKey_T oKey) {
+    SymTable_migrate(oSymTable, REHASH_STEP);
+    if (!SymTable_mayContain(oSymTable, uHash))
+        return NULL;
+    return *SymTable_findLink(SymTable_bucket(oSymTable, uHash), pcKey,
+                              uLength, uHash, oKey);
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function.
  * Returns NULL if memory allocation is unsuccessful.
  */
 SymTable_T SymTable_new(void) {
+    return SymTable_newWithHash(SymTable_hashString);
+}
+
+/*
+ * Helper function that creates and returns a empty symbol table
+ * that hashes keys with pfHash and has uNumBuckets buckets, and
+ * allocate memory for the symbol table structure & buckets.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+static SymTable_T SymTable_create(size_t (*pfHash)(const char *pcKey),
+    size_t uNumBuckets) {
     SymTable_T oSymTable;
     size_t i; 
     
@@ -126,9 +669,9 @@ SymTable_T SymTable_new(void) {
     if (oSymTable == NULL)
         return NULL;
     
-    /* memory allocation for bucket pointer array */
-    oSymTable->ppsBuckets = malloc(sizeof(struct SymTableNode *) 
-                                    * INITIAL_BUCKET_COUNT); 
+    /* memory allocation for bucket pointer array, all empty */
+    oSymTable->ppsBuckets = calloc(uNumBuckets,
+                                   sizeof(struct SymTableNode *));
     if (oSymTable->ppsBuckets == NULL) {
         /* have to free oSymTable 
            if bucket memory allocation fails */
@@ -136,43 +679,257 @@ SymTable_T SymTable_new(void) {
         return NULL;
     }
     
-    /* initialize bucket pointers */
-    for (i = 0; i < INITIAL_BUCKET_COUNT; i++)
-        oSymTable->ppsBuckets[i] = NULL; 
-    
-    oSymTable->uNumBuckets = INITIAL_BUCKET_COUNT; 
+    oSymTable->uNumBuckets = uNumBuckets;
     oSymTable->uNumBindings = 0; 
+    oSymTable->pfHash = pfHash;
+    oSymTable->uSeed = SymTable_newSeed();
+    oSymTable->ppsOldBuckets = NULL;
+    oSymTable->uNumOldBuckets = 0;
+    oSymTable->uMigrateIndex = 0;
+    oSymTable->uNumCursors = 0;
+
+    /* no node memory until the first put */
+    oSymTable->psChunks = NULL;
+    oSymTable->pcChunkNext = NULL;
+    oSymTable->uChunkLeft = 0;
+    oSymTable->uNextChunkSize = INITIAL_CHUNK_SIZE;
+    for (i = 0; i < sizeof(oSymTable->apsFreeNodes)
+                    / sizeof(oSymTable->apsFreeNodes[0]); i++)
+        oSymTable->apsFreeNodes[i] = NULL;
+
+    /* the filter is off until SymTable_setFilter */
+    oSymTable->puFilter = NULL;
+    oSymTable->uNumFilterWords = 0;
+    oSymTable->puOldFilter = NULL;
+    oSymTable->uNumOldFilterWords = 0;
+    oSymTable->uNumStaleKeys = 0;
+
+    return oSymTable;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with pfHash, and allocate memory for the symbol table
+ * structure & buckets.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    assert(pfHash != NULL);
+    return SymTable_create(pfHash, INITIAL_BUCKET_COUNT);
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function and starts out with enough
+ * buckets for uCapacity bindings, so that it is never rehashed
+ * while they are put.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    return SymTable_create(SymTable_hashString,
+                           SymTable_bucketCountFor(uCapacity));
+}
+
+/*
+ * Makes room in oSymTable for uCapacity bindings in all, so that it
+ * does not grow again until it holds more. Any resize happens now,
+ * in one step, and its nodes are migrated incrementally as usual.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    size_t uNewBucketSize;
+
+    assert(oSymTable != NULL);
+
+    /* never shrinks */
+    uNewBucketSize = SymTable_bucketCountFor(uCapacity);
+    if (uNewBucketSize <= oSymTable->uNumBuckets)
+        return 1;
+    return SymTable_resize(oSymTable, uNewBucketSize);
+}
+
+/*
+ * Rebuilds oSymTable with the fewest buckets that hold its bindings
+ * and copies every node into one chunk of just the right size, so
+ * that the memory of removed nodes kept for reuse is given back and
+ * the nodes that remain sit close together. Any incremental rehash
+ * is finished on the way. Nothing changes until both allocations
+ * have succeeded, and nothing at all while a cursor is open.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_compact(SymTable_T oSymTable) {
+    struct SymTableNode **ppsNewBuckets;
+    struct SymTableNode *psNode;
+    struct SymTableNode *psNextNode;
+    struct SymTableNode *psCopy;
+    struct SymTableChunk *psChunk = NULL;
+    struct SymTableChunk *psOldChunk;
+    struct SymTableChunk *psNextChunk;
+    uint64_t *puNewFilter = NULL;
+    size_t uNewBucketSize;
+    size_t uNumFilterWords = 0;
+    size_t uChunkSize = 0;
+    size_t uNodeSize;
+    size_t uIndex;
+    size_t i;
+    char *pcNext = NULL;
+
+    assert(oSymTable != NULL);
 
-    return oSymTable;   
+    /* open cursors hold pointers into the nodes and buckets */
+    if (oSymTable->uNumCursors > 0)
+        return 1;
+
+    /* the rehash is finished first, so every node is in ppsBuckets */
+    SymTable_migrate(oSymTable, oSymTable->uNumOldBuckets);
+
+    /* measure the nodes, then allocate everything up front */
+    for (i = 0; i < oSymTable->uNumBuckets; i++) {
+        for (psNode = oSymTable->ppsBuckets[i]; psNode != NULL;
+             psNode = psNode->psNext)
+            uChunkSize += SymTable_blockSize(SymTable_blockClass(
+                sizeof(struct SymTableNode)
+                + strlen(psNode->acKey) + 1));
+    }
+    uNewBucketSize = SymTable_bucketCountFor(oSymTable->uNumBindings);
+    ppsNewBuckets = calloc(uNewBucketSize,
+                           sizeof(struct SymTableNode *));
+    if (ppsNewBuckets == NULL)
+        return 0;
+    if (uChunkSize > 0) {
+        psChunk = malloc(sizeof(struct SymTableChunk) + uChunkSize);
+        if (psChunk == NULL) {
+            free(ppsNewBuckets);
+            return 0;
+        }
+        psChunk->psNext = NULL;
+        pcNext = (char *)(psChunk + 1);
+    }
+    if (oSymTable->puFilter != NULL) {
+        uNumFilterWords = SymTable_filterWordCount(uNewBucketSize);
+        puNewFilter = malloc(uNumFilterWords * sizeof(uint64_t));
+        if (puNewFilter == NULL) {
+            free(psChunk);
+            free(ppsNewBuckets);
+            return 0;
+        }
+    }
+
+    /* copy each node into the new chunk and its new bucket. cached
+       hash codes avoid touching the key bytes */
+    for (i = 0; i < oSymTable->uNumBuckets; i++) {
+        for (psNode = oSymTable->ppsBuckets[i]; psNode != NULL;
+             psNode = psNextNode) {
+            psNextNode = psNode->psNext;
+            uNodeSize = sizeof(struct SymTableNode)
+                        + strlen(psNode->acKey) + 1;
+            psCopy = (struct SymTableNode *)pcNext;
+            pcNext += SymTable_blockSize(
+                SymTable_blockClass(uNodeSize));
+            memcpy(psCopy, psNode, uNodeSize);
+            uIndex = (psNode->uHash ^ oSymTable->uSeed)
+                     % uNewBucketSize;
+            psCopy->psNext = ppsNewBuckets[uIndex];
+            ppsNewBuckets[uIndex] = psCopy;
+        }
+    }
+
+    /* the old nodes, free ones included, all live in the old chunks */
+    for (psOldChunk = oSymTable->psChunks; psOldChunk != NULL;
+         psOldChunk = psNextChunk) {
+        psNextChunk = psOldChunk->psNext;
+        free(psOldChunk);
+    }
+    free(oSymTable->ppsBuckets);
+    oSymTable->ppsBuckets = ppsNewBuckets;
+    oSymTable->uNumBuckets = uNewBucketSize;
+
+    /* the filter is sized for the new bucket count and refilled */
+    if (puNewFilter != NULL) {
+        free(oSymTable->puFilter);
+        oSymTable->puFilter = puNewFilter;
+        oSymTable->uNumFilterWords = uNumFilterWords;
+        SymTable_fillFilter(oSymTable);
+    }
+
+    /* the new chunk is full, so the next node starts a small one */
+    oSymTable->psChunks = psChunk;
+    oSymTable->pcChunkNext = NULL;
+    oSymTable->uChunkLeft = 0;
+    oSymTable->uNextChunkSize = INITIAL_CHUNK_SIZE;
+    for (i = 0; i < sizeof(oSymTable->apsFreeNodes)
+                    / sizeof(oSymTable->apsFreeNodes[0]); i++)
+        oSymTable->apsFreeNodes[i] = NULL;
+    return 1;
+}
+
+/*
+ * A lookup compares only the few keys of one chain, so moving keys
+ * within their chains would gain little; iPolicy is accepted and
+ * ignored.
+ */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    (void)iPolicy;
+}
+
+/*
+ * Turns the Bloom filter of oSymTable on, sized for its bucket
+ * count and filled with its keys, if iEnable is not 0, and off
+ * otherwise.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+
+    if (!iEnable) {
+        free(oSymTable->puFilter);
+        free(oSymTable->puOldFilter);
+        oSymTable->puFilter = NULL;
+        oSymTable->uNumFilterWords = 0;
+        oSymTable->puOldFilter = NULL;
+        oSymTable->uNumOldFilterWords = 0;
+        return 1;
+    }
+    if (oSymTable->puFilter != NULL)
+        return 1;
+
+    oSymTable->uNumFilterWords =
+        SymTable_filterWordCount(oSymTable->uNumBuckets);
+    oSymTable->puFilter = malloc(oSymTable->uNumFilterWords
+                                 * sizeof(uint64_t));
+    if (oSymTable->puFilter == NULL) {
+        oSymTable->uNumFilterWords = 0;
+        return 0;
+    }
+    SymTable_fillFilter(oSymTable);
+    return 1;
 }
 
 /*
  * Free all memory associated with symbol table oSymTable.
- * Thus key-value bindings as well as the symbol table itself 
- * are freed. If oSymTable is NULL, nothing is freed. 
+ * Thus key-value bindings as well as the symbol table itself
+ * are freed. Every node lives in one of the table's chunks, so
+ * freeing the chunks releases all bindings without walking chains.
  */
 void SymTable_free(SymTable_T oSymTable) {
-    struct SymTableNode *psCurrentNode; 
-    struct SymTableNode *psNextNode; 
-    size_t i; 
+    struct SymTableChunk *psChunk;
+    struct SymTableChunk *psNextChunk;
 
-    assert(oSymTable != NULL); 
+    assert(oSymTable != NULL);
 
-    for (i = 0; i < oSymTable->uNumBuckets; i++){
-        /* start at the first node of each bucket's chain */
-        psCurrentNode = oSymTable->ppsBuckets[i]; 
-        while (psCurrentNode != NULL) {
-            /* have to save next node in chain before freeing */
-            psNextNode = psCurrentNode->psNext; 
-            /* free memory for both key and current node */
-            free(psCurrentNode->pcKey); 
-            free(psCurrentNode); 
-            psCurrentNode = psNextNode; 
-        }
+    for (psChunk = oSymTable->psChunks; psChunk != NULL;
+         psChunk = psNextChunk) {
+        psNextChunk = psChunk->psNext;
+        free(psChunk);
     }
 
-    /* free memory for both array of bucket pointers & symbol table */
+    /* free memory for both arrays of bucket pointers, the filters
+       & symbol table */
+    free(oSymTable->ppsOldBuckets);
     free(oSymTable->ppsBuckets);
+    free(oSymTable->puOldFilter);
+    free(oSymTable->puFilter);
     free(oSymTable); 
 }
 
@@ -183,59 +940,143 @@ size_t SymTable_getLength(SymTable_T oSymTable) {
 }
 
 /* 
- * Adds new binding of pcKey, pvValue to symbol table (oSymTable) 
- * if the key pcKey doesn't exist in oSymTable. 
- * returns 1 if binding was added, returns 0 if memory allocation 
- * fails or key already exists in oSymTable 
+ * Helper function that returns the node of oSymTable holding the
+ * key made of the uLength characters at pcKey, whose hash code is
+ * uHash, adding a binding of the key and pvValue at the end of its
+ * chain first if the key doesn't exist in oSymTable. If oKey is not
+ * NULL, pcKey is its string and a new node refers to the handle
+ * instead of copying the key. Sets *piCreated to 1 if the binding
+ * was added and 0 otherwise.
+ * Returns NULL if memory allocation fails.
  */
-int SymTable_put(SymTable_T oSymTable,
-    const char *pcKey, const void *pvValue) {
+static struct SymTableNode *SymTable_findOrAddKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue, int *piCreated) {
         struct SymTableNode *psNewNode; 
-        struct SymTableNode *psCurrentNode; 
-        size_t uHashIndex; 
+        struct SymTableNode **ppsLink;
+        size_t uKeySize;
         
-        assert(oSymTable != NULL); 
-        assert(pcKey != NULL); 
+        *piCreated = 0;
+        SymTable_migrate(oSymTable, REHASH_STEP);
 
         /* determine if resizing is needed. 
            comment out the if statement to disable resizing */
         if ((double)oSymTable->uNumBindings / oSymTable->uNumBuckets 
                                                     > RESIZE_FACTOR) {
             /* case when resizing fails */
-            if (!SymTable_resize(oSymTable)) return 0; 
+            if (!SymTable_resize(oSymTable,
+                    SymTable_nextBucketCount(oSymTable->uNumBuckets)))
+                return NULL;
         }
         
-        uHashIndex = SymTable_hash(pcKey, oSymTable->uNumBuckets); 
+        ppsLink = SymTable_findLink(SymTable_bucket(oSymTable, uHash),
+                                    pcKey, uLength, uHash, oKey);
 
         /* does not insert key if it already exists */
-        for (psCurrentNode = oSymTable->ppsBuckets[uHashIndex]; 
-            psCurrentNode != NULL; 
-            psCurrentNode = psCurrentNode-> psNext) {
-                if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-                    return 0; 
-            }
+        if (*ppsLink != NULL)
+            return *ppsLink;
         
-        /* make a new node & check memory is allocated corectly */
-        psNewNode = malloc(sizeof(struct SymTableNode)); 
+        /* make a new node with room for a defensive copy of the key
+           & check memory is allocated corectly. a handle already
+           is a stable copy, so an interned key is not copied */
+        uKeySize = (oKey != NULL) ? 1 : uLength + 1;
+        psNewNode = SymTable_allocNode(oSymTable, uKeySize);
         if (psNewNode == NULL)
-            return 0; 
+            return NULL;
 
-        /* defensive copy */
-        psNewNode->pcKey = malloc(strlen(pcKey) + 1);
-        if (psNewNode->pcKey == NULL) {
-            free(psNewNode);
-            return 0;
+        /* copy key into the node, '\0' included */
+        if (oKey != NULL)
+            psNewNode->acKey[0] = '\0';
+        else {
+            memcpy(psNewNode->acKey, pcKey, uLength);
+            psNewNode->acKey[uLength] = '\0';
         }
-        /* copy key into the new memory */
-        strcpy(psNewNode->pcKey, pcKey);
 
-        /* link new node to the chain's front */
+        /* link new node to the chain's end */
         psNewNode->pvValue = (void *)pvValue;
-        psNewNode->psNext = oSymTable->ppsBuckets[uHashIndex];
-        oSymTable->ppsBuckets[uHashIndex] = psNewNode;
+        psNewNode->uHash = uHash;
+        psNewNode->oKey = oKey;
+        psNewNode->psNext = NULL;
+        *ppsLink = psNewNode;
         oSymTable->uNumBindings++; 
         
-        return 1;
+        if (oSymTable->puFilter != NULL)
+            SymTable_filterAdd(oSymTable->puFilter,
+                               oSymTable->uNumFilterWords,
+                               SymTable_filterCode(oSymTable, uHash));
+
+        *piCreated = 1;
+        return psNewNode;
+}
+
+/*
+ * Helper function that adds a binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash, and
+ * pvValue to oSymTable if the key doesn't exist in oSymTable. If
+ * oKey is not NULL, pcKey is its string and the node refers to the
+ * handle instead of copying the key.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue) {
+    int iCreated;
+
+    SymTable_findOrAddKey(oSymTable, pcKey, uLength, uHash, oKey,
+                          pvValue, &iCreated);
+    return iCreated;
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL, pvValue);
+}
+
+/*
+ * Adds new binding of interned key oKey, pvValue to oSymTable
+ * if the key doesn't exist in oSymTable, using the handle's
+ * precomputed hash code. returns 1 if binding was added, returns 0
+ * if memory allocation fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey,
+                           pvValue);
+}
+
+/*
+ * Helper function that replaces the value of psNode with pvValue
+ * and returns the old value. Returns NULL if psNode is NULL.
+ */
+static void *SymTable_replaceNode(struct SymTableNode *psNode,
+    const void *pvValue) {
+    void *pvOldValue;
+
+    if (psNode == NULL)
+        return NULL;
+
+    pvOldValue = psNode->pvValue;
+    psNode->pvValue = (void *)pvValue;
+    return pvOldValue;
 }
 
 /* 
@@ -246,54 +1087,91 @@ int SymTable_put(SymTable_T oSymTable,
  */
 void *SymTable_replace(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue) {
-        struct SymTableNode *psCurrentNode; 
-        size_t uHashIndex; 
-        void *pvOldValue; 
+    size_t uLength;
 
-        assert(oSymTable != NULL); 
-        assert(pcKey != NULL); 
-        
-        /* determine which bucket key is located in */
-        uHashIndex = SymTable_hash(pcKey, oSymTable->uNumBuckets); 
-
-        /* traverse chain of nodes to find & replace node 
-           with matching key */
-        for (psCurrentNode = oSymTable->ppsBuckets[uHashIndex]; 
-            psCurrentNode != NULL; 
-            psCurrentNode = psCurrentNode->psNext) {
-                if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-                    pvOldValue = psCurrentNode->pvValue; 
-                    psCurrentNode->pvValue = (void *)pvValue; 
-                    return pvOldValue; 
-                }
-            }
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
 
-        return NULL; 
-    }
+    uLength = strlen(pcKey);
+    return SymTable_replaceNode(
+        SymTable_lookup(oSymTable, pcKey, uLength,
+                        SymTable_hash(oSymTable, pcKey, uLength), NULL),
+        pvValue);
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_replaceNode(
+        SymTable_lookup(oSymTable, oKey->acKey, oKey->uLength,
+                        SymTable_handleHash(oSymTable, oKey), oKey),
+        pvValue);
+}
 
+/*
+ * Returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. Sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. The key is hashed once and its
+ * chain walked once. Returns NULL if memory allocation fails.
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    struct SymTableNode *psNode;
+    size_t uLength;
+    int iCreated;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    psNode = SymTable_findOrAddKey(oSymTable, pcKey, uLength,
+                                   SymTable_hash(oSymTable, pcKey,
+                                                 uLength),
+                                   NULL, pvValue, &iCreated);
+    if (psNode == NULL)
+        return NULL;
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &psNode->pvValue;
+}
 
 /* 
  * Checks if given key pcKey exists within oSymTable. 
  * Returns 1 if pcKey exists, if else returns 0 
  */
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
-    struct SymTableNode *psCurrentNode; 
-    size_t uHashIndex; 
+    size_t uLength;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
     
-    /* determine which bucket key is located in */
-    uHashIndex = SymTable_hash(pcKey, oSymTable->uNumBuckets); 
-
-    /* traverse chain of nodes to find node with matching key */
-    for (psCurrentNode = oSymTable->ppsBuckets[uHashIndex]; 
-        psCurrentNode != NULL; 
-        psCurrentNode = psCurrentNode->psNext) {
-            if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-                return 1; 
-        }
-    return 0; 
+    uLength = strlen(pcKey);
+    return SymTable_lookup(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL)
+           != NULL;
+}
+
+/*
+ * Checks if interned key oKey exists within oSymTable.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_lookup(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey)
+           != NULL;
 }
 
 /* 
@@ -303,22 +1181,163 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
  */
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
     struct SymTableNode *psCurrentNode;
-    size_t uHashIndex; 
+    size_t uLength;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    /* determine which bucket key is located in */
-    uHashIndex = SymTable_hash(pcKey, oSymTable->uNumBuckets);
+    uLength = strlen(pcKey);
+    psCurrentNode = SymTable_lookup(oSymTable, pcKey, uLength,
+                                    SymTable_hash(oSymTable, pcKey,
+                                                  uLength), NULL);
+    if (psCurrentNode == NULL)
+        return NULL;
+    return psCurrentNode->pvValue;
+}
 
-    /* find key by traversing bucket, return value */
-    for (psCurrentNode = oSymTable->ppsBuckets[uHashIndex];
-         psCurrentNode != NULL;
-         psCurrentNode = psCurrentNode->psNext) {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-            return psCurrentNode->pvValue;
+/*
+ * Returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
+ */
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
+    struct SymTableNode *psCurrentNode;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    psCurrentNode = SymTable_lookup(
+        oSymTable, oKey->acKey, oKey->uLength,
+        SymTable_handleHash(oSymTable, oKey), oKey);
+    if (psCurrentNode == NULL)
+        return NULL;
+    return psCurrentNode->pvValue;
+}
+
+/*
+ * Stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. The keys are taken BATCH_SIZE at a time: all of
+ * them are hashed and their buckets prefetched, then their chains
+ * are walked side by side, one node per key per round, with the
+ * next node of every chain prefetched before any is compared. The
+ * misses of up to BATCH_SIZE chains are then waited for together
+ * instead of one after another.
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    struct SymTableNode **appsBuckets[BATCH_SIZE];
+    struct SymTableNode *apsNodes[BATCH_SIZE];
+    size_t auHashes[BATCH_SIZE];
+    struct SymTableNode *psNode;
+    size_t uFirst;
+    size_t uCount;
+    size_t i;
+    int iPending;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+
+    for (uFirst = 0; uFirst < uNumKeys; uFirst += uCount) {
+        uCount = uNumKeys - uFirst;
+        if (uCount > BATCH_SIZE)
+            uCount = BATCH_SIZE;
+        /* the rehash advances as much as uCount lookups would */
+        SymTable_migrate(oSymTable, REHASH_STEP * uCount);
+
+        for (i = 0; i < uCount; i++) {
+            assert(apcKeys[uFirst + i] != NULL);
+            auHashes[i] = SymTable_hash(oSymTable, apcKeys[uFirst + i],
+                                        strlen(apcKeys[uFirst + i]));
+            apvValues[uFirst + i] = NULL;
+            /* a key the filter turns away needs no bucket */
+            if (!SymTable_mayContain(oSymTable, auHashes[i])) {
+                appsBuckets[i] = NULL;
+                continue;
+            }
+            appsBuckets[i] = SymTable_bucket(oSymTable, auHashes[i]);
+            __builtin_prefetch(appsBuckets[i]);
+        }
+        for (i = 0; i < uCount; i++) {
+            apsNodes[i] = (appsBuckets[i] != NULL) ? *appsBuckets[i]
+                                                   : NULL;
+            if (apsNodes[i] != NULL)
+                __builtin_prefetch(apsNodes[i]);
+        }
+
+        /* a chain drops out once its key is found or it ends */
+        do {
+            iPending = 0;
+            for (i = 0; i < uCount; i++) {
+                psNode = apsNodes[i];
+                if (psNode == NULL)
+                    continue;
+                if (psNode->uHash == auHashes[i]
+                    && strcmp(SymTable_nodeKey(psNode),
+                              apcKeys[uFirst + i]) == 0) {
+                    apvValues[uFirst + i] = psNode->pvValue;
+                    apsNodes[i] = NULL;
+                    continue;
+                }
+                apsNodes[i] = psNode->psNext;
+                if (apsNodes[i] != NULL) {
+                    __builtin_prefetch(apsNodes[i]);
+                    iPending = 1;
+                }
+            }
+        } while (iPending);
     }
-    return NULL; 
+}
+
+/*
+ * Helper function that removes the binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash and whose
+ * handle is oKey (NULL if unknown), from oSymTable. Returns the
+ * value of the removed binding, or NULL if the key did not exist.
+ */
+static void *SymTable_removeKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey) {
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode **ppsLink;
+    void *pvValue;
+
+    SymTable_migrate(oSymTable, REHASH_STEP);
+
+    /* find link to the node in the bucket key is located in */
+    ppsLink = SymTable_findLink(SymTable_bucket(oSymTable, uHash),
+                                pcKey, uLength, uHash, oKey);
+    psCurrentNode = *ppsLink;
+    if (psCurrentNode == NULL)
+        return NULL;
+
+    /* store value so that it can be returned after removal */
+    pvValue = psCurrentNode->pvValue;
+    *ppsLink = psCurrentNode->psNext;
+
+    /* node, key included, goes back to the table's pool */
+    SymTable_freeNode(oSymTable, psCurrentNode);
+
+    oSymTable->uNumBindings--;
+    /* the key's bits stay in the filter */
+    oSymTable->uNumStaleKeys++;
+
+    /* shrink a mostly empty table, so that SymTable_map and
+       SymTable_free do not walk empty buckets. a failed shrink only
+       leaves the table larger than it needs to be */
+    if (oSymTable->uNumBuckets > INITIAL_BUCKET_COUNT
+        && (double)oSymTable->uNumBindings / oSymTable->uNumBuckets
+           < SHRINK_FACTOR)
+        (void)SymTable_resize(oSymTable,
+            SymTable_bucketCountFor(oSymTable->uNumBindings * 2));
+
+    /* a filter full of removed keys lets too many misses through.
+       refilling it walks every bucket, which enough removes have
+       paid for */
+    if (oSymTable->puFilter != NULL
+        && (double)oSymTable->uNumStaleKeys / oSymTable->uNumBuckets
+           > FILTER_STALE_FACTOR)
+        SymTable_fillFilter(oSymTable);
+    return pvValue;
 }
 
 /* 
@@ -328,66 +1347,373 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
  * in oSymTable. return NULL otherwise. 
  */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
-    struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psPreviousNode = NULL;
-    size_t uHashIndex; 
-    void *pvValue; 
+    size_t uLength;
 
     assert (oSymTable != NULL); 
     assert (pcKey != NULL);
 
-    /* determine which bucket key is located in */
-    uHashIndex = SymTable_hash(pcKey, oSymTable->uNumBuckets); 
-
-    psCurrentNode = oSymTable->ppsBuckets[uHashIndex];
-    while (psCurrentNode != NULL) {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-            /* store value so that it can be returned after removal */
-            pvValue = psCurrentNode->pvValue;
-            
-            if (psPreviousNode == NULL) { /* head node case */
-                oSymTable->ppsBuckets[uHashIndex] 
-                = psCurrentNode->psNext;
-            } else {
-                psPreviousNode->psNext = psCurrentNode->psNext;
-            }
+    uLength = strlen(pcKey);
+    return SymTable_removeKey(oSymTable, pcKey, uLength,
+                              SymTable_hash(oSymTable, pcKey, uLength),
+                              NULL);
+}
+
+/*
+ * Removes binding associated with interned key oKey from
+ * oSymTable and frees memory. Return the value associated with
+ * the removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert (oSymTable != NULL);
+    assert (oKey != NULL);
+
+    return SymTable_removeKey(oSymTable, oKey->acKey, oKey->uLength,
+                              SymTable_handleHash(oSymTable, oKey),
+                              oKey);
+}
+
+/*
+ * Adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. The characters are copied, with a '\0' added.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    size_t uHash;
 
-            /* free memory for both key and node */
-            free(psCurrentNode->pcKey); 
-            free(psCurrentNode); 
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (uLength == (size_t)-1
+        || !SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength,
+                               &uHash))
+        return 0;
+    return SymTable_putKey(oSymTable, pcKey, uLength, uHash, NULL,
+                           pvValue);
+}
+
+/*
+ * Checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable, reading them in place.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
 
-            oSymTable->uNumBindings--; 
-            return pvValue; 
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return 0;
+    return SymTable_lookup(oSymTable, pcKey, uLength, uHash, NULL)
+           != NULL;
+}
+
+/*
+ * Returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, reading them
+ * in place. Returns NULL otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    struct SymTableNode *psCurrentNode;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    psCurrentNode = SymTable_lookup(oSymTable, pcKey, uLength, uHash,
+                                    NULL);
+    if (psCurrentNode == NULL)
+        return NULL;
+    return psCurrentNode->pvValue;
+}
+
+/*
+ * Removes binding associated with the key made of the uLength
+ * characters at pcKey from oSymTable and frees memory. Return the
+ * value associated with the removed key if it existed in
+ * oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+
+    assert (oSymTable != NULL);
+    assert (pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    return SymTable_removeKey(oSymTable, pcKey, uLength, uHash, NULL);
+}
+
+/* 
+ * Helper function that applies pfApply with pvExtra to every
+ * binding in the first uNumBuckets buckets of ppsBuckets.
+ */
+static void SymTable_mapChains(struct SymTableNode **ppsBuckets,
+    size_t uNumBuckets,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableNode *psCurrentNode;
+    size_t i;
+
+    for (i = 0; i < uNumBuckets; i++) {
+        psCurrentNode = ppsBuckets[i];
+        /* traverse each key value pair and apply pfApply with  */
+        while (psCurrentNode != NULL) {
+            (*pfApply)(SymTable_nodeKey(psCurrentNode),
+                       psCurrentNode->pvValue, (void *)pvExtra);
+            psCurrentNode = psCurrentNode->psNext;
         }
-        psPreviousNode = psCurrentNode;
-        psCurrentNode = psCurrentNode->psNext; 
     }
-    return NULL; 
 }
 
-/* 
+/*
+ * Adds new binding of pcKey, pvValue to oSymTable if the key pcKey
+ * doesn't exist in oSymTable, using uHash, the code SymTable_hashKey
+ * returns for pcKey, instead of hashing it again.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_givenHash(oSymTable, pcKey, uHash),
+                           NULL, pvValue);
+}
+
+/*
+ * Returns value associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    struct SymTableNode *psCurrentNode;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    psCurrentNode = SymTable_lookup(oSymTable, pcKey, uLength,
+                                    SymTable_givenHash(oSymTable, pcKey,
+                                                       uHash), NULL);
+    if (psCurrentNode == NULL)
+        return NULL;
+    return psCurrentNode->pvValue;
+}
+
+/*
+ * Removes binding associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, from oSymTable and frees memory. Return the value
+ * associated with the removed key if it existed in oSymTable.
+ * return NULL otherwise.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    size_t uLength;
+
+    assert (oSymTable != NULL);
+    assert (pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeKey(oSymTable, pcKey, uLength,
+                              SymTable_givenHash(oSymTable, pcKey,
+                                                 uHash), NULL);
+}
+
+/*
  * To each binding in oSymTable, apply function (pfApply) given by
  * the user. user is able to input additional parameter pvExtra
- * if needed for the user defined function. 
+ * if needed for the user defined function. During an incremental
+ * rehash, bindings in both bucket arrays are visited.
  */
 void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra) {
-    struct SymTableNode *psCurrentNode;
-    size_t i;
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    SymTable_mapChains(oSymTable->ppsBuckets, oSymTable->uNumBuckets,
+                       pfApply, pvExtra);
+    /* migrated old buckets are empty, so no binding is seen twice */
+    if (oSymTable->ppsOldBuckets != NULL)
+        SymTable_mapChains(oSymTable->ppsOldBuckets,
+                           oSymTable->uNumOldBuckets, pfApply, pvExtra);
+}
+
+/*
+ * Applies the function of mapping pvMapping to the bindings in the
+ * buckets uFirst to uLimit - 1 of its table, where the buckets of
+ * ppsBuckets come first and those of ppsOldBuckets after them.
+ */
+static void SymTable_mapBuckets(size_t uFirst, size_t uLimit,
+    void *pvMapping) {
+    struct SymTableMapping *psMapping = pvMapping;
+    SymTable_T oSymTable = psMapping->oSymTable;
+    size_t uNumBuckets = oSymTable->uNumBuckets;
+
+    if (uFirst < uNumBuckets) {
+        SymTable_mapChains(oSymTable->ppsBuckets + uFirst,
+                           (uLimit < uNumBuckets ? uLimit : uNumBuckets)
+                           - uFirst,
+                           psMapping->pfApply, psMapping->pvExtra);
+        uFirst = uNumBuckets;
+    }
+    if (uLimit > uFirst)
+        SymTable_mapChains(oSymTable->ppsOldBuckets
+                           + (uFirst - uNumBuckets), uLimit - uFirst,
+                           psMapping->pfApply, psMapping->pvExtra);
+}
+
+/*
+ * To each binding in oSymTable, apply function *pfApply with
+ * pvExtra as extra argument, in up to iThreadCount threads at once.
+ * The buckets of both arrays are split into runs, and a thread that
+ * is done with its own runs steals from the others, since chains
+ * differ in length. Pending rehash steps are left for later, so
+ * nothing in oSymTable is written meanwhile.
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    struct SymTableMapping sMapping;
 
     assert(oSymTable != NULL);
     assert(pfApply != NULL);
 
-    for (i = 0; i < oSymTable->uNumBuckets; i++) {
-        psCurrentNode = oSymTable->ppsBuckets[i]; 
-        /* traverse each key value pair and apply pfApply with  */
-        while (psCurrentNode != NULL) {
-            (*pfApply)(psCurrentNode->pcKey, 
-                       psCurrentNode->pvValue, (void *)pvExtra);
-            psCurrentNode = psCurrentNode->psNext;
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymTable_runParallel(oSymTable->uNumBuckets
+                         + oSymTable->uNumOldBuckets, MAP_GRAIN,
+                         iThreadCount, SymTable_mapBuckets, &sMapping);
+}
+
+/*
+ * To each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function *pfApply with pvExtra as extra
+ * argument, in key order. A NULL bound leaves that end open.
+ * Chains are scattered over the buckets by hash code, so every
+ * binding is looked at and those in range are sorted before
+ * pfApply sees them.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    return SymTable_mapSorted(oSymTable, pcLow, pcHigh, NULL, pfApply,
+                              pvExtra);
+}
+
+/*
+ * To each binding of oSymTable whose key starts with pcPrefix,
+ * apply function *pfApply with pvExtra as extra argument, in key
+ * order, collecting and sorting them like SymTable_mapRange.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    assert(pcPrefix != NULL);
+    return SymTable_mapSorted(oSymTable, NULL, NULL, pcPrefix, pfApply,
+                              pvExtra);
+}
+
+/*
+ * Opens cursor *psIter over the bindings of oSymTable. While any
+ * cursor is open, no node is migrated: a pending rehash waits, and
+ * a table that has to grow or shrink starts a rehash but keeps
+ * every node in the array it is in. The cursor walks ppsBuckets and
+ * then ppsOldBuckets, as they are when it gets to them, so it finds
+ * every node that stays in oSymTable exactly once. It holds the
+ * node it returns next, so removing the binding it returned last
+ * leaves it valid.
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    oSymTable->uNumCursors++;
+    psIter->oSymTable = oSymTable;
+    psIter->pvNode = NULL;
+    psIter->pvArray = oSymTable->ppsBuckets;
+    psIter->uIndex = 0;
+    psIter->uCount = oSymTable->uNumBuckets;
+}
+
+/*
+ * Moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. Returns 0 once every
+ * binding has been returned.
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    SymTable_T oSymTable;
+    struct SymTableNode **ppsBuckets;
+    struct SymTableNode *psCurrentNode;
+
+    assert(psIter != NULL);
+
+    oSymTable = psIter->oSymTable;
+    psCurrentNode = psIter->pvNode;
+    while (psCurrentNode == NULL) {
+        ppsBuckets = psIter->pvArray;
+        if (ppsBuckets == NULL)
+            return 0;
+        if (psIter->uIndex < psIter->uCount) {
+            psCurrentNode = ppsBuckets[psIter->uIndex++];
+            continue;
         }
 
+        /* the old array comes after the current one. an array that
+           became the old one while it was walked is finished */
+        if (ppsBuckets == oSymTable->ppsBuckets) {
+            psIter->pvArray = oSymTable->ppsOldBuckets;
+            psIter->uCount = oSymTable->uNumOldBuckets;
+        }
+        else
+            psIter->pvArray = NULL;
+        psIter->uIndex = 0;
     }
+    psIter->pvNode = psCurrentNode->psNext;
+
+    if (ppcKey != NULL)
+        *ppcKey = SymTable_nodeKey(psCurrentNode);
+    if (ppvValue != NULL)
+        *ppvValue = psCurrentNode->pvValue;
+    return 1;
+}
+
+/*
+ * Closes cursor *psIter. Once the last cursor of its table is
+ * closed, later operations migrate nodes again.
+ */
+void SymTable_end(struct SymTableIter *psIter) {
+    SymTable_T oSymTable;
+
+    assert(psIter != NULL);
+
+    oSymTable = psIter->oSymTable;
+    assert(oSymTable->uNumCursors > 0);
+    oSymTable->uNumCursors--;
 
+    /* without incremental rehashing, a held back rehash ends now */
+    if (REHASH_STEP == 0)
+        SymTable_migrate(oSymTable, oSymTable->uNumOldBuckets);
 }
@@ -0,0 +1,522 @@
+/*
+ * symtablekey.c
+ *
+ * Key hashing and interning shared by all symbol table
+ * implementations. functionalities include:
+ * - computing the hash code of a key string or of a key given by
+ *   its length with a multiply-and-fold hash keyed with a random
+ *   secret chosen once per process
+ * - hashing a key once for the *Hashed functions of every table
+ * - handing out random per-table seeds
+ * - interning key strings into canonical handles that carry
+ *   their hash code, so tables can compare them by address
+ * - visiting the bindings of a key range or prefix in key order,
+ *   for the implementations that keep their keys in no order
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "symtablekey.h"
+/* must be a power of two so indices can be reduced with a mask */
+#define INITIAL_POOL_BUCKET_COUNT 1024
+/* odd 64-bit multipliers that mix the secret and table seeds */
+#define HASH_MULTIPLIER_1 UINT64_C(0x9E3779B97F4A7C15)
+#define HASH_MULTIPLIER_2 UINT64_C(0xFF51AFD7ED558CCD)
+/* keys up to this many bytes are hashed with a single multiply */
+#define SHORT_KEY_LENGTH 16
+/* keys shorter than this are copied on the stack to be hashed by a
+   hash function that needs a '\0' */
+#define SLICE_BUFFER_SIZE 256
+/* number of bindings SymTable_mapSorted first makes room for */
+#define INITIAL_ENTRY_COUNT 64
+
+/* multiplier for Fibonacci hashing: 2^w divided by the golden ratio */
+#if SIZE_MAX > 0xFFFFFFFFu
+#define FIBONACCI_MULTIPLIER ((size_t)11400714819323198485u)
+#else
+#define FIBONACCI_MULTIPLIER ((size_t)2654435769u)
+#endif
+
+/* binding collected by SymTable_mapSorted */
+struct SymTableEntry {
+    /* key string */
+    const char *pcKey;
+    /* value for key */
+    void *pvValue;
+};
+
+/* intern pool: a separately chained hash set of every handle ever
+   created. handles are never freed, so they stay valid until the
+   program exits */
+static struct SymTableKey **ppsPoolBuckets = NULL;
+/* number of buckets in ppsPoolBuckets, a power of two */
+static size_t uPoolNumBuckets = 0;
+/* number of bits needed to index ppsPoolBuckets */
+static unsigned int uPoolBucketBits = 0;
+/* number of handles in the pool */
+static size_t uPoolNumKeys = 0;
+/* serializes every access to the intern pool */
+static pthread_mutex_t sPoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* 192-bit secret of the default hash function. every word of a key
+   is combined with part of it before being multiplied, so which keys
+   collide depends on it and cannot be found from the key strings
+   alone */
+static uint64_t auHashSecret[3] = {0, 0, 0};
+/* makes sure auHashSecret is chosen exactly once, even when the
+   first hash codes are computed by several threads at once. every
+   way of reaching SymTable_hashBytes from outside this module goes
+   through it first: table creation, interning, and
+   SymTable_hashKey */
+static pthread_once_t sHashSecretOnce = PTHREAD_ONCE_INIT;
+/* number of table seeds handed out so far, counted atomically */
+static uint64_t uNumSeeds = 0;
+
+/* Returns the 8 bytes at pucBytes as one word, in native byte order. */
+static uint64_t SymTable_loadWord(const unsigned char *pucBytes) {
+    uint64_t uWord;
+    /* compiles to a single unaligned load */
+    memcpy(&uWord, pucBytes, sizeof(uWord));
+    return uWord;
+}
+
+/* Returns the 4 bytes at pucBytes as one word, in native byte order. */
+static uint64_t SymTable_loadHalfWord(const unsigned char *pucBytes) {
+    uint32_t uHalfWord;
+    memcpy(&uHalfWord, pucBytes, sizeof(uHalfWord));
+    return uHalfWord;
+}
+
+/*
+ * Multiplies *puLow by *puHigh into a 128-bit product, and stores
+ * its low half at *puLow and its high half at *puHigh.
+ */
+static void SymTable_multiply(uint64_t *puLow, uint64_t *puHigh) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 uProduct = (unsigned __int128)*puLow * *puHigh;
+    *puLow = (uint64_t)uProduct;
+    *puHigh = (uint64_t)(uProduct >> 64);
+#else
+    /* schoolbook multiplication of 32-bit halves */
+    uint64_t uLowLow = (*puLow & 0xFFFFFFFF) * (*puHigh & 0xFFFFFFFF);
+    uint64_t uLowHigh = (*puLow & 0xFFFFFFFF) * (*puHigh >> 32);
+    uint64_t uHighLow = (*puLow >> 32) * (*puHigh & 0xFFFFFFFF);
+    uint64_t uHighHigh = (*puLow >> 32) * (*puHigh >> 32);
+    uint64_t uMiddle = (uLowLow >> 32) + (uLowHigh & 0xFFFFFFFF)
+                       + (uHighLow & 0xFFFFFFFF);
+    *puLow = (uLowLow & 0xFFFFFFFF) | (uMiddle << 32);
+    *puHigh = uHighHigh + (uLowHigh >> 32) + (uHighLow >> 32)
+              + (uMiddle >> 32);
+#endif
+}
+
+/*
+ * Returns the 128-bit product of uLeft and uRight folded to 64 bits
+ * by xoring its halves. Every bit of either factor affects the
+ * middle bits of the result.
+ */
+static uint64_t SymTable_fold(uint64_t uLeft, uint64_t uRight) {
+    SymTable_multiply(&uLeft, &uRight);
+    return uLeft ^ uRight;
+}
+
+/* Returns random state uState with the bits of uWord mixed in. */
+static uint64_t SymTable_mixWord(uint64_t uState, uint64_t uWord) {
+    uState = (uState ^ uWord) * HASH_MULTIPLIER_1;
+    return uState ^ (uState >> 32);
+}
+
+/*
+ * Returns random state uState avalanched, so that every bit of it
+ * affects every bit of the secret or seed made from it.
+ */
+static uint64_t SymTable_finish(uint64_t uState) {
+    uState ^= uState >> 33;
+    uState *= HASH_MULTIPLIER_2;
+    uState ^= uState >> 29;
+    return uState;
+}
+
+/*
+ * Chooses auHashSecret. Reads it from /dev/urandom where that
+ * exists, and mixes in the time and an address, which differs from
+ * run to run under address space layout randomization, either way.
+ */
+static void SymTable_initSecret(void) {
+    FILE *psRandom;
+    uint64_t auRandom[2] = {0, 0};
+    uint64_t uNoise;
+
+    psRandom = fopen("/dev/urandom", "rb");
+    if (psRandom != NULL) {
+        if (fread(auRandom, sizeof(auRandom), 1, psRandom) != 1) {
+            auRandom[0] = 0;
+            auRandom[1] = 0;
+        }
+        fclose(psRandom);
+    }
+    uNoise = SymTable_mixWord(0, (uint64_t)time(NULL));
+    uNoise = SymTable_mixWord(uNoise, (uint64_t)clock());
+    uNoise = SymTable_mixWord(uNoise, (uint64_t)(uintptr_t)&uNoise);
+
+    auHashSecret[0] = SymTable_finish(SymTable_mixWord(auRandom[0],
+                                                       uNoise));
+    auHashSecret[1] = SymTable_finish(SymTable_mixWord(auRandom[1],
+                                                       ~uNoise));
+    auHashSecret[2] = SymTable_finish(auHashSecret[0]
+                                      ^ auHashSecret[1]
+                                      ^ HASH_MULTIPLIER_2);
+}
+
+/*
+ * Returns a fresh random seed for a new table. Successive seeds are
+ * the secret-keyed avalanche of a counter, so no two tables in the
+ * process share one, even when threads create tables at once.
+ */
+size_t SymTable_newSeed(void) {
+    uint64_t uNumber;
+
+    pthread_once(&sHashSecretOnce, SymTable_initSecret);
+    uNumber = __atomic_add_fetch(&uNumSeeds, 1, __ATOMIC_RELAXED);
+    return (size_t)SymTable_finish(auHashSecret[0]
+                                   + uNumber * HASH_MULTIPLIER_1);
+}
+
+/*
+ * Compute hash code for the key made of the uLength characters at
+ * pcKey, which need not be followed by '\0'.
+ * Return the full size_t hash code, in the style of wyhash: each
+ * 16-byte block of the key is split into two words, each combined
+ * with a word of the process's secret or of the running state, and
+ * the two are multiplied into 128 bits and folded back to 64. Keys
+ * of up to 16 bytes, the usual identifiers, are read with at most
+ * four overlapping loads and take a single multiply before the
+ * final one. Since the secret enters every product, keys that
+ * collide under one secret do not under another. Unlike SipHash,
+ * this is not a cryptographic function: it resists collisions
+ * crafted without the secret, but someone who can observe many hash
+ * codes might learn enough about the secret to craft them. Whole
+ * words are read in native byte order, so hash codes differ between
+ * little- and big-endian machines. The secret must have been chosen
+ * already, by SymTable_newSeed, SymTable_intern or SymTable_hashKey.
+ */
+size_t SymTable_hashBytes(const char *pcKey, size_t uLength) {
+    const unsigned char *pucBytes = (const unsigned char *)pcKey;
+    uint64_t uState = auHashSecret[0];
+    uint64_t uFirst;
+    uint64_t uSecond;
+    size_t uRemaining;
+    size_t uOffset;
+
+    assert(pcKey != NULL);
+
+    if (uLength <= SHORT_KEY_LENGTH) {
+        if (uLength >= 4) {
+            /* 4 to 16 bytes: four loads, overlapping if need be */
+            uOffset = (uLength >> 3) << 2;
+            uFirst = (SymTable_loadHalfWord(pucBytes) << 32)
+                     | SymTable_loadHalfWord(pucBytes + uOffset);
+            uSecond = (SymTable_loadHalfWord(pucBytes + uLength - 4)
+                       << 32)
+                      | SymTable_loadHalfWord(pucBytes + uLength - 4
+                                              - uOffset);
+        }
+        else if (uLength > 0) {
+            uFirst = ((uint64_t)pucBytes[0] << 16)
+                     | ((uint64_t)pucBytes[uLength >> 1] << 8)
+                     | pucBytes[uLength - 1];
+            uSecond = 0;
+        }
+        else {
+            uFirst = 0;
+            uSecond = 0;
+        }
+    }
+    else {
+        for (uRemaining = uLength; uRemaining > SHORT_KEY_LENGTH;
+             uRemaining -= 16) {
+            uState = SymTable_fold(
+                SymTable_loadWord(pucBytes) ^ auHashSecret[1],
+                SymTable_loadWord(pucBytes + 8) ^ uState);
+            pucBytes += 16;
+        }
+        /* the last 16 bytes, overlapping the last block if need be */
+        uFirst = SymTable_loadWord(pucBytes + uRemaining - 16);
+        uSecond = SymTable_loadWord(pucBytes + uRemaining - 8);
+    }
+
+    uFirst ^= auHashSecret[1];
+    uSecond ^= uState;
+    SymTable_multiply(&uFirst, &uSecond);
+    return (size_t)SymTable_fold(uFirst ^ auHashSecret[0]
+                                 ^ (uint64_t)uLength,
+                                 uSecond ^ auHashSecret[2]);
+}
+
+/*
+ * Compute hash code for given key string pcKey: the hash code of
+ * its characters up to the '\0'.
+ */
+size_t SymTable_hashString(const char *pcKey) {
+    assert(pcKey != NULL);
+    return SymTable_hashBytes(pcKey, strlen(pcKey));
+}
+
+/*
+ * Returns the hash code of key string pcKey for the *Hashed
+ * functions: the default hash code, which is also the one interned
+ * handles carry.
+ */
+size_t SymTable_hashKey(const char *pcKey) {
+    pthread_once(&sHashSecretOnce, SymTable_initSecret);
+    return SymTable_hashString(pcKey);
+}
+
+/*
+ * Stores at *puHash the code pfHash gives the key made of the
+ * uLength characters at pcKey. The default hash function reads the
+ * characters in place; any other needs a '\0'-terminated copy,
+ * which is made on the stack for short keys. Returns 1 if
+ * successful and 0 if memory allocation fails.
+ */
+int SymTable_hashSlice(size_t (*pfHash)(const char *pcKey),
+    const char *pcKey, size_t uLength, size_t *puHash) {
+    char acBuffer[SLICE_BUFFER_SIZE];
+    char *pcCopy = acBuffer;
+
+    assert(pfHash != NULL);
+    assert(pcKey != NULL);
+    assert(puHash != NULL);
+
+    if (pfHash == SymTable_hashString) {
+        *puHash = SymTable_hashBytes(pcKey, uLength);
+        return 1;
+    }
+
+    if (uLength >= SLICE_BUFFER_SIZE) {
+        if (uLength == (size_t)-1)
+            return 0;
+        pcCopy = malloc(uLength + 1);
+        if (pcCopy == NULL)
+            return 0;
+    }
+    memcpy(pcCopy, pcKey, uLength);
+    pcCopy[uLength] = '\0';
+    *puHash = (*pfHash)(pcCopy);
+    if (pcCopy != acBuffer)
+        free(pcCopy);
+    return 1;
+}
+
+/*
+ * Returns 1 if key string pcStored equals the key made of the
+ * uLength characters at pcKey, and 0 otherwise. At most uLength
+ * characters at pcKey are read.
+ */
+int SymTable_keyEquals(const char *pcStored, const char *pcKey,
+    size_t uLength) {
+    return strncmp(pcStored, pcKey, uLength) == 0
+           && pcStored[uLength] == '\0';
+}
+
+/*
+ * Returns the pool bucket of hash code uHash, using the top bits of
+ * the hash code scrambled by Fibonacci hashing.
+ */
+static size_t SymTable_poolBucket(size_t uHash) {
+    return (uHash * FIBONACCI_MULTIPLIER)
+           >> (sizeof(size_t) * 8 - uPoolBucketBits);
+}
+
+/*
+ * Helper function that sets the intern pool up with uNumBuckets
+ * buckets, moving every handle into its new bucket. Returns 1 if
+ * successful and 0 if memory allocation fails, in which case the
+ * pool is unchanged.
+ */
+static int SymTable_resizePool(size_t uNumBuckets) {
+    struct SymTableKey **ppsOldBuckets = ppsPoolBuckets;
+    size_t uOldNumBuckets = uPoolNumBuckets;
+    struct SymTableKey *psKey;
+    struct SymTableKey *psNextKey;
+    size_t uIndex;
+    size_t i;
+
+    ppsPoolBuckets = calloc(uNumBuckets, sizeof(struct SymTableKey *));
+    if (ppsPoolBuckets == NULL) {
+        ppsPoolBuckets = ppsOldBuckets;
+        return 0;
+    }
+    uPoolNumBuckets = uNumBuckets;
+    uPoolBucketBits = 0;
+    while (((size_t)1 << uPoolBucketBits) < uNumBuckets)
+        uPoolBucketBits++;
+
+    /* cached hash codes avoid touching the key bytes */
+    for (i = 0; i < uOldNumBuckets; i++) {
+        for (psKey = ppsOldBuckets[i]; psKey != NULL;
+             psKey = psNextKey) {
+            psNextKey = psKey->psNext;
+            uIndex = SymTable_poolBucket(psKey->uHash);
+            psKey->psNext = ppsPoolBuckets[uIndex];
+            ppsPoolBuckets[uIndex] = psKey;
+        }
+    }
+    free(ppsOldBuckets);
+    return 1;
+}
+
+/*
+ * Returns the canonical handle for key string pcKey, creating it
+ * if pcKey has not been interned before. Returns NULL if memory
+ * allocation fails. Must be called with sPoolLock held.
+ */
+static SymTableKey_T SymTable_internLocked(const char *pcKey) {
+    struct SymTableKey *psKey;
+    size_t uHash;
+    size_t uLength;
+    size_t uIndex;
+
+    assert(pcKey != NULL);
+
+    if (ppsPoolBuckets == NULL
+        && !SymTable_resizePool(INITIAL_POOL_BUCKET_COUNT))
+        return NULL;
+
+    /* return the existing handle if there is one */
+    uHash = SymTable_hashString(pcKey);
+    uIndex = SymTable_poolBucket(uHash);
+    for (psKey = ppsPoolBuckets[uIndex]; psKey != NULL;
+         psKey = psKey->psNext) {
+        if (psKey->uHash == uHash && strcmp(psKey->acKey, pcKey) == 0)
+            return psKey;
+    }
+
+    /* keep about one handle per bucket; a failed resize only
+       makes chains longer */
+    if (uPoolNumKeys >= uPoolNumBuckets
+        && uPoolNumBuckets <= ((size_t)-1) / 2
+                              / sizeof(struct SymTableKey *)
+        && SymTable_resizePool(uPoolNumBuckets * 2))
+        uIndex = SymTable_poolBucket(uHash);
+
+    uLength = strlen(pcKey);
+    psKey = malloc(sizeof(struct SymTableKey) + uLength + 1);
+    if (psKey == NULL)
+        return NULL;
+    memcpy(psKey->acKey, pcKey, uLength + 1);
+    psKey->uHash = uHash;
+    psKey->uLength = uLength;
+    psKey->psNext = ppsPoolBuckets[uIndex];
+    ppsPoolBuckets[uIndex] = psKey;
+    uPoolNumKeys++;
+    return psKey;
+}
+
+/*
+ * Returns the canonical handle for key string pcKey, creating it
+ * if pcKey has not been interned before. Returns NULL if memory
+ * allocation fails. Safe to call from any number of threads.
+ */
+SymTableKey_T SymTable_intern(const char *pcKey) {
+    SymTableKey_T oKey;
+
+    assert(pcKey != NULL);
+
+    pthread_once(&sHashSecretOnce, SymTable_initSecret);
+    pthread_mutex_lock(&sPoolLock);
+    oKey = SymTable_internLocked(pcKey);
+    pthread_mutex_unlock(&sPoolLock);
+    return oKey;
+}
+
+/* Returns the key string of handle oKey. */
+const char *SymTable_keyString(SymTableKey_T oKey) {
+    assert(oKey != NULL);
+    return oKey->acKey;
+}
+
+/*
+ * Compares the keys of the entries at pvFirst and pvSecond with
+ * strcmp, for qsort.
+ */
+static int SymTable_compareEntries(const void *pvFirst,
+    const void *pvSecond) {
+    return strcmp(((const struct SymTableEntry *)pvFirst)->pcKey,
+                  ((const struct SymTableEntry *)pvSecond)->pcKey);
+}
+
+/*
+ * Applies pfApply, with pvExtra, to the bindings of oSymTable whose
+ * keys are at least pcLow, less than pcHigh and start with
+ * pcPrefix, in key order; a NULL bound or prefix matches every key.
+ * The bindings are collected with a cursor, which is kept open
+ * until pfApply has been applied to all of them, so that the keys
+ * of a thread-safe table stay readable even if other threads remove
+ * them meanwhile. Returns 1 if successful, and 0 if memory
+ * allocation fails, in which case pfApply is not applied at all.
+ */
+int SymTable_mapSorted(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableIter sIter;
+    struct SymTableEntry *psEntries;
+    struct SymTableEntry *psMore;
+    size_t uNumEntries = 0;
+    size_t uMaxEntries = INITIAL_ENTRY_COUNT;
+    size_t uPrefixLength = 0;
+    const char *pcKey;
+    void *pvValue;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (pcPrefix != NULL)
+        uPrefixLength = strlen(pcPrefix);
+    psEntries = malloc(uMaxEntries * sizeof(struct SymTableEntry));
+    if (psEntries == NULL)
+        return 0;
+
+    SymTable_begin(oSymTable, &sIter);
+    while (SymTable_next(&sIter, &pcKey, &pvValue)) {
+        if ((pcLow != NULL && strcmp(pcKey, pcLow) < 0)
+            || (pcHigh != NULL && strcmp(pcKey, pcHigh) >= 0)
+            || (pcPrefix != NULL
+                && strncmp(pcKey, pcPrefix, uPrefixLength) != 0))
+            continue;
+        if (uNumEntries == uMaxEntries) {
+            psMore = NULL;
+            if (uMaxEntries <= ((size_t)-1) / 2
+                               / sizeof(struct SymTableEntry))
+                psMore = realloc(psEntries, 2 * uMaxEntries
+                                 * sizeof(struct SymTableEntry));
+            if (psMore == NULL) {
+                SymTable_end(&sIter);
+                free(psEntries);
+                return 0;
+            }
+            psEntries = psMore;
+            uMaxEntries *= 2;
+        }
+        psEntries[uNumEntries].pcKey = pcKey;
+        psEntries[uNumEntries].pvValue = pvValue;
+        uNumEntries++;
+    }
+
+    qsort(psEntries, uNumEntries, sizeof(struct SymTableEntry),
+          SymTable_compareEntries);
+    for (i = 0; i < uNumEntries; i++)
+        (*pfApply)(psEntries[i].pcKey, psEntries[i].pvValue,
+                   (void *)pvExtra);
+
+    SymTable_end(&sIter);
+    free(psEntries);
+    return 1;
+}
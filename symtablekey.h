@@ -0,0 +1,87 @@
+/*
+ * symtablekey.h
+ *
+ * Private interface shared by the symbol table implementations
+ * and symtablekey.c. Not for clients; they use symtable.h.
+ * Provides:
+ * - the layout of interned key handles (SymTableKey_T)
+ * - the string hash function every implementation uses, so that
+ *   a handle's precomputed hash matches the hash of its string
+ * - hashing and comparing keys given by their length
+ * - random per-table seeds
+ * - visiting bindings in key order, for the implementations that
+ *   keep their keys in no order
+ */
+
+#ifndef SYMTABLEKEY_INCLUDED
+#define SYMTABLEKEY_INCLUDED
+
+#include <stddef.h>
+#include "symtable.h"
+
+/* canonical copy of a key string, created by SymTable_intern */
+struct SymTableKey {
+    /* SymTable_hashString of acKey */
+    size_t uHash;
+    /* number of characters in acKey, not counting '\0' */
+    size_t uLength;
+    /* pointer to next handle in the intern pool's bucket */
+    struct SymTableKey *psNext;
+    /* key string, stored inline */
+    char acKey[];
+};
+
+/*
+ * returns the full hash code of key string pcKey: a multiply-and-fold
+ * hash keyed with a secret chosen at random once per process. this is
+ * the default hash function of every table, and implementations reduce
+ * it to a bucket or slot index themselves. the secret is chosen when
+ * the first table is created or the first key interned or hashed with
+ * SymTable_hashKey
+ */
+size_t SymTable_hashString(const char *pcKey);
+
+/*
+ * returns SymTable_hashString of the key made of the uLength
+ * characters at pcKey, which need not be followed by '\0'
+ */
+size_t SymTable_hashBytes(const char *pcKey, size_t uLength);
+
+/*
+ * stores at *puHash the code hash function pfHash gives the key
+ * made of the uLength characters at pcKey. returns 1 if successful
+ * and 0 if memory allocation fails
+ */
+int SymTable_hashSlice(size_t (*pfHash)(const char *pcKey),
+    const char *pcKey, size_t uLength, size_t *puHash);
+
+/*
+ * returns 1 if key string pcStored equals the key made of the
+ * uLength characters at pcKey, and 0 otherwise
+ */
+int SymTable_keyEquals(const char *pcStored, const char *pcKey,
+    size_t uLength);
+
+/*
+ * returns a new random seed. each table mixes its own seed into
+ * every bucket or slot index, which varies its layout from other
+ * tables. keys whose full hash codes collide still collide, so only
+ * the keyed default hash function protects against chosen keys
+ */
+size_t SymTable_newSeed(void);
+
+/*
+ * applies pfApply, with pvExtra, to the bindings of oSymTable whose
+ * keys are at least pcLow, less than pcHigh and start with
+ * pcPrefix, in key order; a NULL bound or prefix matches every key.
+ * the bindings are collected with a cursor and sorted, so this
+ * takes time linear in the size of oSymTable. returns 1 if
+ * successful and 0 if memory allocation fails, in which case
+ * pfApply is not applied at all
+ */
+int SymTable_mapSorted(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+#endif
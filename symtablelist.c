@@ -6,22 +6,36 @@
  * - creating and deleting a symbol table 
  * - adding and removing key-value pairs
  * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
  * - applying a user-defined function to each entry 
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - moving the keys looked up most toward the front of the list
  */
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include "symtable.h"
+#include "symtablekey.h"
 
-/* binding that stores pcKey, pvValue, and psNext */
+/* binding that stores pvValue, psNext, and the key. the node and
+   its key are one allocation, with the key stored inline at the end */
 struct SymTableNode {
-    /* key string */
-    char *pcKey;
     /* value for key */
     void *pvValue;
     /* pointer to next node */
     struct SymTableNode *psNext;
+    /* handle the binding was put with, or NULL if it was put with
+       a key string. if not NULL, acKey is empty and the key string
+       is the handle's */
+    SymTableKey_T oKey;
+    /* key string */
+    char acKey[];
 };
 
 /* symbol table that consists of binding nodes */
@@ -30,8 +44,97 @@ struct SymTable {
     struct SymTableNode *psFirst;
     /* stores symbol table's number of bindings */
     size_t uNumBindings; 
+    /* SYMTABLE_POLICY_* by which lookups reorder the list */
+    int iPolicy;
+    /* number of cursors open and maps under way on the table; while
+       there are any, lookups leave the order of the list alone, so
+       that the walks neither skip nor repeat a binding */
+    size_t uNumWalks;
 }; 
 
+/* returns the key string of the binding stored in psNode */
+static const char *SymTable_nodeKey(const struct SymTableNode *psNode) {
+    if (psNode->oKey != NULL)
+        return psNode->oKey->acKey;
+    return psNode->acKey;
+}
+
+/*
+ * returns 1 if psNode holds the key made of the uLength characters
+ * at pcKey, whose handle is oKey (NULL if the caller only has the
+ * characters), and 0 otherwise. two handles are compared by
+ * address, since equal strings intern to the same handle
+ */
+static int SymTable_isKey(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey) {
+    if (oKey != NULL && psNode->oKey != NULL)
+        return psNode->oKey == oKey;
+    return SymTable_keyEquals(SymTable_nodeKey(psNode), pcKey, uLength);
+}
+
+/*
+ * returns the node of oSymTable holding the key made of the uLength
+ * characters at pcKey, with handle oKey (NULL if unknown), or NULL
+ * if there is none
+ */
+static struct SymTableNode *SymTable_findNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey) {
+    struct SymTableNode *psCurrentNode;
+
+    for (psCurrentNode = oSymTable->psFirst;
+    psCurrentNode != NULL;
+    psCurrentNode = psCurrentNode->psNext) {
+        if (SymTable_isKey(psCurrentNode, pcKey, uLength, oKey))
+            return psCurrentNode;
+    }
+    return NULL;
+}
+
+/*
+ * returns the node of oSymTable holding the key made of the uLength
+ * characters at pcKey, with handle oKey (NULL if unknown), or NULL
+ * if there is none, like SymTable_findNode, but as a lookup of the
+ * key it also moves the node by the policy of oSymTable: to the
+ * front of the list, or one place forward, swapping it with the
+ * node before it. the list is walked with the address of the link
+ * to each node, and that of the link before it, so either move is
+ * a matter of relinking
+ */
+static struct SymTableNode *SymTable_lookupNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey) {
+    struct SymTableNode **ppsLink = &oSymTable->psFirst;
+    struct SymTableNode **ppsPreviousLink = NULL;
+    struct SymTableNode *psCurrentNode;
+
+    if (oSymTable->iPolicy == SYMTABLE_POLICY_STATIC)
+        return SymTable_findNode(oSymTable, pcKey, uLength, oKey);
+
+    for (psCurrentNode = *ppsLink;
+    psCurrentNode != NULL;
+    psCurrentNode = *ppsLink) {
+        if (SymTable_isKey(psCurrentNode, pcKey, uLength, oKey))
+            break;
+        ppsPreviousLink = ppsLink;
+        ppsLink = &psCurrentNode->psNext;
+    }
+
+    /* a node already at the front stays there */
+    if (psCurrentNode == NULL || ppsPreviousLink == NULL
+        || oSymTable->uNumWalks > 0)
+        return psCurrentNode;
+
+    *ppsLink = psCurrentNode->psNext;
+    if (oSymTable->iPolicy == SYMTABLE_POLICY_MOVE_TO_FRONT) {
+        psCurrentNode->psNext = oSymTable->psFirst;
+        oSymTable->psFirst = psCurrentNode;
+    }
+    else {
+        psCurrentNode->psNext = *ppsPreviousLink;
+        *ppsPreviousLink = psCurrentNode;
+    }
+    return psCurrentNode;
+}
+
 /* creates a empty SymTable, allocates memory for it, 
    and returns it */
 SymTable_T SymTable_new(void) {
@@ -44,9 +147,67 @@ SymTable_T SymTable_new(void) {
     /* initialize all members of the structure */
     oSymTable->psFirst = NULL;
     oSymTable->uNumBindings = 0;
+    oSymTable->iPolicy = SYMTABLE_POLICY_STATIC;
+    oSymTable->uNumWalks = 0;
     return oSymTable;
 }
 
+/* creates a empty SymTable like SymTable_new. a linked list does
+   not hash its keys, so pfHash is accepted and ignored */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    assert(pfHash != NULL);
+    /* the list compares keys one by one and never hashes them */
+    (void)pfHash;
+    return SymTable_new();
+}
+
+/* creates a empty SymTable like SymTable_new. a linked list grows
+   one node at a time, so uCapacity is accepted and ignored */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    (void)uCapacity;
+    return SymTable_new();
+}
+
+/* a linked list has no room to make in advance, so this does
+   nothing and returns 1 */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    assert(oSymTable != NULL);
+    (void)uCapacity;
+    return 1;
+}
+
+/* a linked list holds nothing but its bindings, so this does
+   nothing and returns 1 */
+int SymTable_compact(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return 1;
+}
+
+/*
+ * makes the lookups of oSymTable reorder its list by iPolicy from
+ * now on. a short list whose lookups favor a few keys comes to hold
+ * them near the front, where a lookup finds them after few key
+ * comparisons
+ */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    assert(iPolicy == SYMTABLE_POLICY_STATIC
+           || iPolicy == SYMTABLE_POLICY_MOVE_TO_FRONT
+           || iPolicy == SYMTABLE_POLICY_TRANSPOSE);
+    oSymTable->iPolicy = iPolicy;
+}
+
+/*
+ * A list keeps no hash codes, so a filter would have every put and
+ * lookup hash its key, and a list is meant for few keys anyway;
+ * iEnable is accepted and ignored.
+ */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+    (void)iEnable;
+    return 1;
+}
+
 /* frees memory needed for the SymTable */
 void SymTable_free(SymTable_T oSymTable) {
     struct SymTableNode *psCurrentNode;
@@ -59,7 +220,6 @@ void SymTable_free(SymTable_T oSymTable) {
     psCurrentNode != NULL;
     psCurrentNode = psNextNode) {
         psNextNode = psCurrentNode->psNext;
-        free(psCurrentNode->pcKey);
         free(psCurrentNode);
     }
 
@@ -73,45 +233,103 @@ size_t SymTable_getLength(SymTable_T oSymTable) {
 }
 
 /* 
- * adds new binding of pcKey, pvValue to symbol table (oSymTable) 
- * if the key pcKey doesn't exist in oSymTable. 
- * returns 1 if binding was added, returns 0 if memory allocation 
- * fails or key already exists in oSymTable 
+ * adds a binding of the key made of the uLength characters at
+ * pcKey and pvValue to the front of oSymTable, which must not
+ * contain the key. if oKey is not NULL, pcKey is its string and
+ * the node refers to the handle instead of copying it. returns the
+ * new node, or NULL if memory allocation fails
  */
-int SymTable_put(SymTable_T oSymTable, 
-    const char *pcKey, const void *pvValue) {
+static struct SymTableNode *SymTable_addNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey,
+    const void *pvValue) {
     struct SymTableNode *psNewNode;
-    struct SymTableNode *psCurrentNode;
-
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    size_t uKeySize;
 
-    /* check if there exists a duplicate key */
-    for (psCurrentNode = oSymTable->psFirst; 
-    psCurrentNode != NULL;
-    psCurrentNode = psCurrentNode->psNext) {
-        if (strcmp(psCurrentNode->pcKey, pcKey) == 0)
-            return 0; 
-    }
-
-    /* new node */
-    psNewNode = malloc(sizeof(struct SymTableNode));
+    /* new node, with room for the key's defensive copy. a handle
+       already is a stable copy, so an interned key is not copied */
+    if (oKey == NULL && uLength == (size_t)-1)
+        return NULL;
+    uKeySize = (oKey != NULL) ? 1 : uLength + 1;
+    psNewNode = malloc(sizeof(struct SymTableNode) + uKeySize);
     if (psNewNode == NULL)
-        return 0;
-
-    /* key's defensive copy */
-    psNewNode->pcKey = malloc(strlen(pcKey) + 1);
-    if (psNewNode->pcKey == NULL) {
-        free(psNewNode);
-        return 0;
+        return NULL;
+    if (oKey != NULL)
+        psNewNode->acKey[0] = '\0';
+    else {
+        memcpy(psNewNode->acKey, pcKey, uLength);
+        psNewNode->acKey[uLength] = '\0';
     }
-    strcpy(psNewNode->pcKey, pcKey);
 
     psNewNode->pvValue = (void *)pvValue;
+    psNewNode->oKey = oKey;
     psNewNode->psNext = oSymTable->psFirst;
     oSymTable->psFirst = psNewNode;
     oSymTable->uNumBindings++;
-    return 1;
+    return psNewNode;
+}
+
+/*
+ * adds a binding of the key made of the uLength characters at
+ * pcKey and pvValue to oSymTable if the key doesn't exist in
+ * oSymTable. if oKey is not NULL, pcKey is its string and the node
+ * refers to the handle instead of copying it.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, SymTableKey_T oKey, const void *pvValue) {
+    /* check if there exists a duplicate key */
+    if (SymTable_findNode(oSymTable, pcKey, uLength, oKey) != NULL)
+        return 0;
+
+    return SymTable_addNode(oSymTable, pcKey, uLength, oKey, pvValue)
+           != NULL;
+}
+
+/*
+ * adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_putKey(oSymTable, pcKey, strlen(pcKey), NULL,
+                           pvValue);
+}
+
+/*
+ * adds new binding of interned key oKey, pvValue to oSymTable if
+ * the key doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength, oKey,
+                           pvValue);
+}
+
+/*
+ * replaces the value of psNode with pvValue and returns the old
+ * value. returns NULL if psNode is NULL
+ */
+static void *SymTable_replaceNode(struct SymTableNode *psNode,
+    const void *pvValue) {
+    void *pvOldValue;
+
+    if (psNode == NULL)
+        return NULL;
+
+    pvOldValue = psNode->pvValue;
+    psNode->pvValue = (void *)pvValue;
+    return pvOldValue;
 }
 
 /* 
@@ -122,24 +340,58 @@ int SymTable_put(SymTable_T oSymTable,
  */
 void *SymTable_replace(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue) {
-    
-    struct SymTableNode *psCurrentNode;
-    void *pvOldValue; 
     assert(oSymTable != NULL);
     assert(pcKey != NULL); 
 
-    /* traverse list to find node that matches pcKey, 
-       replace value with pvValue, return old value */
-    for (psCurrentNode = oSymTable -> psFirst; 
-    psCurrentNode != NULL; 
-    psCurrentNode = psCurrentNode->psNext) {
-        if (strcmp(psCurrentNode -> pcKey, pcKey) == 0) {
-            pvOldValue = psCurrentNode->pvValue;
-            psCurrentNode->pvValue = (void *)pvValue; 
-            return pvOldValue;
-        }
+    return SymTable_replaceNode(
+        SymTable_lookupNode(oSymTable, pcKey, strlen(pcKey), NULL),
+        pvValue);
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_replaceNode(
+        SymTable_lookupNode(oSymTable, oKey->acKey, oKey->uLength,
+                            oKey),
+        pvValue);
+}
+
+/*
+ * returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. the list is walked only once.
+ * returns NULL if memory allocation fails
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    struct SymTableNode *psNode;
+    size_t uLength;
+    int iCreated = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    psNode = SymTable_lookupNode(oSymTable, pcKey, uLength, NULL);
+    if (psNode == NULL) {
+        psNode = SymTable_addNode(oSymTable, pcKey, uLength, NULL,
+                                  pvValue);
+        if (psNode == NULL)
+            return NULL;
+        iCreated = 1;
     }
-    return NULL; 
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &psNode->pvValue;
 }
 
 /* 
@@ -147,17 +399,22 @@ void *SymTable_replace(SymTable_T oSymTable,
  * returns 1 if pcKey exists, if else returns 0 
  */
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
-    struct SymTableNode *psCurrentNode;
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
-    for (psCurrentNode = oSymTable->psFirst; 
-        psCurrentNode != NULL; 
-        psCurrentNode = psCurrentNode->psNext) {
-            if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-                return 1; 
-                }
-    }
-    return 0; 
+    return SymTable_lookupNode(oSymTable, pcKey, strlen(pcKey), NULL)
+           != NULL;
+}
+
+/*
+ * checks if interned key oKey exists within oSymTable.
+ * returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    return SymTable_lookupNode(oSymTable, oKey->acKey, oKey->uLength,
+                               oKey) != NULL;
 }
 
 /* 
@@ -169,37 +426,63 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
     struct SymTableNode *psCurrentNode;
     assert(oSymTable != NULL); 
     assert(pcKey != NULL); 
-    /* traverse list to find node that matches pcKey, return value */
-    for (psCurrentNode = oSymTable->psFirst;
-        psCurrentNode != NULL; 
-        psCurrentNode = psCurrentNode->psNext) {
-            if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-                return psCurrentNode->pvValue; 
-            }
-    }
-    return NULL; 
+    psCurrentNode = SymTable_lookupNode(oSymTable, pcKey, strlen(pcKey),
+                                        NULL);
+    if (psCurrentNode == NULL)
+        return NULL;
+    return psCurrentNode->pvValue;
 }
 
 /* 
- * removes binding associated with given pcKey from the
- * symbol table (oSymTable) and frees memory.
- * return value associated with removed key if key existed
- * in oSymTable. return NULL otherwise. 
+ * returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
  */
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
     struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psPreviousNode = NULL;
-    void *pvValue;
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    psCurrentNode = SymTable_lookupNode(oSymTable, oKey->acKey,
+                                        oKey->uLength, oKey);
+    if (psCurrentNode == NULL)
+        return NULL;
+    return psCurrentNode->pvValue;
+}
 
+/*
+ * stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. every lookup walks the same list from its head,
+ * so there are no independent misses to overlap and the keys are
+ * simply looked up in turn
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    size_t i;
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+    for (i = 0; i < uNumKeys; i++)
+        apvValues[i] = SymTable_get(oSymTable, apcKeys[i]);
+}
+
+/*
+ * removes binding of the key made of the uLength characters at
+ * pcKey, with handle oKey (NULL if unknown), from oSymTable and
+ * frees memory. return value associated with removed key if key
+ * existed in oSymTable. return NULL otherwise.
+ */
+static void *SymTable_removeKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, SymTableKey_T oKey) {
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psPreviousNode = NULL;
+    void *pvValue;
 
     /* traverse and remove node from list */
     for (psCurrentNode = oSymTable->psFirst; 
         psCurrentNode != NULL; 
         psCurrentNode = psCurrentNode->psNext) {
             /* check if current node key matches pcKey */
-            if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
+            if (SymTable_isKey(psCurrentNode, pcKey, uLength, oKey)) {
                 pvValue = psCurrentNode->pvValue; 
                 /* update head pointer if node to be 
                    removed is first node */
@@ -210,7 +493,6 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
                 else {
                 psPreviousNode->psNext = psCurrentNode->psNext;
                 }
-                free(psCurrentNode->pcKey); 
                 free(psCurrentNode); 
                 oSymTable->uNumBindings--; 
                 return pvValue;
@@ -220,6 +502,114 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
     return NULL; 
 }
 
+/*
+ * removes binding associated with given pcKey from the
+ * symbol table (oSymTable) and frees memory.
+ * return value associated with removed key if key existed
+ * in oSymTable. return NULL otherwise.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeKey(oSymTable, pcKey, strlen(pcKey), NULL);
+}
+
+/*
+ * removes binding associated with interned key oKey from
+ * oSymTable and frees memory. return value associated with
+ * removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+    return SymTable_removeKey(oSymTable, oKey->acKey, oKey->uLength,
+                              oKey);
+}
+
+/*
+ * adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. the characters are copied, with a '\0' added.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_putKey(oSymTable, pcKey, uLength, NULL, pvValue);
+}
+
+/*
+ * checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable. returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_lookupNode(oSymTable, pcKey, uLength, NULL) != NULL;
+}
+
+/*
+ * returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    struct SymTableNode *psCurrentNode;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    psCurrentNode = SymTable_lookupNode(oSymTable, pcKey, uLength,
+                                        NULL);
+    if (psCurrentNode == NULL)
+        return NULL;
+    return psCurrentNode->pvValue;
+}
+
+/*
+ * removes binding of the key made of the uLength characters at
+ * pcKey from oSymTable and frees memory. return value associated
+ * with removed key if it existed in oSymTable. return NULL
+ * otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeKey(oSymTable, pcKey, uLength, NULL);
+}
+
+/*
+ * Works like SymTable_put. A list does not hash its keys, so uHash,
+ * the code SymTable_hashKey returns for pcKey, is ignored.
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    (void)uHash;
+    return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+/*
+ * Works like SymTable_get; uHash is ignored.
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    (void)uHash;
+    return SymTable_get(oSymTable, pcKey);
+}
+
+/*
+ * Works like SymTable_remove; uHash is ignored.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    (void)uHash;
+    return SymTable_remove(oSymTable, pcKey);
+}
+
 /* to each binding in oSymTable, apply function (pfApply) given by
    the user. user is able to input additional parameter pvExtra
    if needed for the user defined function. */
@@ -230,11 +620,95 @@ void SymTable_map(SymTable_T oSymTable,
     assert(oSymTable != NULL);
     assert(pfApply != NULL);
 
-    /* traverse linked list, apply function to each key-value */
+    /* traverse linked list, apply function to each key-value.
+       lookups made by pfApply leave the list in order meanwhile */
+    oSymTable->uNumWalks++;
     for (psCurrentNode = oSymTable->psFirst; 
     psCurrentNode != NULL; 
     psCurrentNode = psCurrentNode->psNext) {
-        (*pfApply)(psCurrentNode->pcKey, psCurrentNode->pvValue,
-            (void *)pvExtra); 
+        (*pfApply)(SymTable_nodeKey(psCurrentNode),
+            psCurrentNode->pvValue, (void *)pvExtra);
     }
+    oSymTable->uNumWalks--;
+}
+
+/* works like SymTable_map. a list can only be split by walking it,
+   which is as slow as mapping it, so the calling thread applies
+   pfApply to every binding and iThreadCount is ignored */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    (void)iThreadCount;
+    SymTable_map(oSymTable, pfApply, pvExtra);
+}
+
+/* to each binding in oSymTable whose key is at least pcLow and less
+   than pcHigh, apply function (pfApply) given by the user, in key
+   order; a NULL bound leaves that end open. the list is kept in
+   order of insertion, so the bindings in range are collected and
+   sorted first. returns 1 if successful and 0 if memory allocation
+   fails */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    return SymTable_mapSorted(oSymTable, pcLow, pcHigh, NULL, pfApply,
+                              pvExtra);
+}
+
+/* to each binding in oSymTable whose key starts with pcPrefix,
+   apply function (pfApply) given by the user, in key order. returns
+   1 if successful and 0 if memory allocation fails */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    assert(pcPrefix != NULL);
+    return SymTable_mapSorted(oSymTable, NULL, NULL, pcPrefix, pfApply,
+                              pvExtra);
+}
+
+/*
+ * opens cursor *psIter over the bindings of oSymTable. the cursor
+ * holds the node it returns next, so removing the binding it
+ * returned last leaves it valid, and bindings put meanwhile go in
+ * at the head of the list, which it has already passed. lookups
+ * leave the list in order until the cursor is closed
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->pvNode = oSymTable->psFirst;
+    oSymTable->uNumWalks++;
+}
+
+/*
+ * moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. returns 0 once every
+ * binding has been returned
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    struct SymTableNode *psCurrentNode;
+
+    assert(psIter != NULL);
+
+    psCurrentNode = psIter->pvNode;
+    if (psCurrentNode == NULL)
+        return 0;
+    psIter->pvNode = psCurrentNode->psNext;
+
+    if (ppcKey != NULL)
+        *ppcKey = SymTable_nodeKey(psCurrentNode);
+    if (ppvValue != NULL)
+        *ppvValue = psCurrentNode->pvValue;
+    return 1;
+}
+
+/* closes cursor *psIter; a list cursor holds nothing to release */
+void SymTable_end(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+    psIter->oSymTable->uNumWalks--;
+    psIter->pvNode = NULL;
 }
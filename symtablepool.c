@@ -0,0 +1,224 @@
+/*
+ * symtablepool.c
+ *
+ * Parallel walks shared by the symbol table implementations. The
+ * items to walk, such as the buckets of a table, are cut into
+ * chunks, and every thread starts with an equal run of chunks. Runs
+ * of equal length may hold very different amounts of work, since
+ * chains and clusters are uneven, so a thread whose run is used up
+ * steals the back half of another thread's run, and the threads
+ * finish close together.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "symtablepool.h"
+/* keeps each worker's run off the cache line of the next one */
+#define CACHE_LINE_SIZE 64
+/* largest number of chunks, so that both ends of a run fit in the
+   32-bit halves of one word */
+#define MAX_CHUNK_COUNT ((size_t)UINT32_MAX)
+
+struct SymTableJob;
+
+/* one thread taking part in a parallel walk */
+struct SymTableWorker {
+    /* run of chunks the worker still has to do: the first chunk in
+       the high 32 bits, the chunk after the last in the low 32 bits.
+       the owner takes chunks from the front and thieves take the
+       back half, both with compare-and-swap */
+    uint64_t uRun;
+    /* walk the worker takes part in */
+    struct SymTableJob *psJob;
+    /* position of the worker in its walk's array of workers */
+    int iIndex;
+    /* thread running the worker, unless it is the calling thread */
+    pthread_t sThread;
+    /* keeps other workers off the cache line of uRun */
+    char acPadding[CACHE_LINE_SIZE];
+};
+
+/* one parallel walk */
+struct SymTableJob {
+    /* number of items to walk */
+    size_t uNumItems;
+    /* number of items in each chunk */
+    size_t uGrain;
+    /* function called for each chunk, and its argument */
+    void (*pfRange)(size_t uFirst, size_t uLimit, void *pvArg);
+    void *pvArg;
+    /* workers taking part in the walk */
+    struct SymTableWorker *psWorkers;
+    /* number of workers */
+    int iNumWorkers;
+};
+
+/* Returns the run of the chunks from uFirst to uLimit - 1. */
+static uint64_t SymTable_run(size_t uFirst, size_t uLimit) {
+    return ((uint64_t)uFirst << 32) | (uint64_t)uLimit;
+}
+
+/*
+ * Takes the first chunk of the run of psWorker, and stores its
+ * number in *puChunk. Returns 1 if successful, and 0 if the run is
+ * used up.
+ */
+static int SymTable_takeChunk(struct SymTableWorker *psWorker,
+    size_t *puChunk) {
+    uint64_t uRun;
+    size_t uFirst;
+    size_t uLimit;
+
+    uRun = __atomic_load_n(&psWorker->uRun, __ATOMIC_ACQUIRE);
+    do {
+        uFirst = (size_t)(uRun >> 32);
+        uLimit = (size_t)(uRun & UINT32_MAX);
+        if (uFirst >= uLimit)
+            return 0;
+    } while (!__atomic_compare_exchange_n(
+                 &psWorker->uRun, &uRun,
+                 SymTable_run(uFirst + 1, uLimit), 0,
+                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    *puChunk = uFirst;
+    return 1;
+}
+
+/*
+ * Moves the back half of the run of another worker of the walk of
+ * psThief into the run of psThief, whose own run is used up.
+ * Returns 1 if successful, and 0 if every other run is used up too.
+ */
+static int SymTable_stealRun(struct SymTableWorker *psThief) {
+    struct SymTableJob *psJob = psThief->psJob;
+    struct SymTableWorker *psVictim;
+    uint64_t uRun;
+    size_t uFirst;
+    size_t uLimit;
+    size_t uHalf;
+    int i;
+
+    for (i = 1; i < psJob->iNumWorkers; i++) {
+        psVictim = &psJob->psWorkers[(psThief->iIndex + i)
+                                     % psJob->iNumWorkers];
+        uRun = __atomic_load_n(&psVictim->uRun, __ATOMIC_ACQUIRE);
+        for (;;) {
+            uFirst = (size_t)(uRun >> 32);
+            uLimit = (size_t)(uRun & UINT32_MAX);
+            if (uFirst >= uLimit)
+                break;
+            uHalf = (uLimit - uFirst + 1) / 2;
+            if (__atomic_compare_exchange_n(&psVictim->uRun, &uRun,
+                    SymTable_run(uFirst, uLimit - uHalf), 0,
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                /* other thieves leave an empty run alone, so a plain
+                   store is enough */
+                __atomic_store_n(&psThief->uRun,
+                                 SymTable_run(uLimit - uHalf, uLimit),
+                                 __ATOMIC_RELEASE);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Does the chunks of worker pvWorker, then those it can steal,
+ * until no run has any left. Returns NULL.
+ */
+static void *SymTable_work(void *pvWorker) {
+    struct SymTableWorker *psWorker = pvWorker;
+    struct SymTableJob *psJob = psWorker->psJob;
+    size_t uChunk;
+    size_t uFirst;
+    size_t uLimit;
+
+    do {
+        while (SymTable_takeChunk(psWorker, &uChunk)) {
+            uFirst = uChunk * psJob->uGrain;
+            uLimit = uFirst + psJob->uGrain;
+            if (uLimit > psJob->uNumItems)
+                uLimit = psJob->uNumItems;
+            (*psJob->pfRange)(uFirst, uLimit, psJob->pvArg);
+        }
+    } while (SymTable_stealRun(psWorker));
+    return NULL;
+}
+
+/*
+ * Calls pfRange(uFirst, uLimit, pvArg) for consecutive ranges of
+ * items that together cover the items 0 to uNumItems - 1 once
+ * each, uGrain items at a time, in up to iThreadCount threads, the
+ * calling one included. Threads that cannot be started leave their
+ * run to be stolen by the others. Returns once every range is done.
+ */
+void SymTable_runParallel(size_t uNumItems, size_t uGrain,
+    int iThreadCount,
+    void (*pfRange)(size_t uFirst, size_t uLimit, void *pvArg),
+    void *pvArg) {
+    struct SymTableJob sJob;
+    struct SymTableWorker *psWorkers;
+    size_t uNumChunks;
+    int *piStarted;
+    int i;
+
+    assert(uGrain > 0);
+    assert(pfRange != NULL);
+
+    if (uNumItems == 0)
+        return;
+
+    /* coarser chunks if there would be too many to number */
+    uNumChunks = (uNumItems - 1) / uGrain + 1;
+    if (uNumChunks > MAX_CHUNK_COUNT) {
+        uGrain = (uNumItems - 1) / MAX_CHUNK_COUNT + 1;
+        uNumChunks = (uNumItems - 1) / uGrain + 1;
+    }
+    if ((size_t)iThreadCount > uNumChunks)
+        iThreadCount = (int)uNumChunks;
+    if (iThreadCount <= 1) {
+        (*pfRange)(0, uNumItems, pvArg);
+        return;
+    }
+
+    psWorkers = malloc(sizeof(struct SymTableWorker)
+                       * (size_t)iThreadCount);
+    piStarted = calloc((size_t)iThreadCount, sizeof(int));
+    if (psWorkers == NULL || piStarted == NULL) {
+        free(psWorkers);
+        free(piStarted);
+        (*pfRange)(0, uNumItems, pvArg);
+        return;
+    }
+
+    sJob.uNumItems = uNumItems;
+    sJob.uGrain = uGrain;
+    sJob.pfRange = pfRange;
+    sJob.pvArg = pvArg;
+    sJob.psWorkers = psWorkers;
+    sJob.iNumWorkers = iThreadCount;
+    for (i = 0; i < iThreadCount; i++) {
+        psWorkers[i].uRun =
+            SymTable_run(uNumChunks * (size_t)i / (size_t)iThreadCount,
+                         uNumChunks * (size_t)(i + 1)
+                         / (size_t)iThreadCount);
+        psWorkers[i].psJob = &sJob;
+        psWorkers[i].iIndex = i;
+    }
+
+    /* the calling thread is worker 0 */
+    for (i = 1; i < iThreadCount; i++)
+        piStarted[i] = pthread_create(&psWorkers[i].sThread, NULL,
+                                      SymTable_work,
+                                      &psWorkers[i]) == 0;
+    (void)SymTable_work(&psWorkers[0]);
+    for (i = 1; i < iThreadCount; i++) {
+        if (piStarted[i])
+            (void)pthread_join(psWorkers[i].sThread, NULL);
+    }
+
+    free(piStarted);
+    free(psWorkers);
+}
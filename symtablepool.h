@@ -0,0 +1,30 @@
+/*
+ * symtablepool.h
+ *
+ * Private interface shared by the symbol table implementations and
+ * symtablepool.c. Not for clients; they use symtable.h. Provides
+ * splitting a range of items, such as the buckets of a table, among
+ * several threads that steal work from each other when their own
+ * share runs out.
+ */
+
+#ifndef SYMTABLEPOOL_INCLUDED
+#define SYMTABLEPOOL_INCLUDED
+
+#include <stddef.h>
+
+/*
+ * calls pfRange(uFirst, uLimit, pvArg) for ranges of consecutive
+ * items that together cover the items 0 to uNumItems - 1 once
+ * each. up to iThreadCount threads, the calling one included, make
+ * the calls at the same time, taking uGrain items at a time, so
+ * pfRange must be safe to call from several threads at once.
+ * returns once every range has been done. if iThreadCount is at
+ * most 1, the calling thread does all the items in one call
+ */
+void SymTable_runParallel(size_t uNumItems, size_t uGrain,
+    int iThreadCount,
+    void (*pfRange)(size_t uFirst, size_t uLimit, void *pvArg),
+    void *pvArg);
+
+#endif
@@ -0,0 +1,1111 @@
+/*
+ * symtablerobin.c
+ *
+ * Symbol table module implementation via open addressing with
+ * Robin Hood linear probing and backward-shift deletion.
+ * Bindings are stored directly in one flat array of slots, so a
+ * lookup usually touches one or two cache lines.
+ * functionalities include:
+ * - creating and deleting a symbol table
+ * - adding and removing key-value pairs
+ * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
+ * - applying a user-defined function to each entry
+ * - applying it with several threads at once
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - sizing a table in advance for a known number of bindings
+ * - compacting a table to the size of its bindings
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablekey.h"
+#include "symtablepool.h"
+/* must be a power of two so indices can be reduced with a mask */
+#define INITIAL_SLOT_COUNT 512
+#define MAX_LOAD_FACTOR 0.75
+/* number of lookups SymTable_getBatch keeps in flight at once */
+#define BATCH_SIZE 16
+/* number of slots a thread of SymTable_mapParallel takes at once */
+#define MAP_GRAIN 1024
+
+/* multiplier for Fibonacci hashing: 2^w divided by the golden ratio */
+#if SIZE_MAX > 0xFFFFFFFFu
+#define FIBONACCI_MULTIPLIER ((size_t)11400714819323198485u)
+#else
+#define FIBONACCI_MULTIPLIER ((size_t)2654435769u)
+#endif
+
+/* key value pair slot structure; an empty slot has a NULL pcKey */
+struct SymTableSlot {
+    /* key string */
+    char *pcKey;
+    /* value for key */
+    void *pvValue;
+    /* full hash code of pcKey */
+    size_t uHash;
+    /* handle the binding was put with, or NULL if it was put with a
+       key string. if not NULL, pcKey is the handle's string and is
+       not freed with the binding */
+    SymTableKey_T oKey;
+};
+
+/* one SymTable_mapParallel call, shared by all of its threads */
+struct SymTableMapping {
+    /* table being mapped */
+    SymTable_T oSymTable;
+    /* function applied to each binding, and its extra argument */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+/* symbol table structure */
+struct SymTable {
+    /* array of slots */
+    struct SymTableSlot *psSlots;
+    /* number of slots, always a power of two */
+    size_t uNumSlots;
+    /* number of bits needed to index psSlots */
+    unsigned int uSlotBits;
+    /* number of bindings */
+    size_t uNumBindings;
+    /* hash function applied to key strings */
+    size_t (*pfHash)(const char *pcKey);
+    /* random seed mixed into every hash code before it is reduced
+       to a slot index, so tables order their probes differently */
+    size_t uSeed;
+};
+
+/*
+ * Returns the hash code of key string pcKey, which is uLength
+ * characters long, in oSymTable, computed with the table's hash
+ * function. The default hash function is given the length, so it
+ * does not have to find the '\0' again.
+ */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return SymTable_hashBytes(pcKey, uLength);
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the hash code of interned key oKey in oSymTable. A table
+ * using the default hash function reuses the handle's precomputed
+ * hash code; any other table has to hash the handle's string.
+ */
+static size_t SymTable_handleHash(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return oKey->uHash;
+    return (*oSymTable->pfHash)(oKey->acKey);
+}
+
+/*
+ * Returns the hash code in oSymTable of key string pcKey, given the
+ * code uHash that SymTable_hashKey returns for it. A table using the
+ * default hash function takes uHash as is; any other table has to
+ * hash the string.
+ */
+static size_t SymTable_givenHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return uHash;
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the home slot of hash code uHash in oSymTable. The seeded
+ * hash code is scrambled with Fibonacci hashing and its top uSlotBits
+ * bits are used, so weak low-order bits do not cause clustering.
+ */
+static size_t SymTable_home(SymTable_T oSymTable, size_t uHash) {
+    return ((uHash ^ oSymTable->uSeed) * FIBONACCI_MULTIPLIER)
+           >> (sizeof(size_t) * 8 - oSymTable->uSlotBits);
+}
+
+/*
+ * Returns 1 if psSlot holds the key made of the uLength characters
+ * at pcKey, whose handle is oKey (NULL if the caller only has the
+ * characters), and 0 otherwise. Two handles are compared by
+ * address, since equal strings intern to the same handle.
+ */
+static int SymTable_isKey(const struct SymTableSlot *psSlot,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey) {
+    if (oKey != NULL && psSlot->oKey != NULL)
+        return psSlot->oKey == oKey;
+    return SymTable_keyEquals(psSlot->pcKey, pcKey, uLength);
+}
+
+/*
+ * Returns how far the binding in slot uIndex of oSymTable is from
+ * its home slot (its probe sequence length).
+ */
+static size_t SymTable_distance(SymTable_T oSymTable, size_t uIndex) {
+    size_t uHome = SymTable_home(oSymTable,
+                                 oSymTable->psSlots[uIndex].uHash);
+    return (uIndex - uHome) & (oSymTable->uNumSlots - 1);
+}
+
+/*
+ * Helper function that returns the index of the slot holding the
+ * key made of the uLength characters at pcKey, whose hash code is
+ * uHash and whose handle is oKey (NULL if unknown), in oSymTable.
+ * Returns uNumSlots if the key is absent. The probe stops early
+ * once it reaches a binding that is closer to its home than the
+ * key would be, which Robin Hood insertion guarantees cannot
+ * happen before the key.
+ */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey) {
+    size_t uMask = oSymTable->uNumSlots - 1;
+    size_t uIndex = SymTable_home(oSymTable, uHash);
+    size_t uDistance = 0;
+    struct SymTableSlot *psSlot;
+
+    for (;;) {
+        psSlot = &oSymTable->psSlots[uIndex];
+        if (psSlot->pcKey == NULL
+            || SymTable_distance(oSymTable, uIndex) < uDistance)
+            return oSymTable->uNumSlots;
+        if (psSlot->uHash == uHash
+            && SymTable_isKey(psSlot, pcKey, uLength, oKey))
+            return uIndex;
+        uIndex = (uIndex + 1) & uMask;
+        uDistance++;
+    }
+}
+
+/*
+ * Helper function that stores the binding in sSlot into oSymTable,
+ * which must not already contain its key and must have a free slot.
+ * Whenever the carried binding is farther from home than the one in
+ * the probed slot, the two are swapped ("robbing the rich").
+ * Returns the index of the slot that sSlot's binding ended up in.
+ */
+static size_t SymTable_insert(SymTable_T oSymTable,
+    struct SymTableSlot sSlot) {
+    size_t uMask = oSymTable->uNumSlots - 1;
+    size_t uIndex = SymTable_home(oSymTable, sSlot.uHash);
+    size_t uDistance = 0;
+    size_t uExisting;
+    size_t uPlaced = oSymTable->uNumSlots;
+    struct SymTableSlot sTemp;
+
+    for (;;) {
+        if (oSymTable->psSlots[uIndex].pcKey == NULL) {
+            oSymTable->psSlots[uIndex] = sSlot;
+            return (uPlaced == oSymTable->uNumSlots) ? uIndex : uPlaced;
+        }
+        uExisting = SymTable_distance(oSymTable, uIndex);
+        if (uExisting < uDistance) {
+            /* displace the binding that is closer to its home */
+            sTemp = oSymTable->psSlots[uIndex];
+            oSymTable->psSlots[uIndex] = sSlot;
+            sSlot = sTemp;
+            uDistance = uExisting;
+            /* the first swap is where the new binding stays */
+            if (uPlaced == oSymTable->uNumSlots)
+                uPlaced = uIndex;
+        }
+        uIndex = (uIndex + 1) & uMask;
+        uDistance++;
+    }
+}
+
+/*
+ * Returns the number of slots that holds uCapacity bindings without
+ * growing: the smallest power of two, at least INITIAL_SLOT_COUNT,
+ * that keeps the load at or below MAX_LOAD_FACTOR. Returns 0 if
+ * that number of slots is too large to allocate.
+ */
+static size_t SymTable_slotCountFor(size_t uCapacity) {
+    size_t uNumSlots = INITIAL_SLOT_COUNT;
+
+    while ((double)uCapacity / uNumSlots > MAX_LOAD_FACTOR) {
+        /* no larger power of two is representable */
+        if (uNumSlots > ((size_t)-1) / 2 / sizeof(struct SymTableSlot))
+            return 0;
+        uNumSlots *= 2;
+    }
+    return uNumSlots;
+}
+
+/*
+ * Helper function that gives oSymTable uNumSlots slots, a power of
+ * two with room for every binding, and reinserts every binding.
+ * Returns 1 if resizing is successful, and 0 otherwise.
+ */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNumSlots) {
+    struct SymTableSlot *psOldSlots = oSymTable->psSlots;
+    size_t uOldNumSlots = oSymTable->uNumSlots;
+    struct SymTableSlot *psNewSlots;
+    size_t uSize;
+    size_t i;
+
+    psNewSlots = calloc(uNumSlots, sizeof(struct SymTableSlot));
+    if (psNewSlots == NULL) return 0;
+
+    oSymTable->psSlots = psNewSlots;
+    oSymTable->uNumSlots = uNumSlots;
+    oSymTable->uSlotBits = 0;
+    for (uSize = 1; uSize < uNumSlots; uSize *= 2)
+        oSymTable->uSlotBits++;
+
+    /* cached hash codes avoid touching the key bytes */
+    for (i = 0; i < uOldNumSlots; i++) {
+        if (psOldSlots[i].pcKey != NULL)
+            SymTable_insert(oSymTable, psOldSlots[i]);
+    }
+    free(psOldSlots);
+    return 1;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_new(void) {
+    return SymTable_newWithHash(SymTable_hashString);
+}
+
+/*
+ * Helper function that creates and returns a empty symbol table
+ * that hashes keys with pfHash and has uNumSlots slots, a power of
+ * two, and allocate memory for the symbol table structure & slots.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+static SymTable_T SymTable_create(size_t (*pfHash)(const char *pcKey),
+    size_t uNumSlots) {
+    SymTable_T oSymTable;
+    size_t uSize;
+
+    /* memory allocation for SymTable */
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* memory allocation for slot array, all slots empty */
+    oSymTable->psSlots = calloc(uNumSlots, sizeof(struct SymTableSlot));
+    if (oSymTable->psSlots == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->uNumSlots = uNumSlots;
+    oSymTable->uSlotBits = 0;
+    for (uSize = 1; uSize < uNumSlots; uSize *= 2)
+        oSymTable->uSlotBits++;
+    oSymTable->uNumBindings = 0;
+    oSymTable->pfHash = pfHash;
+    oSymTable->uSeed = SymTable_newSeed();
+
+    return oSymTable;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with pfHash, and allocate memory for the symbol table
+ * structure & slots.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    assert(pfHash != NULL);
+    return SymTable_create(pfHash, INITIAL_SLOT_COUNT);
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function and starts out with enough
+ * slots for uCapacity bindings, so that it never grows while they
+ * are put.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    size_t uNumSlots = SymTable_slotCountFor(uCapacity);
+
+    if (uNumSlots == 0)
+        return NULL;
+    return SymTable_create(SymTable_hashString, uNumSlots);
+}
+
+/*
+ * Makes room in oSymTable for uCapacity bindings in all, so that it
+ * does not grow again until it holds more. Reinserts every binding
+ * at once if the table has to grow.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    size_t uNumSlots;
+
+    assert(oSymTable != NULL);
+
+    uNumSlots = SymTable_slotCountFor(uCapacity);
+    if (uNumSlots == 0)
+        return 0;
+    if (uNumSlots <= oSymTable->uNumSlots)
+        return 1;
+    return SymTable_resize(oSymTable, uNumSlots);
+}
+
+/*
+ * Rebuilds oSymTable with the fewest slots that hold its bindings,
+ * if that is fewer than it has, so that SymTable_map and
+ * SymTable_free need not walk the empty slots a burst of removes
+ * left behind.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_compact(SymTable_T oSymTable) {
+    size_t uNumSlots;
+
+    assert(oSymTable != NULL);
+
+    uNumSlots = SymTable_slotCountFor(oSymTable->uNumBindings);
+    if (uNumSlots >= oSymTable->uNumSlots)
+        return 1;
+    return SymTable_resize(oSymTable, uNumSlots);
+}
+
+/*
+ * The hashes of the keys fix where each lookup probes, so the slots
+ * cannot be reordered for it; iPolicy is accepted and ignored.
+ */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    (void)iPolicy;
+}
+
+/*
+ * A miss stops probing once it passes slots whose keys are closer
+ * to their home than it would be, so it looks at few slots, most
+ * in the same cache line; iEnable is accepted and ignored.
+ */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+    (void)iEnable;
+    return 1;
+}
+
+/*
+ * Free all memory associated with symbol table oSymTable.
+ * Thus key-value bindings as well as the symbol table itself
+ * are freed.
+ */
+void SymTable_free(SymTable_T oSymTable) {
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /* free the defensive copy of every key; interned keys belong
+       to the intern pool */
+    for (i = 0; i < oSymTable->uNumSlots; i++) {
+        if (oSymTable->psSlots[i].oKey == NULL)
+            free(oSymTable->psSlots[i].pcKey);
+    }
+
+    free(oSymTable->psSlots);
+    free(oSymTable);
+}
+
+/* Returns number of bindings in oSymTable. */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->uNumBindings;
+}
+
+/*
+ * Helper function that returns the index of the slot of oSymTable
+ * holding the key made of the uLength characters at pcKey, whose
+ * hash code is uHash, adding a binding of the key and pvValue first
+ * if the key doesn't exist in oSymTable.
+ * If oKey is not NULL, pcKey is its string and a new slot refers to
+ * the handle instead of copying the key. Sets *piCreated to 1 if
+ * the binding was added and 0 otherwise. Returns uNumSlots if
+ * memory allocation fails.
+ */
+static size_t SymTable_findOrAddKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue, int *piCreated) {
+    struct SymTableSlot sSlot;
+    size_t uIndex;
+
+    *piCreated = 0;
+
+    /* does not insert key if it already exists */
+    uIndex = SymTable_find(oSymTable, pcKey, uLength, uHash, oKey);
+    if (uIndex != oSymTable->uNumSlots)
+        return uIndex;
+
+    /* grow before the probe sequences get long */
+    if ((double)(oSymTable->uNumBindings + 1) / oSymTable->uNumSlots
+        > MAX_LOAD_FACTOR) {
+        /* no larger power of two is representable */
+        if (oSymTable->uNumSlots
+            > ((size_t)-1) / 2 / sizeof(struct SymTableSlot))
+            return oSymTable->uNumSlots;
+        if (!SymTable_resize(oSymTable, oSymTable->uNumSlots * 2))
+            return oSymTable->uNumSlots;
+    }
+
+    /* defensive copy, unless the handle already is one */
+    if (oKey != NULL)
+        sSlot.pcKey = (char *)oKey->acKey;
+    else {
+        if (uLength == (size_t)-1)
+            return oSymTable->uNumSlots;
+        sSlot.pcKey = malloc(uLength + 1);
+        if (sSlot.pcKey == NULL)
+            return oSymTable->uNumSlots;
+        memcpy(sSlot.pcKey, pcKey, uLength);
+        sSlot.pcKey[uLength] = '\0';
+    }
+    sSlot.pvValue = (void *)pvValue;
+    sSlot.uHash = uHash;
+    sSlot.oKey = oKey;
+
+    uIndex = SymTable_insert(oSymTable, sSlot);
+    oSymTable->uNumBindings++;
+    *piCreated = 1;
+    return uIndex;
+}
+
+/*
+ * Helper function that adds a binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash, and
+ * pvValue to oSymTable if the key doesn't exist in oSymTable. If
+ * oKey is not NULL, pcKey is its string and the slot refers to the
+ * handle instead of copying the key.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue) {
+    int iCreated;
+
+    SymTable_findOrAddKey(oSymTable, pcKey, uLength, uHash, oKey,
+                          pvValue, &iCreated);
+    return iCreated;
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL, pvValue);
+}
+
+/*
+ * Adds new binding of interned key oKey, pvValue to oSymTable
+ * if the key doesn't exist in oSymTable, using the handle's
+ * precomputed hash code. returns 1 if binding was added, returns 0
+ * if memory allocation fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey,
+                           pvValue);
+}
+
+/*
+ * Helper function that replaces the value in slot uIndex of
+ * oSymTable with pvValue and returns the old value. Returns NULL if
+ * uIndex is uNumSlots, i.e. the key was not found.
+ */
+static void *SymTable_replaceSlot(SymTable_T oSymTable, size_t uIndex,
+    const void *pvValue) {
+    void *pvOldValue;
+
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+
+    pvOldValue = oSymTable->psSlots[uIndex].pvValue;
+    oSymTable->psSlots[uIndex].pvValue = (void *)pvValue;
+    return pvOldValue;
+}
+
+/*
+ * replace old value (pvOldValue) of key pcKey in oSymTable
+ * with new value pvValue and returns pvOldValue.
+ * if the given pcKey doesn't exist within oSymTable,
+ * returns NULL
+ */
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_replaceSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength,
+                      SymTable_hash(oSymTable, pcKey, uLength), NULL),
+        pvValue);
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_replaceSlot(oSymTable,
+        SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                      SymTable_handleHash(oSymTable, oKey), oKey),
+        pvValue);
+}
+
+/*
+ * Returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. Sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. The key is hashed only once.
+ * Slots move when bindings are added or removed, so the address
+ * is only good until then. Returns NULL if memory allocation fails.
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    size_t uIndex;
+    size_t uLength;
+    int iCreated;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uIndex = SymTable_findOrAddKey(oSymTable, pcKey, uLength,
+                                   SymTable_hash(oSymTable, pcKey,
+                                                 uLength),
+                                   NULL, pvValue, &iCreated);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Checks if given key pcKey exists within oSymTable.
+ * Returns 1 if pcKey exists, if else returns 0
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_find(oSymTable, pcKey, uLength,
+                         SymTable_hash(oSymTable, pcKey, uLength), NULL)
+           != oSymTable->uNumSlots;
+}
+
+/*
+ * Checks if interned key oKey exists within oSymTable.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                         SymTable_handleHash(oSymTable, oKey), oKey)
+           != oSymTable->uNumSlots;
+}
+
+/*
+ * Returns value associated with key pcKey if it exists
+ * within oSymTable, returns NULL if can't find given pcKey
+ * in oSymTable
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    size_t uIndex;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uIndex = SymTable_find(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
+ */
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    uIndex = SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. The keys are taken BATCH_SIZE at a time: all of
+ * them are hashed and their home slots prefetched, then the key
+ * string of every home slot whose hash code matches is prefetched,
+ * and only then is each key probed for. The misses on slots and on
+ * key strings are waited for a batch at a time instead of one after
+ * another.
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    size_t auHashes[BATCH_SIZE];
+    size_t auLengths[BATCH_SIZE];
+    size_t auHomes[BATCH_SIZE];
+    struct SymTableSlot *psSlot;
+    size_t uFirst;
+    size_t uCount;
+    size_t uIndex;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+
+    for (uFirst = 0; uFirst < uNumKeys; uFirst += uCount) {
+        uCount = uNumKeys - uFirst;
+        if (uCount > BATCH_SIZE)
+            uCount = BATCH_SIZE;
+
+        for (i = 0; i < uCount; i++) {
+            assert(apcKeys[uFirst + i] != NULL);
+            auLengths[i] = strlen(apcKeys[uFirst + i]);
+            auHashes[i] = SymTable_hash(oSymTable, apcKeys[uFirst + i],
+                                        auLengths[i]);
+            auHomes[i] = SymTable_home(oSymTable, auHashes[i]);
+            __builtin_prefetch(&oSymTable->psSlots[auHomes[i]]);
+        }
+        for (i = 0; i < uCount; i++) {
+            psSlot = &oSymTable->psSlots[auHomes[i]];
+            if (psSlot->pcKey != NULL && psSlot->uHash == auHashes[i])
+                __builtin_prefetch(psSlot->pcKey);
+        }
+        for (i = 0; i < uCount; i++) {
+            uIndex = SymTable_find(oSymTable, apcKeys[uFirst + i],
+                                   auLengths[i], auHashes[i], NULL);
+            apvValues[uFirst + i] =
+                (uIndex == oSymTable->uNumSlots)
+                ? NULL : oSymTable->psSlots[uIndex].pvValue;
+        }
+    }
+}
+
+/*
+ * Helper function that removes the binding in slot uIndex of
+ * oSymTable and returns its value. Returns NULL if uIndex is
+ * uNumSlots, i.e. the key was not found. Instead of leaving a
+ * tombstone, the following bindings of the probe run are shifted
+ * back by one slot until an empty slot or a binding in its home
+ * slot is reached.
+ */
+static void *SymTable_removeSlot(SymTable_T oSymTable, size_t uIndex) {
+    size_t uMask;
+    size_t uNext;
+    void *pvValue;
+
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+
+    /* store value so that it can be returned after removal */
+    pvValue = oSymTable->psSlots[uIndex].pvValue;
+    if (oSymTable->psSlots[uIndex].oKey == NULL)
+        free(oSymTable->psSlots[uIndex].pcKey);
+
+    /* backward-shift deletion */
+    uMask = oSymTable->uNumSlots - 1;
+    uNext = (uIndex + 1) & uMask;
+    while (oSymTable->psSlots[uNext].pcKey != NULL
+           && SymTable_distance(oSymTable, uNext) > 0) {
+        oSymTable->psSlots[uIndex] = oSymTable->psSlots[uNext];
+        uIndex = uNext;
+        uNext = (uNext + 1) & uMask;
+    }
+    oSymTable->psSlots[uIndex].pcKey = NULL;
+    oSymTable->psSlots[uIndex].pvValue = NULL;
+    oSymTable->psSlots[uIndex].oKey = NULL;
+
+    oSymTable->uNumBindings--;
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with given pcKey from the
+ * symbol table (oSymTable) and frees memory.
+ * Return the value associated with removed key if key existed
+ * in oSymTable. return NULL otherwise.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength,
+                      SymTable_hash(oSymTable, pcKey, uLength), NULL));
+}
+
+/*
+ * Removes binding associated with interned key oKey from
+ * oSymTable and frees memory. Return the value associated with
+ * the removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                      SymTable_handleHash(oSymTable, oKey), oKey));
+}
+
+/*
+ * Adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. The characters are copied, with a '\0' added.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (uLength == (size_t)-1
+        || !SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength,
+                               &uHash))
+        return 0;
+    return SymTable_putKey(oSymTable, pcKey, uLength, uHash, NULL,
+                           pvValue);
+}
+
+/*
+ * Checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable, reading them in place.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return 0;
+    return SymTable_find(oSymTable, pcKey, uLength, uHash, NULL)
+           != oSymTable->uNumSlots;
+}
+
+/*
+ * Returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, reading them
+ * in place. Returns NULL otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    uIndex = SymTable_find(oSymTable, pcKey, uLength, uHash, NULL);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Removes binding associated with the key made of the uLength
+ * characters at pcKey from oSymTable and frees memory. Return the
+ * value associated with the removed key if it existed in
+ * oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength, uHash, NULL));
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to oSymTable if the key pcKey
+ * doesn't exist in oSymTable, using uHash, the code SymTable_hashKey
+ * returns for pcKey, instead of hashing it again.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_givenHash(oSymTable, pcKey, uHash),
+                           NULL, pvValue);
+}
+
+/*
+ * Returns value associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    size_t uIndex;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uIndex = SymTable_find(oSymTable, pcKey, uLength,
+                           SymTable_givenHash(oSymTable, pcKey, uHash),
+                           NULL);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Removes binding associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, from oSymTable and frees memory. Return the value
+ * associated with the removed key if it existed in oSymTable.
+ * return NULL otherwise.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength,
+                      SymTable_givenHash(oSymTable, pcKey, uHash),
+                      NULL));
+}
+
+/*
+ * To each binding in oSymTable, apply function (pfApply) given by
+ * the user. user is able to input additional parameter pvExtra
+ * if needed for the user defined function.
+ */
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTable->uNumSlots; i++) {
+        if (oSymTable->psSlots[i].pcKey != NULL)
+            (*pfApply)(oSymTable->psSlots[i].pcKey,
+                       oSymTable->psSlots[i].pvValue, (void *)pvExtra);
+    }
+}
+
+/*
+ * Applies the function of mapping pvMapping to the bindings in the
+ * slots uFirst to uLimit - 1 of its table.
+ */
+static void SymTable_mapSlots(size_t uFirst, size_t uLimit,
+    void *pvMapping) {
+    struct SymTableMapping *psMapping = pvMapping;
+    SymTable_T oSymTable = psMapping->oSymTable;
+    size_t i;
+
+    for (i = uFirst; i < uLimit; i++) {
+        if (oSymTable->psSlots[i].pcKey != NULL)
+            (*psMapping->pfApply)(oSymTable->psSlots[i].pcKey,
+                                  oSymTable->psSlots[i].pvValue,
+                                  (void *)psMapping->pvExtra);
+    }
+}
+
+/*
+ * To each binding in oSymTable, apply function *pfApply with
+ * pvExtra as extra argument, in up to iThreadCount threads at once.
+ * The slots are split into runs, and a thread that is done with its
+ * own runs steals from the others, since bindings cluster.
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    struct SymTableMapping sMapping;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymTable_runParallel(oSymTable->uNumSlots, MAP_GRAIN, iThreadCount,
+                         SymTable_mapSlots, &sMapping);
+}
+
+/*
+ * To each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function *pfApply with pvExtra as extra
+ * argument, in key order. A NULL bound leaves that end open.
+ * Slots are filled in the order of the keys' hash codes, so
+ * every binding is looked at and those in range are sorted before
+ * pfApply sees them.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    return SymTable_mapSorted(oSymTable, pcLow, pcHigh, NULL, pfApply,
+                              pvExtra);
+}
+
+/*
+ * To each binding of oSymTable whose key starts with pcPrefix,
+ * apply function *pfApply with pvExtra as extra argument, in key
+ * order, collecting and sorting them like SymTable_mapRange.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    assert(pcPrefix != NULL);
+    return SymTable_mapSorted(oSymTable, NULL, NULL, pcPrefix, pfApply,
+                              pvExtra);
+}
+
+/*
+ * Opens cursor *psIter over the bindings of oSymTable. The cursor
+ * starts after an empty slot and goes once around the table back to
+ * it. No probe run crosses an empty slot, so removing a binding
+ * shifts back only bindings after it in the walk; if the binding the
+ * cursor returned last was removed, its slot is looked at again.
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    size_t uStart = 0;
+
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    /* the load limit leaves some slot empty */
+    while (oSymTable->psSlots[uStart].pcKey != NULL)
+        uStart++;
+
+    psIter->oSymTable = oSymTable;
+    psIter->pvNode = NULL;
+    psIter->uIndex = uStart;
+    psIter->uCount = oSymTable->uNumSlots - 1;
+}
+
+/*
+ * Moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. Returns 0 once every
+ * binding has been returned. pvNode is the key of the binding
+ * returned last and uIndex its slot; uCount slots are left to look
+ * at.
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    SymTable_T oSymTable;
+    struct SymTableSlot *psSlot;
+    size_t uMask;
+
+    assert(psIter != NULL);
+
+    oSymTable = psIter->oSymTable;
+    uMask = oSymTable->uNumSlots - 1;
+
+    /* a binding shifted back into the slot returned last is new */
+    psSlot = &oSymTable->psSlots[psIter->uIndex];
+    if (psIter->pvNode != NULL && psSlot->pcKey != psIter->pvNode) {
+        psIter->uIndex = (psIter->uIndex - 1) & uMask;
+        psIter->uCount++;
+    }
+
+    do {
+        if (psIter->uCount == 0) {
+            psIter->pvNode = NULL;
+            return 0;
+        }
+        psIter->uIndex = (psIter->uIndex + 1) & uMask;
+        psIter->uCount--;
+        psSlot = &oSymTable->psSlots[psIter->uIndex];
+    } while (psSlot->pcKey == NULL);
+    psIter->pvNode = psSlot->pcKey;
+
+    if (ppcKey != NULL)
+        *ppcKey = psSlot->pcKey;
+    if (ppvValue != NULL)
+        *ppvValue = psSlot->pvValue;
+    return 1;
+}
+
+/* Closes cursor *psIter, which holds nothing to release. */
+void SymTable_end(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+    psIter->pvNode = NULL;
+}
@@ -0,0 +1,1451 @@
+/*
+ * symtablesplit.c
+ *
+ * Lock-free symbol table module implementation via split-ordered
+ * lists (Shalev & Shavit). All bindings live in one lock-free linked
+ * list, sorted so that every bucket is a contiguous run of it that
+ * starts at a dummy node. Doubling the number of buckets only
+ * splits runs by inserting new dummies, so the table grows without
+ * ever moving a node and no thread ever waits for another.
+ * functionalities include:
+ * - creating and deleting a symbol table
+ * - adding and removing key-value pairs
+ * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
+ * - applying a user-defined function to each entry
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - sizing a table in advance for a known number of bindings
+ * - compacting a table to the size of its bindings
+ *
+ * Every function except SymTable_new, SymTable_newWithHash,
+ * SymTable_newWithCapacity and SymTable_free may be called by any
+ * number of threads at once.
+ * SymTable_intern may also be called from any thread. Removed nodes
+ * are freed through epoch-based reclamation (symtableepoch.c).
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtableepoch.h"
+#include "symtablekey.h"
+/* number of buckets a new table starts with; a power of two */
+#define INITIAL_BUCKET_COUNT 16
+/* average number of bindings per bucket that makes the table grow */
+#define RESIZE_FACTOR 2
+/* number of bits needed to index the binding counters */
+#define COUNTER_BITS 6
+#define NUM_COUNTERS (1 << COUNTER_BITS)
+/* keeps neighbouring binding counters on different cache lines */
+#define CACHE_LINE_SIZE 64
+/* number of lookups SymTable_getBatch keeps in flight at once */
+#define BATCH_SIZE 16
+/* number of bits in a size_t, and so the most directory segments */
+#define SIZE_BITS (sizeof(size_t) * CHAR_BIT)
+
+/* multiplier for Fibonacci hashing: 2^w divided by the golden ratio */
+#if SIZE_MAX > 0xFFFFFFFFu
+#define FIBONACCI_MULTIPLIER ((size_t)11400714819323198485u)
+#else
+#define FIBONACCI_MULTIPLIER ((size_t)2654435769u)
+#endif
+
+/*
+ * The list is sorted by order key. A binding's order key is its
+ * scrambled hash code with the lowest bit set. Bucket b of a table
+ * with 2^i buckets holds the bindings whose scrambled hash codes,
+ * bit-reversed, are b modulo 2^i; its dummy node's order key is b
+ * bit-reversed, which has the lowest bit clear and sorts right
+ * before those bindings. When the table doubles, bucket b splits
+ * into b and b + 2^i, and the new bucket's dummy falls in the
+ * middle of the old bucket's run.
+ */
+
+/* node structure, of a binding or of a bucket's dummy. the node and
+   its key are one allocation, with the key's bytes stored right
+   after the node */
+struct SymTableNode {
+    /* link in the garbage list once the node is unlinked */
+    struct SymTableGarbage sGarbage;
+    /* position of the node in the list */
+    size_t uOrderKey;
+    /* pointer to next node in the list. its lowest bit is set once
+       the node is removed, after which the link never changes */
+    uintptr_t uNext;
+    /* value for key, or acRemoved once the binding is removed */
+    void *pvValue;
+    /* full hash code of the key, before scrambling */
+    size_t uHash;
+    /* handle the binding was put with, or NULL if it was put with a
+       key string. if not NULL, acKey is empty and the key string is
+       the handle's */
+    SymTableKey_T oKey;
+    /* key string, stored inline; empty in a dummy */
+    char acKey[];
+};
+
+/* binding counter, one of several so that threads putting and
+   removing different keys do not all write the same cache line */
+struct SymTableCounter {
+    /* bindings added minus bindings removed, modulo 2^w */
+    size_t uCount;
+    /* keeps the next counter off this counter's cache line */
+    char acPadding[CACHE_LINE_SIZE];
+};
+
+/* symbol table structure */
+struct SymTable {
+    /* number of buckets, a power of two that only grows */
+    size_t uNumBuckets;
+    /* directory of dummy nodes. segment 0 holds bucket 0, and
+       segment j > 0 holds buckets 2^(j-1) up to 2^j - 1. segments
+       are allocated and buckets initialized when first used */
+    struct SymTableNode **appsSegments[SIZE_BITS];
+    /* hash function applied to key strings */
+    size_t (*pfHash)(const char *pcKey);
+    /* random seed mixed into every hash code before it is
+       scrambled, varying the list order from table to table */
+    size_t uSeed;
+    /* binding counters, selected by the top bits of the scrambled
+       hash code */
+    struct SymTableCounter asCounters[NUM_COUNTERS];
+};
+
+/* value that a removed binding's pvValue is swapped for, so that a
+   replace racing with the remove cannot succeed after it */
+static char acRemoved[1];
+
+/* Returns link uNext with the removed mark cleared. */
+static struct SymTableNode *SymTable_unmarked(uintptr_t uNext) {
+    return (struct SymTableNode *)(uNext & ~(uintptr_t)1);
+}
+
+/* Returns 1 if link uNext carries the removed mark, 0 otherwise. */
+static int SymTable_isMarked(uintptr_t uNext) {
+    return (int)(uNext & 1);
+}
+
+/* Returns the bits of uBits in reverse order. */
+static size_t SymTable_reverseBits(size_t uBits) {
+    unsigned int uShift;
+    size_t uMask;
+
+    /* swap neighbouring bits, then pairs, nibbles, bytes and so on;
+       the masks are 0x55..., 0x33..., 0x0F..., 0x00FF... */
+    for (uShift = 1; uShift < SIZE_BITS; uShift *= 2) {
+        uMask = (size_t)-1 / (((size_t)1 << uShift) + 1);
+        uBits = ((uBits >> uShift) & uMask)
+                | ((uBits & uMask) << uShift);
+    }
+    return uBits;
+}
+
+/*
+ * Returns the hash code of key string pcKey, which is uLength
+ * characters long, in oSymTable, computed with the table's hash
+ * function. The default hash function is given the length, so it
+ * does not have to find the '\0' again.
+ */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return SymTable_hashBytes(pcKey, uLength);
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the hash code of interned key oKey in oSymTable. A table
+ * using the default hash function reuses the handle's precomputed
+ * hash code; any other table has to hash the handle's string.
+ */
+static size_t SymTable_handleHash(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return oKey->uHash;
+    return (*oSymTable->pfHash)(oKey->acKey);
+}
+
+/*
+ * Returns the hash code in oSymTable of key string pcKey, given the
+ * code uHash that SymTable_hashKey returns for it. A table using the
+ * default hash function takes uHash as is; any other table has to
+ * hash the string.
+ */
+static size_t SymTable_givenHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return uHash;
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the seeded hash code uHash of oSymTable scrambled with
+ * Fibonacci hashing, which moves every bit of the hash code into
+ * the top bits that the bucket index is taken from.
+ */
+static size_t SymTable_scramble(SymTable_T oSymTable, size_t uHash) {
+    return (uHash ^ oSymTable->uSeed) * FIBONACCI_MULTIPLIER;
+}
+
+/*
+ * Returns the address of the directory entry of bucket uBucket in
+ * oSymTable, allocating the entry's segment if iCreate is 1. Returns
+ * NULL if the segment does not exist and iCreate is 0, or if memory
+ * allocation fails.
+ */
+static struct SymTableNode **SymTable_bucketEntry(SymTable_T oSymTable,
+    size_t uBucket, int iCreate) {
+    struct SymTableNode **ppsSegment;
+    struct SymTableNode **ppsExpected = NULL;
+    size_t uSegment = 0;
+    size_t uFirst = 0;
+    size_t uSize = 1;
+
+    /* the segment is the number of bits in uBucket */
+    while ((uBucket >> uSegment) != 0)
+        uSegment++;
+    if (uSegment > 0) {
+        uFirst = (size_t)1 << (uSegment - 1);
+        uSize = uFirst;
+    }
+
+    ppsSegment = __atomic_load_n(&oSymTable->appsSegments[uSegment],
+                                 __ATOMIC_ACQUIRE);
+    if (ppsSegment == NULL) {
+        if (!iCreate)
+            return NULL;
+        ppsSegment = calloc(uSize, sizeof(struct SymTableNode *));
+        if (ppsSegment == NULL)
+            return NULL;
+        /* another thread may have installed one first */
+        if (!__atomic_compare_exchange_n(
+                &oSymTable->appsSegments[uSegment], &ppsExpected,
+                ppsSegment, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(ppsSegment);
+            ppsSegment = ppsExpected;
+        }
+    }
+    return &ppsSegment[uBucket - uFirst];
+}
+
+/* Returns the dummy of bucket uBucket, or NULL if it has none yet. */
+static struct SymTableNode *SymTable_bucketDummy(SymTable_T oSymTable,
+    size_t uBucket) {
+    struct SymTableNode **ppsEntry;
+
+    ppsEntry = SymTable_bucketEntry(oSymTable, uBucket, 0);
+    if (ppsEntry == NULL)
+        return NULL;
+    return __atomic_load_n(ppsEntry, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Returns 1 if node psNode, which is not a dummy, is the binding of
+ * the key made of the uLength characters at pcKey, whose handle is
+ * oKey (NULL if unknown). Two handles are compared by address alone.
+ */
+static int SymTable_isKey(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey) {
+    if (oKey != NULL && psNode->oKey != NULL)
+        return psNode->oKey == oKey;
+    return SymTable_keyEquals(psNode->oKey != NULL ? psNode->oKey->acKey
+                                                   : psNode->acKey,
+                              pcKey, uLength);
+}
+
+/*
+ * Helper function that searches the list, starting after node
+ * psStart, for the node with order key uOrderKey. For an odd order
+ * key that is the binding of the key made of the uLength characters
+ * at pcKey (handle oKey, NULL if unknown); for an even one it is a
+ * dummy. Removed nodes met on the way are unlinked and their free
+ * deferred. Sets *ppuLink to the address of the link that points to
+ * the node found, or to the place the node would be inserted, and
+ * returns the node found, or NULL if there is none. In that case,
+ * unless ppsNext is NULL, sets *ppsNext to the node the link was
+ * seen to point to: a new node must be linked in only if the link
+ * still points there, since a node that took its place since may
+ * belong before the new one. The caller must be inside an epoch.
+ */
+static struct SymTableNode *SymTable_find(struct SymTableNode *psStart,
+    size_t uOrderKey, const char *pcKey, size_t uLength,
+    SymTableKey_T oKey, uintptr_t **ppuLink,
+    struct SymTableNode **ppsNext) {
+    uintptr_t *puLink;
+    struct SymTableNode *psNode;
+    uintptr_t uNext;
+    uintptr_t uExpected;
+
+retry:
+    puLink = &psStart->uNext;
+    psNode = SymTable_unmarked(__atomic_load_n(puLink,
+                                               __ATOMIC_ACQUIRE));
+    for (;;) {
+        if (psNode == NULL)
+            break;
+        uNext = __atomic_load_n(&psNode->uNext, __ATOMIC_ACQUIRE);
+        /* the link into psNode changed under us; start over */
+        if (__atomic_load_n(puLink, __ATOMIC_ACQUIRE)
+            != (uintptr_t)psNode)
+            goto retry;
+
+        /* unlink a removed node. whoever unlinks it defers its free */
+        if (SymTable_isMarked(uNext)) {
+            uExpected = (uintptr_t)psNode;
+            if (!__atomic_compare_exchange_n(
+                    puLink, &uExpected, uNext & ~(uintptr_t)1, 0,
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                goto retry;
+            psNode->sGarbage.psNext = NULL;
+            SymTable_deferFree(&psNode->sGarbage);
+            psNode = SymTable_unmarked(uNext);
+            continue;
+        }
+
+        if (psNode->uOrderKey > uOrderKey)
+            break;
+        /* order keys may collide, so a binding's whole run of equal
+           order keys is searched */
+        if (psNode->uOrderKey == uOrderKey
+            && ((uOrderKey & 1) == 0
+                || SymTable_isKey(psNode, pcKey, uLength, oKey))) {
+            *ppuLink = puLink;
+            return psNode;
+        }
+        puLink = &psNode->uNext;
+        psNode = SymTable_unmarked(uNext);
+    }
+    *ppuLink = puLink;
+    if (ppsNext != NULL)
+        *ppsNext = psNode;
+    return NULL;
+}
+
+/*
+ * Returns the dummy of the nearest bucket of oSymTable that has one
+ * among bucket uBucket and the buckets it was split from: uBucket
+ * with its highest set bits cleared one by one. Bucket 0 always has
+ * a dummy.
+ */
+static struct SymTableNode *SymTable_nearestDummy(SymTable_T oSymTable,
+    size_t uBucket) {
+    struct SymTableNode *psDummy;
+    size_t uHighBit;
+
+    for (;;) {
+        psDummy = SymTable_bucketDummy(oSymTable, uBucket);
+        if (psDummy != NULL)
+            return psDummy;
+        /* the bucket was split from uBucket without its top bit */
+        for (uHighBit = (size_t)1 << (SIZE_BITS - 1);
+             (uBucket & uHighBit) == 0; uHighBit >>= 1)
+            ;
+        uBucket &= ~uHighBit;
+    }
+}
+
+/*
+ * Helper function that gives bucket uBucket of oSymTable its dummy,
+ * giving the buckets it was split from theirs first. Returns the
+ * dummy, or the nearest existing one that precedes it if memory
+ * allocation fails; either is a correct place to start a search for
+ * a key of the bucket. The caller must be inside an epoch.
+ */
+static struct SymTableNode *SymTable_initBucket(SymTable_T oSymTable,
+    size_t uBucket) {
+    struct SymTableNode **ppsEntry;
+    struct SymTableNode *psParent;
+    struct SymTableNode *psDummy;
+    struct SymTableNode *psFound;
+    struct SymTableNode *psNext;
+    struct SymTableNode *psExpected;
+    uintptr_t *puLink;
+    uintptr_t uExpected;
+    size_t uHighBit;
+
+    psDummy = SymTable_bucketDummy(oSymTable, uBucket);
+    if (psDummy != NULL)
+        return psDummy;
+
+    for (uHighBit = (size_t)1 << (SIZE_BITS - 1);
+         (uBucket & uHighBit) == 0; uHighBit >>= 1)
+        ;
+    psParent = SymTable_initBucket(oSymTable, uBucket & ~uHighBit);
+
+    ppsEntry = SymTable_bucketEntry(oSymTable, uBucket, 1);
+    psDummy = malloc(sizeof(struct SymTableNode) + 1);
+    if (ppsEntry == NULL || psDummy == NULL) {
+        free(psDummy);
+        return psParent;
+    }
+    psDummy->uOrderKey = SymTable_reverseBits(uBucket);
+    psDummy->pvValue = NULL;
+    psDummy->uHash = 0;
+    psDummy->oKey = NULL;
+    psDummy->acKey[0] = '\0';
+
+    /* link the dummy in, unless another thread got there first */
+    for (;;) {
+        psFound = SymTable_find(psParent, psDummy->uOrderKey, NULL, 0,
+                                NULL, &puLink, &psNext);
+        if (psFound != NULL) {
+            free(psDummy);
+            psDummy = psFound;
+            break;
+        }
+        psDummy->uNext = (uintptr_t)psNext;
+        uExpected = psDummy->uNext;
+        if (__atomic_compare_exchange_n(puLink, &uExpected,
+                                        (uintptr_t)psDummy, 0,
+                                        __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED))
+            break;
+    }
+
+    /* dummies are never removed, so every thread publishes the same
+       one */
+    psExpected = NULL;
+    (void)__atomic_compare_exchange_n(ppsEntry, &psExpected, psDummy, 0,
+                                      __ATOMIC_RELEASE,
+                                      __ATOMIC_RELAXED);
+    return psDummy;
+}
+
+/*
+ * Returns the bucket of a key whose scrambled hash code is
+ * uScrambled in oSymTable with its current number of buckets.
+ */
+static size_t SymTable_bucket(SymTable_T oSymTable, size_t uScrambled) {
+    return SymTable_reverseBits(uScrambled)
+           & (__atomic_load_n(&oSymTable->uNumBuckets, __ATOMIC_ACQUIRE)
+              - 1);
+}
+
+/* Returns the binding counter of a key whose scrambled hash code is
+   uScrambled. */
+static size_t *SymTable_counter(SymTable_T oSymTable,
+    size_t uScrambled) {
+    return &oSymTable->asCounters[uScrambled
+                                  >> (SIZE_BITS - COUNTER_BITS)]
+                .uCount;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_new(void) {
+    return SymTable_newWithHash(SymTable_hashString);
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with pfHash, and allocate memory for the symbol table
+ * structure and the dummy of bucket 0, which heads the list.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    SymTable_T oSymTable;
+    struct SymTableNode *psHead;
+    struct SymTableNode **ppsEntry;
+    size_t i;
+
+    assert(pfHash != NULL);
+
+    /* memory allocation for SymTable, with no segments yet */
+    oSymTable = calloc(1, sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+    oSymTable->uNumBuckets = INITIAL_BUCKET_COUNT;
+    oSymTable->pfHash = pfHash;
+    oSymTable->uSeed = SymTable_newSeed();
+
+    psHead = malloc(sizeof(struct SymTableNode) + 1);
+    ppsEntry = SymTable_bucketEntry(oSymTable, 0, 1);
+    if (psHead == NULL || ppsEntry == NULL) {
+        free(psHead);
+        for (i = 0; i < SIZE_BITS; i++)
+            free(oSymTable->appsSegments[i]);
+        free(oSymTable);
+        return NULL;
+    }
+    psHead->uOrderKey = 0;
+    psHead->uNext = 0;
+    psHead->pvValue = NULL;
+    psHead->uHash = 0;
+    psHead->oKey = NULL;
+    psHead->acKey[0] = '\0';
+    *ppsEntry = psHead;
+
+    return oSymTable;
+}
+
+/*
+ * Returns the number of buckets that holds uCapacity bindings
+ * without growing: the smallest power of two, at least
+ * INITIAL_BUCKET_COUNT, that keeps the load at or below
+ * RESIZE_FACTOR, or the most buckets a table can have.
+ */
+static size_t SymTable_bucketCountFor(size_t uCapacity) {
+    size_t uNumBuckets = INITIAL_BUCKET_COUNT;
+
+    while (uCapacity / RESIZE_FACTOR > uNumBuckets
+           && uNumBuckets < (size_t)1 << (SIZE_BITS - 1))
+        uNumBuckets *= 2;
+    return uNumBuckets;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function and starts out with enough
+ * buckets for uCapacity bindings. Buckets only get their dummies
+ * when first used, so no more memory is allocated up front than
+ * for any new table.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable != NULL)
+        oSymTable->uNumBuckets = SymTable_bucketCountFor(uCapacity);
+    return oSymTable;
+}
+
+/*
+ * Makes room in oSymTable for uCapacity bindings in all by raising
+ * its number of buckets, unless another thread raised it as far
+ * first. Nothing moves and nothing is allocated, so this always
+ * returns 1.
+ */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    size_t uNumBuckets;
+    size_t uNewNumBuckets;
+
+    assert(oSymTable != NULL);
+
+    uNewNumBuckets = SymTable_bucketCountFor(uCapacity);
+    uNumBuckets = __atomic_load_n(&oSymTable->uNumBuckets,
+                                  __ATOMIC_RELAXED);
+    while (uNumBuckets < uNewNumBuckets
+           && !__atomic_compare_exchange_n(&oSymTable->uNumBuckets,
+                                           &uNumBuckets, uNewNumBuckets,
+                                           0, __ATOMIC_RELEASE,
+                                           __ATOMIC_RELAXED))
+        ;
+    return 1;
+}
+
+/*
+ * Leaves oSymTable as it is and returns 1. Removed nodes are
+ * already reclaimed as removes retire them, and dummies stay in the
+ * list for good, since lookups in other threads may start from any
+ * of them; there is nothing left for compacting to give back.
+ */
+int SymTable_compact(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return 1;
+}
+
+/*
+ * Lookups must not change a table that other threads read without
+ * locks, and the list is kept in the order of the keys' hashes;
+ * iPolicy is accepted and ignored.
+ */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    (void)iPolicy;
+}
+
+/*
+ * Lookups read the list without locks while other threads put and
+ * remove, which a filter that is refilled could not keep up with;
+ * iEnable is accepted and ignored.
+ */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+    (void)iEnable;
+    return 1;
+}
+
+/*
+ * Free all memory associated with symbol table oSymTable.
+ * Thus key-value bindings, dummies and the directory as well as the
+ * symbol table itself are freed. No other thread may be using
+ * oSymTable. Nodes of oSymTable already waiting on a garbage list
+ * are freed later.
+ */
+void SymTable_free(SymTable_T oSymTable) {
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /* removed nodes still linked in are nobody's garbage yet */
+    for (psCurrentNode = SymTable_bucketDummy(oSymTable, 0);
+         psCurrentNode != NULL; psCurrentNode = psNextNode) {
+        psNextNode = SymTable_unmarked(psCurrentNode->uNext);
+        free(psCurrentNode);
+    }
+    for (i = 0; i < SIZE_BITS; i++)
+        free(oSymTable->appsSegments[i]);
+    free(oSymTable);
+}
+
+/*
+ * Returns number of bindings in oSymTable. While other threads are
+ * changing oSymTable, the count may be off by the bindings they add
+ * or remove during the call.
+ */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    size_t uNumBindings = 0;
+    int i;
+
+    assert(oSymTable != NULL);
+
+    /* each counter may have wrapped, but not their sum */
+    for (i = 0; i < NUM_COUNTERS; i++)
+        uNumBindings += __atomic_load_n(
+            &oSymTable->asCounters[i].uCount, __ATOMIC_RELAXED);
+    return uNumBindings;
+}
+
+/*
+ * Helper function that doubles the number of buckets of oSymTable
+ * if the counter of a key whose scrambled hash code is uScrambled
+ * suggests that the buckets hold more than RESIZE_FACTOR bindings
+ * each. Nothing moves: new buckets get their dummies when first
+ * used.
+ */
+static void SymTable_grow(SymTable_T oSymTable, size_t uScrambled) {
+    size_t uNumBuckets;
+    size_t uEstimate;
+
+    uNumBuckets = __atomic_load_n(&oSymTable->uNumBuckets,
+                                  __ATOMIC_RELAXED);
+    /* one counter sees about 1/NUM_COUNTERS of the bindings */
+    uEstimate = __atomic_load_n(SymTable_counter(oSymTable, uScrambled),
+                                __ATOMIC_RELAXED);
+    if (uEstimate > ((size_t)-1) / NUM_COUNTERS)
+        return;
+    if (uEstimate * NUM_COUNTERS / RESIZE_FACTOR <= uNumBuckets
+        || uNumBuckets >= (size_t)1 << (SIZE_BITS - 1))
+        return;
+    /* if another thread grew the table first, that will do */
+    (void)__atomic_compare_exchange_n(&oSymTable->uNumBuckets,
+                                      &uNumBuckets, uNumBuckets * 2, 0,
+                                      __ATOMIC_RELEASE,
+                                      __ATOMIC_RELAXED);
+}
+
+/*
+ * Helper function that returns the node of oSymTable holding the
+ * key made of the uLength characters at pcKey, whose hash code is
+ * uHash, adding a binding of the key and pvValue first if it
+ * doesn't exist in oSymTable. If oKey is
+ * not NULL, pcKey is its string and a new node refers to the handle
+ * instead of copying the key. The node is only made once the key
+ * is found missing, and is kept across retries. Sets *piCreated to
+ * 1 if the binding was added and 0 otherwise. Returns NULL if
+ * memory allocation fails.
+ */
+static struct SymTableNode *SymTable_findOrAddKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue, int *piCreated) {
+    struct SymTableReader *psReader;
+    struct SymTableNode *psNewNode = NULL;
+    struct SymTableNode *psStart;
+    struct SymTableNode *psNode;
+    struct SymTableNode *psNext;
+    uintptr_t *puLink;
+    uintptr_t uExpected;
+    size_t uScrambled = SymTable_scramble(oSymTable, uHash);
+    size_t uKeySize;
+
+    *piCreated = 0;
+    psReader = SymTable_enterEpoch();
+    psStart = SymTable_initBucket(oSymTable,
+                                  SymTable_bucket(oSymTable,
+                                                  uScrambled));
+    for (;;) {
+        /* does not insert key if it already exists */
+        psNode = SymTable_find(psStart, uScrambled | 1, pcKey, uLength,
+                               oKey, &puLink, &psNext);
+        if (psNode != NULL)
+            break;
+
+        if (psNewNode == NULL) {
+            /* a handle already is a stable copy, so it is not copied */
+            if (oKey == NULL && uLength == (size_t)-1)
+                break;
+            uKeySize = (oKey != NULL) ? 1 : uLength + 1;
+            psNewNode = malloc(sizeof(struct SymTableNode) + uKeySize);
+            if (psNewNode == NULL)
+                break;
+            if (oKey != NULL)
+                psNewNode->acKey[0] = '\0';
+            else {
+                memcpy(psNewNode->acKey, pcKey, uLength);
+                psNewNode->acKey[uLength] = '\0';
+            }
+            psNewNode->uOrderKey = uScrambled | 1;
+            psNewNode->pvValue = (void *)pvValue;
+            psNewNode->uHash = uHash;
+            psNewNode->oKey = oKey;
+        }
+
+        /* the release makes the node's fields visible before it. the
+           exchange fails if the link changed or was marked since the
+           search, and the search is done again */
+        psNewNode->uNext = (uintptr_t)psNext;
+        uExpected = psNewNode->uNext;
+        if (__atomic_compare_exchange_n(puLink, &uExpected,
+                                        (uintptr_t)psNewNode, 0,
+                                        __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {
+            psNode = psNewNode;
+            *piCreated = 1;
+            break;
+        }
+    }
+    SymTable_leaveEpoch(psReader);
+
+    if (!*piCreated) {
+        free(psNewNode);
+        return psNode;
+    }
+    (void)__atomic_add_fetch(SymTable_counter(oSymTable, uScrambled), 1,
+                             __ATOMIC_RELAXED);
+    SymTable_grow(oSymTable, uScrambled);
+    return psNode;
+}
+
+/*
+ * Helper function that adds a binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash, and pvValue
+ * to oSymTable if the key doesn't exist in
+ * oSymTable. If oKey is not NULL, pcKey is its string and the node
+ * refers to the handle instead of copying the key.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue) {
+    int iCreated;
+
+    SymTable_findOrAddKey(oSymTable, pcKey, uLength, uHash, oKey,
+                          pvValue, &iCreated);
+    return iCreated;
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL, pvValue);
+}
+
+/*
+ * Adds new binding of interned key oKey, pvValue to oSymTable
+ * if the key doesn't exist in oSymTable, using the handle's
+ * precomputed hash code. returns 1 if binding was added, returns 0
+ * if memory allocation fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey,
+                           pvValue);
+}
+
+/*
+ * Helper function that looks up the key made of the uLength
+ * characters at pcKey, whose hash code is uHash and whose handle is
+ * oKey (NULL if unknown), in oSymTable without
+ * writing anything but the calling thread's own reader record. If
+ * the key exists, sets *ppvValue to its value and, if iReplace is
+ * 1, replaces the value with pvValue. Returns 1 if the key exists,
+ * and 0 otherwise.
+ */
+static int SymTable_access(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey, void **ppvValue,
+    int iReplace, const void *pvValue) {
+    struct SymTableReader *psReader;
+    struct SymTableNode *psNode;
+    uintptr_t uNext;
+    size_t uScrambled = SymTable_scramble(oSymTable, uHash);
+    size_t uOrderKey = uScrambled | 1;
+    void *pvOldValue = acRemoved;
+
+    psReader = SymTable_enterEpoch();
+    /* a lookup does not help unlink removed nodes, it skips them */
+    psNode = SymTable_nearestDummy(oSymTable,
+                                   SymTable_bucket(oSymTable,
+                                                   uScrambled));
+    for (psNode = SymTable_unmarked(
+             __atomic_load_n(&psNode->uNext, __ATOMIC_ACQUIRE));
+         psNode != NULL && psNode->uOrderKey <= uOrderKey;
+         psNode = SymTable_unmarked(uNext)) {
+        uNext = __atomic_load_n(&psNode->uNext, __ATOMIC_ACQUIRE);
+        if (psNode->uOrderKey == uOrderKey && !SymTable_isMarked(uNext)
+            && SymTable_isKey(psNode, pcKey, uLength, oKey))
+            break;
+    }
+    if (psNode != NULL && psNode->uOrderKey == uOrderKey) {
+        pvOldValue = __atomic_load_n(&psNode->pvValue,
+                                     __ATOMIC_ACQUIRE);
+        /* fails once a remove has swapped in acRemoved */
+        while (iReplace && pvOldValue != acRemoved
+               && !__atomic_compare_exchange_n(&psNode->pvValue,
+                                               &pvOldValue,
+                                               (void *)pvValue, 0,
+                                               __ATOMIC_ACQ_REL,
+                                               __ATOMIC_ACQUIRE))
+            ;
+    }
+    SymTable_leaveEpoch(psReader);
+
+    if (pvOldValue == acRemoved)
+        return 0;
+    *ppvValue = pvOldValue;
+    return 1;
+}
+
+/*
+ * replace old value (pvOldValue) of key pcKey in oSymTable
+ * with new value pvValue and returns pvOldValue.
+ * if the given pcKey doesn't exist within oSymTable,
+ * returns NULL
+ */
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+    void *pvOldValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    (void)SymTable_access(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          NULL, &pvOldValue, 1, pvValue);
+    return pvOldValue;
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    void *pvOldValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    (void)SymTable_access(oSymTable, oKey->acKey, oKey->uLength,
+                          SymTable_handleHash(oSymTable, oKey), oKey,
+                          &pvOldValue, 1, pvValue);
+    return pvOldValue;
+}
+
+/*
+ * Returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. Sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. The key is hashed and its run
+ * searched once, unless a racing insert forces a retry. Nodes never
+ * move, but a removed binding's node is freed once no reader needs
+ * it, so the address is only good until the key is removed.
+ * Returns NULL if memory allocation fails.
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    size_t uLength;
+    struct SymTableNode *psNode;
+    int iCreated;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    psNode = SymTable_findOrAddKey(oSymTable, pcKey, uLength,
+                                   SymTable_hash(oSymTable, pcKey,
+                                                 uLength),
+                                   NULL, pvValue, &iCreated);
+    if (psNode == NULL)
+        return NULL;
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &psNode->pvValue;
+}
+
+/*
+ * Checks if given key pcKey exists within oSymTable.
+ * Returns 1 if pcKey exists, if else returns 0
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_access(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL, &pvValue, 0, NULL);
+}
+
+/*
+ * Checks if interned key oKey exists within oSymTable.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_access(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey,
+                           &pvValue, 0, NULL);
+}
+
+/*
+ * Returns value associated with key pcKey if it exists
+ * within oSymTable, returns NULL if can't find given pcKey
+ * in oSymTable
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    (void)SymTable_access(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          NULL, &pvValue, 0, NULL);
+    return pvValue;
+}
+
+/*
+ * Returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
+ */
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    (void)SymTable_access(oSymTable, oKey->acKey, oKey->uLength,
+                          SymTable_handleHash(oSymTable, oKey), oKey,
+                          &pvValue, 0, NULL);
+    return pvValue;
+}
+
+/*
+ * Stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. The keys are taken BATCH_SIZE at a time, each batch
+ * in one reading stretch: all of them are hashed and their buckets'
+ * directory entries prefetched, then the first node after each
+ * bucket's dummy, and then the runs of the buckets are walked side
+ * by side, one node per key per round, with the next node of every
+ * run prefetched before any is compared. Like SymTable_get, this
+ * writes nothing but the calling thread's reader record.
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    struct SymTableNode *apsNodes[BATCH_SIZE];
+    size_t auOrderKeys[BATCH_SIZE];
+    size_t auLengths[BATCH_SIZE];
+    size_t auBuckets[BATCH_SIZE];
+    struct SymTableReader *psReader;
+    struct SymTableNode **ppsEntry;
+    struct SymTableNode *psNode;
+    uintptr_t uNext;
+    void *pvValue;
+    size_t uFirst;
+    size_t uCount;
+    size_t i;
+    int iPending;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+
+    for (uFirst = 0; uFirst < uNumKeys; uFirst += uCount) {
+        uCount = uNumKeys - uFirst;
+        if (uCount > BATCH_SIZE)
+            uCount = BATCH_SIZE;
+
+        psReader = SymTable_enterEpoch();
+        for (i = 0; i < uCount; i++) {
+            assert(apcKeys[uFirst + i] != NULL);
+            auLengths[i] = strlen(apcKeys[uFirst + i]);
+            auOrderKeys[i] = SymTable_scramble(
+                oSymTable, SymTable_hash(oSymTable, apcKeys[uFirst + i],
+                                         auLengths[i]));
+            auBuckets[i] = SymTable_bucket(oSymTable, auOrderKeys[i]);
+            auOrderKeys[i] |= 1;
+            ppsEntry = SymTable_bucketEntry(oSymTable, auBuckets[i], 0);
+            if (ppsEntry != NULL)
+                __builtin_prefetch(ppsEntry);
+            apvValues[uFirst + i] = NULL;
+        }
+        for (i = 0; i < uCount; i++) {
+            psNode = SymTable_nearestDummy(oSymTable, auBuckets[i]);
+            apsNodes[i] = SymTable_unmarked(
+                __atomic_load_n(&psNode->uNext, __ATOMIC_ACQUIRE));
+            if (apsNodes[i] != NULL)
+                __builtin_prefetch(apsNodes[i]);
+        }
+
+        /* a run drops out once its key is found or passed */
+        do {
+            iPending = 0;
+            for (i = 0; i < uCount; i++) {
+                psNode = apsNodes[i];
+                if (psNode == NULL)
+                    continue;
+                if (psNode->uOrderKey > auOrderKeys[i]) {
+                    apsNodes[i] = NULL;
+                    continue;
+                }
+                uNext = __atomic_load_n(&psNode->uNext,
+                                        __ATOMIC_ACQUIRE);
+                if (psNode->uOrderKey == auOrderKeys[i]
+                    && !SymTable_isMarked(uNext)
+                    && SymTable_isKey(psNode, apcKeys[uFirst + i],
+                                      auLengths[i], NULL)) {
+                    pvValue = __atomic_load_n(&psNode->pvValue,
+                                              __ATOMIC_ACQUIRE);
+                    if (pvValue != acRemoved)
+                        apvValues[uFirst + i] = pvValue;
+                    apsNodes[i] = NULL;
+                    continue;
+                }
+                apsNodes[i] = SymTable_unmarked(uNext);
+                if (apsNodes[i] != NULL) {
+                    __builtin_prefetch(apsNodes[i]);
+                    iPending = 1;
+                }
+            }
+        } while (iPending);
+        SymTable_leaveEpoch(psReader);
+    }
+}
+
+/*
+ * Helper function that removes the binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash and whose
+ * handle is oKey (NULL if unknown), from oSymTable. The remove
+ * takes effect when the node's link is marked; unlinking it
+ * afterwards is only tidying up, which any thread that passes by
+ * may do. Returns the value of the removed binding, or NULL if the
+ * key did not exist.
+ */
+static void *SymTable_removeKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey) {
+    struct SymTableReader *psReader;
+    struct SymTableNode *psStart;
+    struct SymTableNode *psNode;
+    uintptr_t *puLink;
+    uintptr_t uNext;
+    uintptr_t uExpected;
+    size_t uScrambled = SymTable_scramble(oSymTable, uHash);
+    size_t uOrderKey = uScrambled | 1;
+    void *pvValue = NULL;
+
+    psReader = SymTable_enterEpoch();
+    psStart = SymTable_initBucket(oSymTable,
+                                  SymTable_bucket(oSymTable,
+                                                  uScrambled));
+    for (;;) {
+        psNode = SymTable_find(psStart, uOrderKey, pcKey, uLength, oKey,
+                               &puLink, NULL);
+        if (psNode == NULL)
+            break;
+        uNext = __atomic_load_n(&psNode->uNext, __ATOMIC_ACQUIRE);
+        /* another thread is removing it; search again to see */
+        if (SymTable_isMarked(uNext))
+            continue;
+        if (!__atomic_compare_exchange_n(&psNode->uNext, &uNext,
+                                         uNext | 1, 0, __ATOMIC_ACQ_REL,
+                                         __ATOMIC_ACQUIRE))
+            continue;
+
+        /* the binding is ours to remove */
+        pvValue = __atomic_exchange_n(&psNode->pvValue, acRemoved,
+                                      __ATOMIC_ACQ_REL);
+        (void)__atomic_sub_fetch(
+            SymTable_counter(oSymTable, uScrambled), 1,
+            __ATOMIC_RELAXED);
+        uExpected = (uintptr_t)psNode;
+        if (__atomic_compare_exchange_n(puLink, &uExpected, uNext, 0,
+                                        __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED)) {
+            psNode->sGarbage.psNext = NULL;
+            SymTable_deferFree(&psNode->sGarbage);
+        }
+        else
+            /* leave it to a search to unlink and defer */
+            (void)SymTable_find(psStart, uOrderKey, pcKey, uLength,
+                                oKey, &puLink, NULL);
+        break;
+    }
+    SymTable_leaveEpoch(psReader);
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with given pcKey from the
+ * symbol table (oSymTable) and frees memory once no other thread
+ * can still be reading it.
+ * Return the value associated with removed key if key existed
+ * in oSymTable. return NULL otherwise.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeKey(oSymTable, pcKey, uLength,
+                              SymTable_hash(oSymTable, pcKey, uLength),
+                              NULL);
+}
+
+/*
+ * Removes binding associated with interned key oKey from
+ * oSymTable and frees memory once no other thread can still be
+ * reading it. Return the value associated with the removed key if
+ * it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_removeKey(oSymTable, oKey->acKey, oKey->uLength,
+                              SymTable_handleHash(oSymTable, oKey),
+                              oKey);
+}
+
+/*
+ * Adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. The characters are copied, with a '\0' added.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return 0;
+    return SymTable_putKey(oSymTable, pcKey, uLength, uHash, NULL,
+                           pvValue);
+}
+
+/*
+ * Checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable. Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return 0;
+    return SymTable_access(oSymTable, pcKey, uLength, uHash, NULL,
+                           &pvValue, 0, NULL);
+}
+
+/*
+ * Returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    (void)SymTable_access(oSymTable, pcKey, uLength, uHash, NULL,
+                          &pvValue, 0, NULL);
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with the key made of the uLength
+ * characters at pcKey from oSymTable and frees memory once no other
+ * thread can still be reading it. Return the value associated with
+ * the removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    return SymTable_removeKey(oSymTable, pcKey, uLength, uHash, NULL);
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to oSymTable if the key pcKey
+ * doesn't exist in oSymTable, using uHash, the code SymTable_hashKey
+ * returns for pcKey, instead of hashing it again.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_givenHash(oSymTable, pcKey, uHash),
+                           NULL, pvValue);
+}
+
+/*
+ * Returns value associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    size_t uLength;
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    (void)SymTable_access(oSymTable, pcKey, uLength,
+                          SymTable_givenHash(oSymTable, pcKey, uHash),
+                          NULL, &pvValue, 0, NULL);
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, from oSymTable and frees memory once no other
+ * thread can still be reading it. Return the value associated with
+ * the removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeKey(oSymTable, pcKey, uLength,
+                              SymTable_givenHash(oSymTable, pcKey,
+                                                 uHash),
+                              NULL);
+}
+
+/*
+ * To each binding in oSymTable, apply function (pfApply) given by
+ * the user. user is able to input additional parameter pvExtra
+ * if needed for the user defined function. pfApply may use and
+ * change oSymTable; bindings that other threads or pfApply add or
+ * remove during the call may or may not be visited.
+ */
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableReader *psReader;
+    struct SymTableNode *psCurrentNode;
+    uintptr_t uNext;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    psReader = SymTable_enterEpoch();
+    for (psCurrentNode = SymTable_bucketDummy(oSymTable, 0);
+         psCurrentNode != NULL;
+         psCurrentNode = SymTable_unmarked(uNext)) {
+        uNext = __atomic_load_n(&psCurrentNode->uNext,
+                                __ATOMIC_ACQUIRE);
+        /* skip dummies and removed bindings */
+        if ((psCurrentNode->uOrderKey & 1) == 0
+            || SymTable_isMarked(uNext))
+            continue;
+        pvValue = __atomic_load_n(&psCurrentNode->pvValue,
+                                  __ATOMIC_ACQUIRE);
+        if (pvValue != acRemoved)
+            (*pfApply)(psCurrentNode->oKey != NULL
+                       ? psCurrentNode->oKey->acKey
+                       : psCurrentNode->acKey,
+                       pvValue, (void *)pvExtra);
+    }
+    SymTable_leaveEpoch(psReader);
+}
+
+/*
+ * Works like SymTable_map. All bindings are in one list, which can
+ * only be split by walking it, so the calling thread applies
+ * pfApply to every binding and iThreadCount is ignored.
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    (void)iThreadCount;
+    SymTable_map(oSymTable, pfApply, pvExtra);
+}
+
+/*
+ * To each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function *pfApply with pvExtra as extra
+ * argument, in key order. A NULL bound leaves that end open.
+ * The list is ordered by bit-reversed hash code, not by key, so
+ * every binding is walked with a cursor, which lets other threads
+ * go on changing oSymTable, and those in range are sorted before
+ * pfApply sees them.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    return SymTable_mapSorted(oSymTable, pcLow, pcHigh, NULL, pfApply,
+                              pvExtra);
+}
+
+/*
+ * To each binding of oSymTable whose key starts with pcPrefix,
+ * apply function *pfApply with pvExtra as extra argument, in key
+ * order, collecting and sorting them like SymTable_mapRange.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    assert(pcPrefix != NULL);
+    return SymTable_mapSorted(oSymTable, NULL, NULL, pcPrefix, pfApply,
+                              pvExtra);
+}
+
+/*
+ * Opens cursor *psIter over the bindings of oSymTable. The cursor
+ * stays inside an epoch until it is closed, so that the nodes it
+ * could still reach are not freed, and walks the one list in split
+ * order. Nodes never move, and a removed node still links to the
+ * rest of the list, so every binding that stays in oSymTable is
+ * found exactly once.
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->pvReader = SymTable_enterEpoch();
+    psIter->pvNode = SymTable_bucketDummy(oSymTable, 0);
+}
+
+/*
+ * Moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. Returns 0 once every
+ * binding has been returned. pvNode is the next node to look at.
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    struct SymTableNode *psCurrentNode;
+    uintptr_t uNext;
+    void *pvValue;
+
+    assert(psIter != NULL);
+
+    for (psCurrentNode = psIter->pvNode; psCurrentNode != NULL;
+         psCurrentNode = SymTable_unmarked(uNext)) {
+        uNext = __atomic_load_n(&psCurrentNode->uNext,
+                                __ATOMIC_ACQUIRE);
+        /* skip dummies and removed bindings */
+        if ((psCurrentNode->uOrderKey & 1) == 0
+            || SymTable_isMarked(uNext))
+            continue;
+        pvValue = __atomic_load_n(&psCurrentNode->pvValue,
+                                  __ATOMIC_ACQUIRE);
+        if (pvValue != acRemoved)
+            break;
+    }
+    if (psCurrentNode == NULL) {
+        psIter->pvNode = NULL;
+        return 0;
+    }
+    psIter->pvNode = SymTable_unmarked(uNext);
+
+    if (ppcKey != NULL)
+        *ppcKey = psCurrentNode->oKey != NULL
+                  ? psCurrentNode->oKey->acKey : psCurrentNode->acKey;
+    if (ppvValue != NULL)
+        *ppvValue = pvValue;
+    return 1;
+}
+
+/*
+ * Closes cursor *psIter, ending its epoch. Must run on the thread
+ * that opened the cursor.
+ */
+void SymTable_end(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+    SymTable_leaveEpoch(psIter->pvReader);
+}
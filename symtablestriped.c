@@ -0,0 +1,1398 @@
+/*
+ * symtablestriped.c
+ *
+ * Thread-safe symbol table module implementation via hash table &
+ * separate chaining with lock striping. The buckets are split into
+ * NUM_STRIPES stripes, each with its own bucket array and mutex, so
+ * threads working on different stripes never wait for each other.
+ * Lookups take no lock at all; memory they might still be reading
+ * is freed through epoch-based reclamation (symtableepoch.c).
+ * functionalities include:
+ * - creating and deleting a symbol table
+ * - adding and removing key-value pairs
+ * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
+ * - applying a user-defined function to each entry
+ * - applying it with several threads at once
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - sizing a table in advance for a known number of bindings
+ * - compacting a table to the size of its bindings
+ *
+ * Every function except SymTable_new, SymTable_newWithHash,
+ * SymTable_newWithCapacity and SymTable_free may be called by any
+ * number of threads at once.
+ * SymTable_intern may also be called from any thread.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtableepoch.h"
+#include "symtablekey.h"
+#include "symtablepool.h"
+/* number of bits needed to index the stripes */
+#define STRIPE_BITS 6
+#define NUM_STRIPES (1 << STRIPE_BITS)
+/* each stripe starts with 8 buckets, 512 in the whole table */
+#define INITIAL_STRIPE_BUCKET_BITS 3
+#define RESIZE_FACTOR 0.5
+/* keeps the locks of neighbouring stripes on different cache lines */
+#define CACHE_LINE_SIZE 64
+/* number of lookups SymTable_getBatch keeps in flight at once */
+#define BATCH_SIZE 16
+
+/* multiplier for Fibonacci hashing: 2^w divided by the golden ratio */
+#if SIZE_MAX > 0xFFFFFFFFu
+#define FIBONACCI_MULTIPLIER ((size_t)11400714819323198485u)
+#else
+#define FIBONACCI_MULTIPLIER ((size_t)2654435769u)
+#endif
+
+/* key value pair node structure. the node and its key are one
+   allocation, with the key's bytes stored right after the node.
+   once a node is reachable from a bucket, only pvValue and psNext
+   change, and lookups load both atomically */
+struct SymTableNode {
+    /* link in the garbage list once the node is unlinked */
+    struct SymTableGarbage sGarbage;
+    /* value for key */
+    void *pvValue;
+    /* full hash code of the key, before reduction to a bucket index */
+    size_t uHash;
+    /* pointer to next node in the bucket */
+    struct SymTableNode *psNext;
+    /* handle the binding was put with, or NULL if it was put with a
+       key string. if not NULL, acKey is empty and the key string is
+       the handle's */
+    SymTableKey_T oKey;
+    /* key string, stored inline */
+    char acKey[];
+};
+
+/* bucket array of one stripe */
+struct SymTableArray {
+    /* link in the garbage list once the array is replaced */
+    struct SymTableGarbage sGarbage;
+    /* number of bits needed to index apsBuckets, whose size is
+       always a power of two */
+    unsigned int uBucketBits;
+    /* array of bucket pointers */
+    struct SymTableNode *apsBuckets[];
+};
+
+/* lock and buckets of one stripe */
+struct SymTableStripe {
+    /* held by every thread changing the stripe */
+    pthread_mutex_t sLock;
+    /* bucket array, replaced by a larger one as the stripe grows */
+    struct SymTableArray *psArray;
+    /* number of bindings in the stripe */
+    size_t uNumBindings;
+    /* keeps the next stripe's lock off this stripe's cache line */
+    char acPadding[CACHE_LINE_SIZE];
+};
+
+/* one SymTable_mapParallel call, shared by all of its threads */
+struct SymTableMapping {
+    /* table being mapped */
+    SymTable_T oSymTable;
+    /* function applied to each binding, and its extra argument */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+/* symbol table structure */
+struct SymTable {
+    /* hash function applied to key strings */
+    size_t (*pfHash)(const char *pcKey);
+    /* random seed mixed into every hash code before it is reduced
+       to a bucket index, varying the layout from table to table */
+    size_t uSeed;
+    /* the stripes, selected by the top bits of a key's bucket index */
+    struct SymTableStripe asStripes[NUM_STRIPES];
+};
+
+/*
+ * Returns the hash code of key string pcKey, which is uLength
+ * characters long, in oSymTable, computed with the table's hash
+ * function. The default hash function is given the length, so it
+ * does not have to find the '\0' again.
+ */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return SymTable_hashBytes(pcKey, uLength);
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the hash code of interned key oKey in oSymTable. A table
+ * using the default hash function reuses the handle's precomputed
+ * hash code; any other table has to hash the handle's string.
+ */
+static size_t SymTable_handleHash(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return oKey->uHash;
+    return (*oSymTable->pfHash)(oKey->acKey);
+}
+
+/*
+ * Returns the hash code in oSymTable of key string pcKey, given the
+ * code uHash that SymTable_hashKey returns for it. A table using the
+ * default hash function takes uHash as is; any other table has to
+ * hash the string.
+ */
+static size_t SymTable_givenHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return uHash;
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the seeded hash code uHash of oSymTable scrambled with
+ * Fibonacci hashing. Its top STRIPE_BITS bits select the key's
+ * stripe, and the bits below them its bucket within the stripe.
+ */
+static size_t SymTable_scramble(SymTable_T oSymTable, size_t uHash) {
+    return (uHash ^ oSymTable->uSeed) * FIBONACCI_MULTIPLIER;
+}
+
+/* Returns the stripe of a key whose scrambled hash is uScrambled. */
+static struct SymTableStripe *SymTable_stripe(SymTable_T oSymTable,
+    size_t uScrambled) {
+    return &oSymTable->asStripes[uScrambled
+                                 >> (sizeof(size_t) * CHAR_BIT
+                                     - STRIPE_BITS)];
+}
+
+/*
+ * Returns the index in bucket array psArray of a key whose scrambled
+ * hash is uScrambled: the uBucketBits bits below the stripe bits.
+ */
+static size_t SymTable_bucketIndex(const struct SymTableArray *psArray,
+    size_t uScrambled) {
+    return (uScrambled << STRIPE_BITS)
+           >> (sizeof(size_t) * CHAR_BIT - psArray->uBucketBits);
+}
+
+/*
+ * Returns a new bucket array of 2^uBucketBits empty buckets, or NULL
+ * if memory allocation fails or the array would be too large.
+ */
+static struct SymTableArray *SymTable_newArray(
+    unsigned int uBucketBits) {
+    struct SymTableArray *psArray;
+    size_t uNumBuckets;
+
+    if (uBucketBits >= sizeof(size_t) * CHAR_BIT - STRIPE_BITS)
+        return NULL;
+    uNumBuckets = (size_t)1 << uBucketBits;
+    if (uNumBuckets > (((size_t)-1) - sizeof(struct SymTableArray))
+                      / sizeof(struct SymTableNode *))
+        return NULL;
+
+    psArray = calloc(1, sizeof(struct SymTableArray)
+                        + uNumBuckets * sizeof(struct SymTableNode *));
+    if (psArray == NULL)
+        return NULL;
+    psArray->uBucketBits = uBucketBits;
+    return psArray;
+}
+
+/*
+ * Returns the number of bits needed to index the buckets of each
+ * stripe of a table that holds uCapacity bindings without growing,
+ * if they are spread evenly over the stripes: the smallest count,
+ * at least INITIAL_STRIPE_BUCKET_BITS, that keeps the load at or
+ * below RESIZE_FACTOR. A count too large for SymTable_newArray
+ * makes it fail.
+ */
+static unsigned int SymTable_bucketBitsFor(size_t uCapacity) {
+    unsigned int uBucketBits = INITIAL_STRIPE_BUCKET_BITS;
+    size_t uPerStripe = uCapacity / NUM_STRIPES
+                        + (uCapacity % NUM_STRIPES != 0);
+
+    while (uBucketBits < sizeof(size_t) * CHAR_BIT - STRIPE_BITS
+           && (double)uPerStripe / ((size_t)1 << uBucketBits)
+              > RESIZE_FACTOR)
+        uBucketBits++;
+    return uBucketBits;
+}
+
+/*
+ * Helper function that gives stripe psStripe of oSymTable
+ * 2^uBucketBits buckets, usually twice as many as it has now, or
+ * fewer when it is compacted. Lookups may be walking the old chains
+ * while this runs, so the nodes are copied into the new array
+ * rather than moved, and the old array and nodes are freed once no
+ * lookup can still be reading them. The caller must hold the
+ * stripe's lock, which keeps other threads from changing the stripe
+ * for the length of one stripe's rehash. Returns 1 if successful and
+ * 0 if memory allocation fails, in which case the stripe is
+ * unchanged.
+ */
+static int SymTable_resizeStripe(SymTable_T oSymTable,
+    struct SymTableStripe *psStripe, unsigned int uBucketBits) {
+    struct SymTableArray *psOldArray = psStripe->psArray;
+    struct SymTableArray *psNewArray;
+    struct SymTableNode *psNode;
+    struct SymTableNode *psCopy;
+    struct SymTableGarbage *psGarbage = NULL;
+    size_t uNumOldBuckets = (size_t)1 << psOldArray->uBucketBits;
+    size_t uNumNewBuckets;
+    size_t uKeySize;
+    size_t uIndex;
+    size_t i;
+
+    psNewArray = SymTable_newArray(uBucketBits);
+    if (psNewArray == NULL)
+        return 0;
+    uNumNewBuckets = (size_t)1 << psNewArray->uBucketBits;
+
+    /* the new array is private until it is published, so it is
+       built with plain stores. cached hash codes avoid rehashing */
+    for (i = 0; i < uNumOldBuckets; i++) {
+        for (psNode = psOldArray->apsBuckets[i]; psNode != NULL;
+             psNode = psNode->psNext) {
+            uKeySize = (psNode->oKey != NULL)
+                       ? 1 : strlen(psNode->acKey) + 1;
+            psCopy = malloc(sizeof(struct SymTableNode) + uKeySize);
+            if (psCopy == NULL)
+                break;
+            memcpy(psCopy, psNode,
+                   sizeof(struct SymTableNode) + uKeySize);
+            uIndex = SymTable_bucketIndex(
+                psNewArray,
+                SymTable_scramble(oSymTable, psNode->uHash));
+            psCopy->psNext = psNewArray->apsBuckets[uIndex];
+            psNewArray->apsBuckets[uIndex] = psCopy;
+        }
+        if (psNode != NULL)
+            break;
+    }
+
+    /* on failure, throw the partial copy away */
+    if (i < uNumOldBuckets) {
+        for (i = 0; i < uNumNewBuckets; i++) {
+            while ((psNode = psNewArray->apsBuckets[i]) != NULL) {
+                psNewArray->apsBuckets[i] = psNode->psNext;
+                free(psNode);
+            }
+        }
+        free(psNewArray);
+        return 0;
+    }
+
+    /* publish the new array, then retire the old one and its nodes.
+       their links stay intact for the lookups still reading them */
+    __atomic_store_n(&psStripe->psArray, psNewArray, __ATOMIC_RELEASE);
+    for (i = 0; i < uNumOldBuckets; i++) {
+        for (psNode = psOldArray->apsBuckets[i]; psNode != NULL;
+             psNode = psNode->psNext) {
+            psNode->sGarbage.psNext = psGarbage;
+            psGarbage = &psNode->sGarbage;
+        }
+    }
+    psOldArray->sGarbage.psNext = psGarbage;
+    SymTable_deferFree(&psOldArray->sGarbage);
+    return 1;
+}
+
+/*
+ * Helper function that walks the chain linked from *ppsLink looking
+ * for the key made of the uLength characters at pcKey, with hash
+ * code uHash; oKey is the key's handle, or NULL if the caller only
+ * has the characters. Returns the address of
+ * the link that points to the matching node, or of the chain's
+ * final NULL link if there is none. Nodes with a different cached
+ * hash are skipped without calling strcmp, and two handles are
+ * compared by address alone. The caller must hold the lock of the
+ * chain's stripe.
+ */
+static struct SymTableNode **SymTable_findLink(
+    struct SymTableNode **ppsLink, const char *pcKey, size_t uLength,
+    size_t uHash, SymTableKey_T oKey) {
+    struct SymTableNode *psCurrentNode;
+
+    for (; (psCurrentNode = *ppsLink) != NULL;
+         ppsLink = &psCurrentNode->psNext) {
+        if (psCurrentNode->uHash != uHash)
+            continue;
+        if (oKey != NULL && psCurrentNode->oKey != NULL) {
+            /* equal strings always intern to the same handle */
+            if (psCurrentNode->oKey == oKey)
+                break;
+        }
+        else if (SymTable_keyEquals(psCurrentNode->oKey != NULL
+                                    ? psCurrentNode->oKey->acKey
+                                    : psCurrentNode->acKey,
+                                    pcKey, uLength))
+            break;
+    }
+    return ppsLink;
+}
+
+/*
+ * Helper function that returns the address of the link to the node
+ * of key pcKey, or of the final NULL link of the key's chain, in
+ * stripe psStripe of oSymTable. uScrambled is the key's scrambled
+ * hash code; the other arguments are those of SymTable_findLink.
+ * The caller must hold the stripe's lock.
+ */
+static struct SymTableNode **SymTable_stripeLink(
+    struct SymTableStripe *psStripe, size_t uScrambled,
+    const char *pcKey, size_t uLength, size_t uHash,
+    SymTableKey_T oKey) {
+    struct SymTableArray *psArray = psStripe->psArray;
+
+    return SymTable_findLink(
+        &psArray->apsBuckets[SymTable_bucketIndex(psArray, uScrambled)],
+        pcKey, uLength, uHash, oKey);
+}
+
+/*
+ * Helper function that looks up the key made of the uLength
+ * characters at pcKey, whose hash code is uHash and whose handle is
+ * oKey (NULL if unknown), in oSymTable without
+ * taking a lock or writing anything but the calling thread's own
+ * reader record. Sets *ppvValue to the key's value if the key
+ * exists. Returns 1 if the key exists, and 0 otherwise.
+ */
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey, void **ppvValue) {
+    struct SymTableReader *psReader;
+    struct SymTableStripe *psStripe;
+    struct SymTableArray *psArray;
+    struct SymTableNode *psNode;
+    size_t uScrambled = SymTable_scramble(oSymTable, uHash);
+
+    psStripe = SymTable_stripe(oSymTable, uScrambled);
+    psReader = SymTable_enterEpoch();
+    psArray = __atomic_load_n(&psStripe->psArray, __ATOMIC_ACQUIRE);
+    psNode = __atomic_load_n(
+        &psArray->apsBuckets[SymTable_bucketIndex(psArray, uScrambled)],
+        __ATOMIC_ACQUIRE);
+    for (; psNode != NULL;
+         psNode = __atomic_load_n(&psNode->psNext, __ATOMIC_ACQUIRE)) {
+        if (psNode->uHash != uHash)
+            continue;
+        if (oKey != NULL && psNode->oKey != NULL) {
+            if (psNode->oKey == oKey)
+                break;
+        }
+        else if (SymTable_keyEquals(psNode->oKey != NULL
+                                    ? psNode->oKey->acKey
+                                    : psNode->acKey,
+                                    pcKey, uLength))
+            break;
+    }
+    if (psNode != NULL)
+        *ppvValue = __atomic_load_n(&psNode->pvValue, __ATOMIC_ACQUIRE);
+    SymTable_leaveEpoch(psReader);
+    return psNode != NULL;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_new(void) {
+    return SymTable_newWithHash(SymTable_hashString);
+}
+
+/*
+ * Helper function that creates and returns a empty symbol table
+ * that hashes keys with pfHash and gives each stripe 2^uBucketBits
+ * buckets, and allocate memory for the symbol table structure,
+ * buckets & locks.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+static SymTable_T SymTable_create(size_t (*pfHash)(const char *pcKey),
+    unsigned int uBucketBits) {
+    SymTable_T oSymTable;
+    int i;
+    int j;
+
+    /* memory allocation for SymTable */
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* memory allocation for each stripe's bucket array, all empty */
+    for (i = 0; i < NUM_STRIPES; i++) {
+        oSymTable->asStripes[i].psArray =
+            SymTable_newArray(uBucketBits);
+        if (oSymTable->asStripes[i].psArray == NULL) {
+            for (j = 0; j < i; j++)
+                free(oSymTable->asStripes[j].psArray);
+            free(oSymTable);
+            return NULL;
+        }
+    }
+
+    oSymTable->pfHash = pfHash;
+    oSymTable->uSeed = SymTable_newSeed();
+    for (i = 0; i < NUM_STRIPES; i++) {
+        pthread_mutex_init(&oSymTable->asStripes[i].sLock, NULL);
+        oSymTable->asStripes[i].uNumBindings = 0;
+    }
+
+    return oSymTable;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with pfHash, and allocate memory for the symbol table
+ * structure, buckets & locks.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    assert(pfHash != NULL);
+    return SymTable_create(pfHash, INITIAL_STRIPE_BUCKET_BITS);
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function and starts each stripe out
+ * with enough buckets for its share of uCapacity bindings.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    return SymTable_create(SymTable_hashString,
+                           SymTable_bucketBitsFor(uCapacity));
+}
+
+/*
+ * Makes room in oSymTable for uCapacity bindings in all, growing
+ * each stripe that has fewer buckets than its share needs, one
+ * stripe at a time under its lock. A stripe that gets more than
+ * its share of the bindings may still grow later.
+ * Returns 1 if successful, and 0 if memory allocation fails, in
+ * which case the stripes grown so far stay grown.
+ */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    struct SymTableStripe *psStripe;
+    unsigned int uBucketBits;
+    int iSuccessful = 1;
+    int i;
+
+    assert(oSymTable != NULL);
+
+    uBucketBits = SymTable_bucketBitsFor(uCapacity);
+    for (i = 0; i < NUM_STRIPES && iSuccessful; i++) {
+        psStripe = &oSymTable->asStripes[i];
+        pthread_mutex_lock(&psStripe->sLock);
+        if (psStripe->psArray->uBucketBits < uBucketBits)
+            iSuccessful = SymTable_resizeStripe(oSymTable, psStripe,
+                                                uBucketBits);
+        pthread_mutex_unlock(&psStripe->sLock);
+    }
+    return iSuccessful;
+}
+
+/*
+ * Rebuilds each stripe of oSymTable that has more buckets than its
+ * own bindings need with the fewest that keep its load at or below
+ * RESIZE_FACTOR, locking one stripe at a time. Lookups and updates
+ * may run meanwhile; the old buckets and nodes are reclaimed like
+ * those of a stripe that grew.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_compact(SymTable_T oSymTable) {
+    struct SymTableStripe *psStripe;
+    unsigned int uBucketBits;
+    int iSuccessful = 1;
+    int i;
+
+    assert(oSymTable != NULL);
+
+    for (i = 0; i < NUM_STRIPES && iSuccessful; i++) {
+        psStripe = &oSymTable->asStripes[i];
+        pthread_mutex_lock(&psStripe->sLock);
+        uBucketBits = SymTable_bucketBitsFor(psStripe->uNumBindings
+                                             * NUM_STRIPES);
+        if (psStripe->psArray->uBucketBits > uBucketBits)
+            iSuccessful = SymTable_resizeStripe(oSymTable, psStripe,
+                                                uBucketBits);
+        pthread_mutex_unlock(&psStripe->sLock);
+    }
+    return iSuccessful;
+}
+
+/*
+ * Lookups must not change a table that other threads read without
+ * locks, and a lookup compares only the few keys of one chain
+ * anyway; iPolicy is accepted and ignored.
+ */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    (void)iPolicy;
+}
+
+/*
+ * Puts and removes under different stripe locks would have to
+ * update one shared filter, and a refill would have to hold every
+ * lock; iEnable is accepted and ignored.
+ */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+    (void)iEnable;
+    return 1;
+}
+
+/*
+ * Free all memory associated with symbol table oSymTable.
+ * Thus key-value bindings as well as the symbol table itself
+ * are freed. No other thread may be using oSymTable. Blocks of
+ * oSymTable already waiting on a garbage list are freed later.
+ */
+void SymTable_free(SymTable_T oSymTable) {
+    struct SymTableArray *psArray;
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+    size_t uNumBuckets;
+    size_t i;
+    int iStripe;
+
+    assert(oSymTable != NULL);
+
+    for (iStripe = 0; iStripe < NUM_STRIPES; iStripe++) {
+        psArray = oSymTable->asStripes[iStripe].psArray;
+        uNumBuckets = (size_t)1 << psArray->uBucketBits;
+        for (i = 0; i < uNumBuckets; i++) {
+            for (psCurrentNode = psArray->apsBuckets[i];
+                 psCurrentNode != NULL; psCurrentNode = psNextNode) {
+                psNextNode = psCurrentNode->psNext;
+                free(psCurrentNode);
+            }
+        }
+        free(psArray);
+        pthread_mutex_destroy(&oSymTable->asStripes[iStripe].sLock);
+    }
+    free(oSymTable);
+}
+
+/*
+ * Returns number of bindings in oSymTable. While other threads are
+ * changing oSymTable, the count may be off by the bindings they add
+ * or remove during the call.
+ */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    struct SymTableStripe *psStripe;
+    size_t uNumBindings = 0;
+    int i;
+
+    assert(oSymTable != NULL);
+
+    for (i = 0; i < NUM_STRIPES; i++) {
+        psStripe = &oSymTable->asStripes[i];
+        pthread_mutex_lock(&psStripe->sLock);
+        uNumBindings += psStripe->uNumBindings;
+        pthread_mutex_unlock(&psStripe->sLock);
+    }
+    return uNumBindings;
+}
+
+/*
+ * Helper function that adds a binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash, and
+ * pvValue to oSymTable if the key doesn't exist in oSymTable. If
+ * oKey is not NULL, pcKey is its string and the node refers to the
+ * handle instead of copying the key. Grows the key's stripe once it
+ * is more than RESIZE_FACTOR full.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue) {
+    struct SymTableStripe *psStripe;
+    struct SymTableNode *psNewNode;
+    struct SymTableNode **ppsLink;
+    size_t uScrambled = SymTable_scramble(oSymTable, uHash);
+    size_t uKeySize;
+
+    /* make the node before locking, to keep the lock hold short. a
+       handle already is a stable copy, so it is not copied */
+    if (oKey == NULL && uLength == (size_t)-1)
+        return 0;
+    uKeySize = (oKey != NULL) ? 1 : uLength + 1;
+    psNewNode = malloc(sizeof(struct SymTableNode) + uKeySize);
+    if (psNewNode == NULL)
+        return 0;
+    if (oKey != NULL)
+        psNewNode->acKey[0] = '\0';
+    else {
+        memcpy(psNewNode->acKey, pcKey, uLength);
+        psNewNode->acKey[uLength] = '\0';
+    }
+    psNewNode->pvValue = (void *)pvValue;
+    psNewNode->uHash = uHash;
+    psNewNode->oKey = oKey;
+    psNewNode->psNext = NULL;
+
+    psStripe = SymTable_stripe(oSymTable, uScrambled);
+    pthread_mutex_lock(&psStripe->sLock);
+
+    ppsLink = SymTable_stripeLink(psStripe, uScrambled, pcKey, uLength,
+                                  uHash, oKey);
+    /* does not insert key if it already exists */
+    if (*ppsLink != NULL) {
+        pthread_mutex_unlock(&psStripe->sLock);
+        free(psNewNode);
+        return 0;
+    }
+
+    /* link new node to the chain's end. the release store makes its
+       fields visible to lookups before the node itself */
+    __atomic_store_n(ppsLink, psNewNode, __ATOMIC_RELEASE);
+    psStripe->uNumBindings++;
+
+    /* the binding is in; a failed resize only makes chains longer */
+    if ((double)psStripe->uNumBindings
+        / ((size_t)1 << psStripe->psArray->uBucketBits) > RESIZE_FACTOR)
+        (void)SymTable_resizeStripe(oSymTable, psStripe,
+                                    psStripe->psArray->uBucketBits + 1);
+
+    pthread_mutex_unlock(&psStripe->sLock);
+    return 1;
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL, pvValue);
+}
+
+/*
+ * Adds new binding of interned key oKey, pvValue to oSymTable
+ * if the key doesn't exist in oSymTable, using the handle's
+ * precomputed hash code. returns 1 if binding was added, returns 0
+ * if memory allocation fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey,
+                           pvValue);
+}
+
+/*
+ * Helper function that replaces the value of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash and whose
+ * handle is oKey (NULL if unknown), with pvValue. Returns the old
+ * value, or NULL if the key doesn't exist in oSymTable.
+ */
+static void *SymTable_replaceKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue) {
+    struct SymTableStripe *psStripe;
+    struct SymTableNode *psNode;
+    size_t uScrambled = SymTable_scramble(oSymTable, uHash);
+    void *pvOldValue = NULL;
+
+    psStripe = SymTable_stripe(oSymTable, uScrambled);
+    pthread_mutex_lock(&psStripe->sLock);
+
+    psNode = *SymTable_stripeLink(psStripe, uScrambled, pcKey, uLength,
+                                  uHash, oKey);
+    if (psNode != NULL) {
+        pvOldValue = psNode->pvValue;
+        __atomic_store_n(&psNode->pvValue, (void *)pvValue,
+                         __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&psStripe->sLock);
+    return pvOldValue;
+}
+
+/*
+ * replace old value (pvOldValue) of key pcKey in oSymTable
+ * with new value pvValue and returns pvOldValue.
+ * if the given pcKey doesn't exist within oSymTable,
+ * returns NULL
+ */
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_replaceKey(oSymTable, pcKey, uLength,
+                               SymTable_hash(oSymTable, pcKey, uLength),
+                               NULL, pvValue);
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_replaceKey(oSymTable, oKey->acKey, oKey->uLength,
+                               SymTable_handleHash(oSymTable, oKey),
+                               oKey, pvValue);
+}
+
+/*
+ * Returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. Sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. The key is hashed once and
+ * found or added under a single hold of its stripe's lock; unlike
+ * SymTable_put, the node is only made once the key is known to be
+ * missing. A resize copies the stripe's nodes, so the address is
+ * only good until the next binding is added or removed.
+ * Returns NULL if memory allocation fails.
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    struct SymTableStripe *psStripe;
+    struct SymTableNode *psNode;
+    struct SymTableNode **ppsLink;
+    size_t uHash;
+    size_t uScrambled;
+    size_t uKeySize;
+    int iCreated = 0;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uHash = SymTable_hash(oSymTable, pcKey, uLength);
+    uScrambled = SymTable_scramble(oSymTable, uHash);
+    psStripe = SymTable_stripe(oSymTable, uScrambled);
+    pthread_mutex_lock(&psStripe->sLock);
+
+    ppsLink = SymTable_stripeLink(psStripe, uScrambled, pcKey, uLength,
+                                  uHash, NULL);
+    psNode = *ppsLink;
+    if (psNode == NULL) {
+        uKeySize = uLength + 1;
+        psNode = malloc(sizeof(struct SymTableNode) + uKeySize);
+        if (psNode == NULL) {
+            pthread_mutex_unlock(&psStripe->sLock);
+            return NULL;
+        }
+        memcpy(psNode->acKey, pcKey, uKeySize);
+        psNode->pvValue = (void *)pvValue;
+        psNode->uHash = uHash;
+        psNode->oKey = NULL;
+        psNode->psNext = NULL;
+        __atomic_store_n(ppsLink, psNode, __ATOMIC_RELEASE);
+        psStripe->uNumBindings++;
+        iCreated = 1;
+
+        /* a resize replaces the node with a copy, so find it again */
+        if ((double)psStripe->uNumBindings
+            / ((size_t)1 << psStripe->psArray->uBucketBits)
+            > RESIZE_FACTOR
+            && SymTable_resizeStripe(
+                   oSymTable, psStripe,
+                   psStripe->psArray->uBucketBits + 1))
+            psNode = *SymTable_stripeLink(psStripe, uScrambled, pcKey,
+                                          uLength, uHash, NULL);
+    }
+
+    pthread_mutex_unlock(&psStripe->sLock);
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &psNode->pvValue;
+}
+
+/*
+ * Checks if given key pcKey exists within oSymTable.
+ * Returns 1 if pcKey exists, if else returns 0
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    void *pvValue;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_lookup(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL, &pvValue);
+}
+
+/*
+ * Checks if interned key oKey exists within oSymTable.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_lookup(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey,
+                           &pvValue);
+}
+
+/*
+ * Returns value associated with key pcKey if it exists
+ * within oSymTable, returns NULL if can't find given pcKey
+ * in oSymTable
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    void *pvValue = NULL;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    (void)SymTable_lookup(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          NULL, &pvValue);
+    return pvValue;
+}
+
+/*
+ * Returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
+ */
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    (void)SymTable_lookup(oSymTable, oKey->acKey, oKey->uLength,
+                          SymTable_handleHash(oSymTable, oKey), oKey,
+                          &pvValue);
+    return pvValue;
+}
+
+/*
+ * Stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. The keys are taken BATCH_SIZE at a time, each batch
+ * in one reading stretch: all of them are hashed and their buckets
+ * prefetched, then their chains are walked side by side, one node
+ * per key per round, with the next node of every chain prefetched
+ * before any is compared. Like SymTable_get, this takes no lock.
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    struct SymTableNode **appsBuckets[BATCH_SIZE];
+    struct SymTableNode *apsNodes[BATCH_SIZE];
+    size_t auHashes[BATCH_SIZE];
+    struct SymTableReader *psReader;
+    struct SymTableArray *psArray;
+    struct SymTableNode *psNode;
+    size_t uScrambled;
+    size_t uFirst;
+    size_t uCount;
+    size_t i;
+    int iPending;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+
+    for (uFirst = 0; uFirst < uNumKeys; uFirst += uCount) {
+        uCount = uNumKeys - uFirst;
+        if (uCount > BATCH_SIZE)
+            uCount = BATCH_SIZE;
+
+        psReader = SymTable_enterEpoch();
+        for (i = 0; i < uCount; i++) {
+            assert(apcKeys[uFirst + i] != NULL);
+            auHashes[i] = SymTable_hash(oSymTable, apcKeys[uFirst + i],
+                                        strlen(apcKeys[uFirst + i]));
+            uScrambled = SymTable_scramble(oSymTable, auHashes[i]);
+            psArray = __atomic_load_n(
+                &SymTable_stripe(oSymTable, uScrambled)->psArray,
+                __ATOMIC_ACQUIRE);
+            appsBuckets[i] = &psArray->apsBuckets[
+                SymTable_bucketIndex(psArray, uScrambled)];
+            __builtin_prefetch(appsBuckets[i]);
+            apvValues[uFirst + i] = NULL;
+        }
+        for (i = 0; i < uCount; i++) {
+            apsNodes[i] = __atomic_load_n(appsBuckets[i],
+                                          __ATOMIC_ACQUIRE);
+            if (apsNodes[i] != NULL)
+                __builtin_prefetch(apsNodes[i]);
+        }
+
+        /* a chain drops out once its key is found or it ends */
+        do {
+            iPending = 0;
+            for (i = 0; i < uCount; i++) {
+                psNode = apsNodes[i];
+                if (psNode == NULL)
+                    continue;
+                if (psNode->uHash == auHashes[i]
+                    && strcmp(psNode->oKey != NULL
+                              ? psNode->oKey->acKey : psNode->acKey,
+                              apcKeys[uFirst + i]) == 0) {
+                    apvValues[uFirst + i] = __atomic_load_n(
+                        &psNode->pvValue, __ATOMIC_ACQUIRE);
+                    apsNodes[i] = NULL;
+                    continue;
+                }
+                apsNodes[i] = __atomic_load_n(&psNode->psNext,
+                                              __ATOMIC_ACQUIRE);
+                if (apsNodes[i] != NULL) {
+                    __builtin_prefetch(apsNodes[i]);
+                    iPending = 1;
+                }
+            }
+        } while (iPending);
+        SymTable_leaveEpoch(psReader);
+    }
+}
+
+/*
+ * Helper function that removes the binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash and whose
+ * handle is oKey (NULL if unknown), from oSymTable. Returns the
+ * value of the removed binding, or NULL if the key did not exist.
+ */
+static void *SymTable_removeKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey) {
+    struct SymTableStripe *psStripe;
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode **ppsLink;
+    size_t uScrambled = SymTable_scramble(oSymTable, uHash);
+    void *pvValue = NULL;
+
+    psStripe = SymTable_stripe(oSymTable, uScrambled);
+    pthread_mutex_lock(&psStripe->sLock);
+
+    ppsLink = SymTable_stripeLink(psStripe, uScrambled, pcKey, uLength,
+                                  uHash, oKey);
+    psCurrentNode = *ppsLink;
+    if (psCurrentNode != NULL) {
+        pvValue = psCurrentNode->pvValue;
+        /* the node keeps its own link, so lookups standing on it
+           can still walk the rest of the chain */
+        __atomic_store_n(ppsLink, psCurrentNode->psNext,
+                         __ATOMIC_RELEASE);
+        psStripe->uNumBindings--;
+    }
+
+    pthread_mutex_unlock(&psStripe->sLock);
+    if (psCurrentNode != NULL) {
+        psCurrentNode->sGarbage.psNext = NULL;
+        SymTable_deferFree(&psCurrentNode->sGarbage);
+    }
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with given pcKey from the
+ * symbol table (oSymTable) and frees memory once no lookup can
+ * still be reading it.
+ * Return the value associated with removed key if key existed
+ * in oSymTable. return NULL otherwise.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeKey(oSymTable, pcKey, uLength,
+                              SymTable_hash(oSymTable, pcKey, uLength),
+                              NULL);
+}
+
+/*
+ * Removes binding associated with interned key oKey from
+ * oSymTable and frees memory once no lookup can still be reading
+ * it. Return the value associated with the removed key if it
+ * existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_removeKey(oSymTable, oKey->acKey, oKey->uLength,
+                              SymTable_handleHash(oSymTable, oKey),
+                              oKey);
+}
+
+/*
+ * Adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. The characters are copied, with a '\0' added.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return 0;
+    return SymTable_putKey(oSymTable, pcKey, uLength, uHash, NULL,
+                           pvValue);
+}
+
+/*
+ * Checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable, reading them in place without taking a lock.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return 0;
+    return SymTable_lookup(oSymTable, pcKey, uLength, uHash, NULL,
+                           &pvValue);
+}
+
+/*
+ * Returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, reading them
+ * in place without taking a lock. Returns NULL otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    (void)SymTable_lookup(oSymTable, pcKey, uLength, uHash, NULL,
+                          &pvValue);
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with the key made of the uLength
+ * characters at pcKey from oSymTable and frees memory once no
+ * lookup can still be reading it. Return the value associated with
+ * the removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    return SymTable_removeKey(oSymTable, pcKey, uLength, uHash, NULL);
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to oSymTable if the key pcKey
+ * doesn't exist in oSymTable, using uHash, the code SymTable_hashKey
+ * returns for pcKey, instead of hashing it again.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_givenHash(oSymTable, pcKey, uHash),
+                           NULL, pvValue);
+}
+
+/*
+ * Returns value associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    void *pvValue = NULL;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    (void)SymTable_lookup(oSymTable, pcKey, uLength,
+                          SymTable_givenHash(oSymTable, pcKey, uHash),
+                          NULL, &pvValue);
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, from oSymTable and frees memory once no other
+ * thread can still be reading it. Return the value associated with
+ * the removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeKey(oSymTable, pcKey, uLength,
+                              SymTable_givenHash(oSymTable, pcKey,
+                                                 uHash),
+                              NULL);
+}
+
+/*
+ * To each binding in oSymTable, apply function (pfApply) given by
+ * the user. user is able to input additional parameter pvExtra
+ * if needed for the user defined function. Every stripe is locked
+ * while pfApply runs, so pfApply may look keys up in oSymTable but
+ * must not change it.
+ */
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    struct SymTableArray *psArray;
+    struct SymTableNode *psCurrentNode;
+    size_t uNumBuckets;
+    size_t i;
+    int iStripe;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (iStripe = 0; iStripe < NUM_STRIPES; iStripe++)
+        pthread_mutex_lock(&oSymTable->asStripes[iStripe].sLock);
+
+    for (iStripe = 0; iStripe < NUM_STRIPES; iStripe++) {
+        psArray = oSymTable->asStripes[iStripe].psArray;
+        uNumBuckets = (size_t)1 << psArray->uBucketBits;
+        for (i = 0; i < uNumBuckets; i++) {
+            for (psCurrentNode = psArray->apsBuckets[i];
+                 psCurrentNode != NULL;
+                 psCurrentNode = psCurrentNode->psNext)
+                (*pfApply)(psCurrentNode->oKey != NULL
+                           ? psCurrentNode->oKey->acKey
+                           : psCurrentNode->acKey,
+                           psCurrentNode->pvValue, (void *)pvExtra);
+        }
+    }
+
+    for (iStripe = 0; iStripe < NUM_STRIPES; iStripe++)
+        pthread_mutex_unlock(&oSymTable->asStripes[iStripe].sLock);
+}
+
+/*
+ * Applies the function of mapping pvMapping to the bindings of the
+ * stripes uFirst to uLimit - 1 of its table, whose locks the caller
+ * holds.
+ */
+static void SymTable_mapStripes(size_t uFirst, size_t uLimit,
+    void *pvMapping) {
+    struct SymTableMapping *psMapping = pvMapping;
+    struct SymTableArray *psArray;
+    struct SymTableNode *psCurrentNode;
+    size_t uNumBuckets;
+    size_t uStripe;
+    size_t i;
+
+    for (uStripe = uFirst; uStripe < uLimit; uStripe++) {
+        psArray = psMapping->oSymTable->asStripes[uStripe].psArray;
+        uNumBuckets = (size_t)1 << psArray->uBucketBits;
+        for (i = 0; i < uNumBuckets; i++) {
+            for (psCurrentNode = psArray->apsBuckets[i];
+                 psCurrentNode != NULL;
+                 psCurrentNode = psCurrentNode->psNext)
+                (*psMapping->pfApply)(psCurrentNode->oKey != NULL
+                                      ? psCurrentNode->oKey->acKey
+                                      : psCurrentNode->acKey,
+                                      psCurrentNode->pvValue,
+                                      (void *)psMapping->pvExtra);
+        }
+    }
+}
+
+/*
+ * To each binding in oSymTable, apply function *pfApply with
+ * pvExtra as extra argument, in up to iThreadCount threads at once.
+ * Like SymTable_map, this holds every stripe's lock throughout, so
+ * lookups go on but updates wait. The threads take one stripe at a
+ * time, and one that is done with its own stripes steals from the
+ * others.
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    struct SymTableMapping sMapping;
+    int iStripe;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (iStripe = 0; iStripe < NUM_STRIPES; iStripe++)
+        pthread_mutex_lock(&oSymTable->asStripes[iStripe].sLock);
+
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymTable_runParallel(NUM_STRIPES, 1, iThreadCount,
+                         SymTable_mapStripes, &sMapping);
+
+    for (iStripe = 0; iStripe < NUM_STRIPES; iStripe++)
+        pthread_mutex_unlock(&oSymTable->asStripes[iStripe].sLock);
+}
+
+/*
+ * To each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function *pfApply with pvExtra as extra
+ * argument, in key order. A NULL bound leaves that end open.
+ * The bindings are walked with a cursor, stripe by stripe, so
+ * other threads may go on changing oSymTable, and those in range
+ * are sorted before pfApply sees them.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    return SymTable_mapSorted(oSymTable, pcLow, pcHigh, NULL, pfApply,
+                              pvExtra);
+}
+
+/*
+ * To each binding of oSymTable whose key starts with pcPrefix,
+ * apply function *pfApply with pvExtra as extra argument, in key
+ * order, collecting and sorting them like SymTable_mapRange.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    assert(pcPrefix != NULL);
+    return SymTable_mapSorted(oSymTable, NULL, NULL, pcPrefix, pfApply,
+                              pvExtra);
+}
+
+/*
+ * Opens cursor *psIter over the bindings of oSymTable, without
+ * taking a lock. The cursor stays inside an epoch until it is
+ * closed, so that nothing it could still reach is freed. It walks
+ * the stripes one at a time, each in the bucket array the stripe
+ * has when the cursor gets to it. A stripe that grows meanwhile
+ * leaves that array and its nodes as they were, so every binding
+ * that stays in oSymTable is found exactly once.
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->pvReader = SymTable_enterEpoch();
+    psIter->pvNode = NULL;
+    psIter->pvArray = NULL;
+    psIter->uIndex = 0;
+    psIter->uCount = 0;
+}
+
+/*
+ * Moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. Returns 0 once every
+ * binding has been returned. uCount is the number of stripes
+ * started, pvArray the bucket array of the last of them, and
+ * uIndex the next bucket of it.
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    SymTable_T oSymTable;
+    struct SymTableArray *psArray;
+    struct SymTableNode *psNode;
+
+    assert(psIter != NULL);
+
+    oSymTable = psIter->oSymTable;
+    psNode = psIter->pvNode;
+    while (psNode == NULL) {
+        psArray = psIter->pvArray;
+        if (psArray != NULL
+            && psIter->uIndex < (size_t)1 << psArray->uBucketBits) {
+            psNode = __atomic_load_n(
+                &psArray->apsBuckets[psIter->uIndex++],
+                __ATOMIC_ACQUIRE);
+            continue;
+        }
+        if (psIter->uCount == NUM_STRIPES)
+            return 0;
+        psIter->pvArray = __atomic_load_n(
+            &oSymTable->asStripes[psIter->uCount++].psArray,
+            __ATOMIC_ACQUIRE);
+        psIter->uIndex = 0;
+    }
+    psIter->pvNode = __atomic_load_n(&psNode->psNext, __ATOMIC_ACQUIRE);
+
+    if (ppcKey != NULL)
+        *ppcKey = psNode->oKey != NULL ? psNode->oKey->acKey
+                                       : psNode->acKey;
+    if (ppvValue != NULL)
+        *ppvValue = __atomic_load_n(&psNode->pvValue, __ATOMIC_ACQUIRE);
+    return 1;
+}
+
+/*
+ * Closes cursor *psIter, ending its epoch. Must run on the thread
+ * that opened the cursor.
+ */
+void SymTable_end(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+    SymTable_leaveEpoch(psIter->pvReader);
+}
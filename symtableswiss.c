@@ -0,0 +1,1215 @@
+/*
+ * symtableswiss.c
+ *
+ * Symbol table module implementation via open addressing with
+ * SIMD group probing ("Swiss table"). Every slot has one control
+ * byte holding 7 bits of its key's hash, and 16 control bytes are
+ * compared at once with SSE2, so strcmp only runs on fingerprint
+ * hits and most misses cost a single vector compare.
+ * functionalities include:
+ * - creating and deleting a symbol table
+ * - adding and removing key-value pairs
+ * - retrieving, replacing, checking existence of keys
+ * - finding or adding a key's binding in one pass
+ * - looking up many keys in one batch
+ * - applying a user-defined function to each entry
+ * - applying it with several threads at once
+ * - walking the bindings one at a time with a cursor
+ * - visiting the bindings of a key range or prefix in key order
+ * - looking up interned keys by handle
+ * - looking up keys given by their length
+ * - looking up keys hashed in advance
+ * - sizing a table in advance for a known number of bindings
+ * - compacting a table to the size of its bindings
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablekey.h"
+#include "symtablepool.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+/* number of slots probed together; one SSE2 register of bytes */
+#define GROUP_SIZE 16
+/* must be a power of two and a multiple of GROUP_SIZE */
+#define INITIAL_SLOT_COUNT 512
+
+/* control byte of a slot that has never held a binding */
+#define CTRL_EMPTY 0x80
+/* control byte of a slot whose binding was removed (tombstone) */
+#define CTRL_DELETED 0xFE
+/* number of lookups SymTable_getBatch keeps in flight at once */
+#define BATCH_SIZE 16
+/* number of slots a thread of SymTable_mapParallel takes at once */
+#define MAP_GRAIN 1024
+
+/* multiplier for Fibonacci hashing: 2^w divided by the golden ratio */
+#if SIZE_MAX > 0xFFFFFFFFu
+#define FIBONACCI_MULTIPLIER ((size_t)11400714819323198485u)
+#else
+#define FIBONACCI_MULTIPLIER ((size_t)2654435769u)
+#endif
+
+/* key value pair slot structure */
+struct SymTableSlot {
+    /* key string */
+    char *pcKey;
+    /* value for key */
+    void *pvValue;
+    /* full hash code of pcKey */
+    size_t uHash;
+    /* handle the binding was put with, or NULL if it was put with a
+       key string. if not NULL, pcKey is the handle's string and is
+       not freed with the binding */
+    SymTableKey_T oKey;
+};
+
+/* one SymTable_mapParallel call, shared by all of its threads */
+struct SymTableMapping {
+    /* table being mapped */
+    SymTable_T oSymTable;
+    /* function applied to each binding, and its extra argument */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+/* symbol table structure */
+struct SymTable {
+    /* one control byte per slot: CTRL_EMPTY, CTRL_DELETED, or the
+       7-bit fingerprint of the binding stored in the slot */
+    unsigned char *pucCtrl;
+    /* array of slots, parallel to pucCtrl */
+    struct SymTableSlot *psSlots;
+    /* number of slots, a power of two */
+    size_t uNumSlots;
+    /* number of bits needed to index a group */
+    unsigned int uGroupBits;
+    /* number of bindings */
+    size_t uNumBindings;
+    /* hash function applied to key strings */
+    size_t (*pfHash)(const char *pcKey);
+    /* random seed mixed into every hash code before it is reduced
+       to a group index and fingerprint, so tables lay out the same
+       keys differently */
+    size_t uSeed;
+    /* number of empty slots that can still be filled before the
+       load factor reaches 7/8 */
+    size_t uGrowthLeft;
+};
+
+/*
+ * Returns the hash code of key string pcKey, which is uLength
+ * characters long, in oSymTable, computed with the table's hash
+ * function. The default hash function is given the length, so it
+ * does not have to find the '\0' again.
+ */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return SymTable_hashBytes(pcKey, uLength);
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the hash code of interned key oKey in oSymTable. A table
+ * using the default hash function reuses the handle's precomputed
+ * hash code; any other table has to hash the handle's string.
+ */
+static size_t SymTable_handleHash(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return oKey->uHash;
+    return (*oSymTable->pfHash)(oKey->acKey);
+}
+
+/*
+ * Returns the hash code in oSymTable of key string pcKey, given the
+ * code uHash that SymTable_hashKey returns for it. A table using the
+ * default hash function takes uHash as is; any other table has to
+ * hash the string.
+ */
+static size_t SymTable_givenHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    if (oSymTable->pfHash == SymTable_hashString)
+        return uHash;
+    return (*oSymTable->pfHash)(pcKey);
+}
+
+/*
+ * Returns the 7-bit fingerprint stored in the control byte of a
+ * binding of oSymTable whose hash code is uHash: the top 7 bits of
+ * the seeded and scrambled hash code.
+ */
+static unsigned char SymTable_fingerprint(SymTable_T oSymTable,
+    size_t uHash) {
+    return (unsigned char)(((uHash ^ oSymTable->uSeed)
+                            * FIBONACCI_MULTIPLIER)
+                           >> (sizeof(size_t) * 8 - 7));
+}
+
+/*
+ * Returns the first group probed for hash code uHash in oSymTable:
+ * the bits of the scrambled hash code just below the fingerprint.
+ */
+static size_t SymTable_homeGroup(SymTable_T oSymTable, size_t uHash) {
+    return (((uHash ^ oSymTable->uSeed) * FIBONACCI_MULTIPLIER) << 7)
+           >> (sizeof(size_t) * 8 - oSymTable->uGroupBits);
+}
+
+/*
+ * Returns a bit mask with bit i set if byte i of the GROUP_SIZE
+ * control bytes at pucGroup equals ucByte.
+ */
+static unsigned int SymTable_matchByte(const unsigned char *pucGroup,
+    unsigned char ucByte) {
+#ifdef __SSE2__
+    __m128i mGroup = _mm_loadu_si128((const __m128i *)pucGroup);
+    __m128i mByte = _mm_set1_epi8((char)ucByte);
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(mGroup, mByte));
+#else
+    unsigned int uMask = 0;
+    int i;
+
+    for (i = 0; i < GROUP_SIZE; i++) {
+        if (pucGroup[i] == ucByte)
+            uMask |= 1u << i;
+    }
+    return uMask;
+#endif
+}
+
+/*
+ * Returns a bit mask with bit i set if slot i of the group at
+ * pucGroup is empty or deleted, i.e. its control byte has the high
+ * bit set.
+ */
+static unsigned int SymTable_matchFree(const unsigned char *pucGroup) {
+#ifdef __SSE2__
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)pucGroup));
+#else
+    unsigned int uMask = 0;
+    int i;
+
+    for (i = 0; i < GROUP_SIZE; i++) {
+        if (pucGroup[i] & 0x80)
+            uMask |= 1u << i;
+    }
+    return uMask;
+#endif
+}
+
+/* Returns the index of the lowest set bit of the nonzero uMask. */
+static unsigned int SymTable_lowestBit(unsigned int uMask) {
+    unsigned int uBit = 0;
+
+    assert(uMask != 0);
+#ifdef __GNUC__
+    uBit = (unsigned int)__builtin_ctz(uMask);
+#else
+    while ((uMask & 1u) == 0) {
+        uMask >>= 1;
+        uBit++;
+    }
+#endif
+    return uBit;
+}
+
+/*
+ * Returns 1 if psSlot holds the key made of the uLength characters
+ * at pcKey, whose handle is oKey (NULL if the caller only has the
+ * characters), and 0 otherwise. Two handles are compared by
+ * address, since equal strings intern to the same handle.
+ */
+static int SymTable_isKey(const struct SymTableSlot *psSlot,
+    const char *pcKey, size_t uLength, SymTableKey_T oKey) {
+    if (oKey != NULL && psSlot->oKey != NULL)
+        return psSlot->oKey == oKey;
+    return SymTable_keyEquals(psSlot->pcKey, pcKey, uLength);
+}
+
+/*
+ * Helper function that returns the index of the slot holding the
+ * key made of the uLength characters at pcKey, whose hash code is
+ * uHash and whose handle is oKey (NULL if unknown), in oSymTable,
+ * or uNumSlots if the key is absent. Groups are probed in
+ * triangular order, which visits every group, and the probe ends
+ * at the first group with an empty slot.
+ */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey) {
+    size_t uGroupMask = (oSymTable->uNumSlots / GROUP_SIZE) - 1;
+    size_t uGroup = SymTable_homeGroup(oSymTable, uHash);
+    unsigned char ucFingerprint =
+        SymTable_fingerprint(oSymTable, uHash);
+    const unsigned char *pucGroup;
+    unsigned int uMatches;
+    size_t uIndex;
+    size_t uStep;
+
+    for (uStep = 1; uStep <= uGroupMask + 1; uStep++) {
+        pucGroup = oSymTable->pucCtrl + uGroup * GROUP_SIZE;
+
+        /* only slots with a matching fingerprint are compared */
+        uMatches = SymTable_matchByte(pucGroup, ucFingerprint);
+        while (uMatches != 0) {
+            uIndex = uGroup * GROUP_SIZE
+                     + SymTable_lowestBit(uMatches);
+            if (oSymTable->psSlots[uIndex].uHash == uHash
+                && SymTable_isKey(&oSymTable->psSlots[uIndex], pcKey,
+                                  uLength, oKey))
+                return uIndex;
+            uMatches &= uMatches - 1;
+        }
+
+        /* an empty slot means the key was never pushed further */
+        if (SymTable_matchByte(pucGroup, CTRL_EMPTY) != 0)
+            return oSymTable->uNumSlots;
+
+        uGroup = (uGroup + uStep) & uGroupMask;
+    }
+    return oSymTable->uNumSlots;
+}
+
+/*
+ * Helper function that returns the index of the first empty or
+ * deleted slot on the probe sequence of hash code uHash in
+ * oSymTable, which must have such a slot.
+ */
+static size_t SymTable_findFree(SymTable_T oSymTable, size_t uHash) {
+    size_t uGroupMask = (oSymTable->uNumSlots / GROUP_SIZE) - 1;
+    size_t uGroup = SymTable_homeGroup(oSymTable, uHash);
+    unsigned int uFree;
+    size_t uStep;
+
+    for (uStep = 1; ; uStep++) {
+        uFree = SymTable_matchFree(oSymTable->pucCtrl
+                                   + uGroup * GROUP_SIZE);
+        if (uFree != 0)
+            return uGroup * GROUP_SIZE + SymTable_lowestBit(uFree);
+        uGroup = (uGroup + uStep) & uGroupMask;
+    }
+}
+
+/*
+ * Helper function that allocates empty control bytes and slots for
+ * uNumSlots slots in oSymTable. Returns 1 if successful and 0 if
+ * memory allocation fails, in which case oSymTable is unchanged.
+ */
+static int SymTable_allocSlots(SymTable_T oSymTable, size_t uNumSlots) {
+    unsigned char *pucCtrl;
+    struct SymTableSlot *psSlots;
+    size_t uGroups;
+
+    pucCtrl = malloc(uNumSlots);
+    if (pucCtrl == NULL) return 0;
+    psSlots = calloc(uNumSlots, sizeof(struct SymTableSlot));
+    if (psSlots == NULL) {
+        free(pucCtrl);
+        return 0;
+    }
+    memset(pucCtrl, CTRL_EMPTY, uNumSlots);
+
+    oSymTable->pucCtrl = pucCtrl;
+    oSymTable->psSlots = psSlots;
+    oSymTable->uNumSlots = uNumSlots;
+    oSymTable->uGroupBits = 0;
+    for (uGroups = 1; uGroups < uNumSlots / GROUP_SIZE; uGroups *= 2)
+        oSymTable->uGroupBits++;
+    oSymTable->uGrowthLeft = uNumSlots - uNumSlots / 8;
+    return 1;
+}
+
+/*
+ * Returns the number of slots that holds uCapacity bindings without
+ * growing: the smallest power of two, at least INITIAL_SLOT_COUNT,
+ * whose slots less one in eight are enough. Returns 0 if that
+ * number of slots is too large to allocate.
+ */
+static size_t SymTable_slotCountFor(size_t uCapacity) {
+    size_t uNumSlots = INITIAL_SLOT_COUNT;
+
+    while (uCapacity > uNumSlots - uNumSlots / 8) {
+        /* no larger power of two is representable */
+        if (uNumSlots > ((size_t)-1) / 2 / sizeof(struct SymTableSlot))
+            return 0;
+        uNumSlots *= 2;
+    }
+    return uNumSlots;
+}
+
+/*
+ * Helper function that rebuilds oSymTable with uNumSlots slots,
+ * reinserting every binding and dropping all tombstones.
+ * Returns 1 if successful, and 0 otherwise.
+ */
+static int SymTable_rehash(SymTable_T oSymTable, size_t uNumSlots) {
+    unsigned char *pucOldCtrl = oSymTable->pucCtrl;
+    struct SymTableSlot *psOldSlots = oSymTable->psSlots;
+    size_t uOldNumSlots = oSymTable->uNumSlots;
+    size_t uIndex;
+    size_t i;
+
+    if (!SymTable_allocSlots(oSymTable, uNumSlots)) return 0;
+
+    /* cached hash codes avoid touching the key bytes */
+    for (i = 0; i < uOldNumSlots; i++) {
+        if ((pucOldCtrl[i] & 0x80) == 0) {
+            uIndex = SymTable_findFree(oSymTable, psOldSlots[i].uHash);
+            oSymTable->pucCtrl[uIndex] = pucOldCtrl[i];
+            oSymTable->psSlots[uIndex] = psOldSlots[i];
+        }
+    }
+    oSymTable->uGrowthLeft -= oSymTable->uNumBindings;
+
+    free(pucOldCtrl);
+    free(psOldSlots);
+    return 1;
+}
+
+/*
+ * Helper function that creates and returns a empty symbol table
+ * that hashes keys with pfHash and has uNumSlots slots, a power of
+ * two, and allocate memory for the symbol table structure & slots.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+static SymTable_T SymTable_create(size_t (*pfHash)(const char *pcKey),
+    size_t uNumSlots) {
+    SymTable_T oSymTable;
+
+    /* memory allocation for SymTable */
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    if (!SymTable_allocSlots(oSymTable, uNumSlots)) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->uNumBindings = 0;
+    oSymTable->pfHash = pfHash;
+    oSymTable->uSeed = SymTable_newSeed();
+
+    return oSymTable;
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_new(void) {
+    return SymTable_newWithHash(SymTable_hashString);
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with pfHash, and allocate memory for the symbol table
+ * structure & slots.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey)) {
+    assert(pfHash != NULL);
+    return SymTable_create(pfHash, INITIAL_SLOT_COUNT);
+}
+
+/*
+ * Creates and returns a empty SymTable_T symbol table that hashes
+ * keys with the default hash function and starts out with enough
+ * slots for uCapacity bindings, so that it never grows while they
+ * are put.
+ * Returns NULL if memory allocation is unsuccessful.
+ */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    size_t uNumSlots = SymTable_slotCountFor(uCapacity);
+
+    if (uNumSlots == 0)
+        return NULL;
+    return SymTable_create(SymTable_hashString, uNumSlots);
+}
+
+/*
+ * Makes room in oSymTable for uCapacity bindings in all, so that it
+ * does not grow or purge tombstones again until it holds more.
+ * Rebuilds the table at once if it has to grow, or if tombstones
+ * take up the empty slots the new bindings need.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    size_t uNumSlots;
+
+    assert(oSymTable != NULL);
+
+    if (uCapacity <= oSymTable->uNumBindings
+        || uCapacity - oSymTable->uNumBindings
+           <= oSymTable->uGrowthLeft)
+        return 1;
+    uNumSlots = SymTable_slotCountFor(uCapacity);
+    if (uNumSlots == 0)
+        return 0;
+    if (uNumSlots < oSymTable->uNumSlots)
+        uNumSlots = oSymTable->uNumSlots;
+    return SymTable_rehash(oSymTable, uNumSlots);
+}
+
+/*
+ * Rebuilds oSymTable with the fewest slots that hold its bindings,
+ * dropping all tombstones, unless it already has that many slots
+ * and no tombstones.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_compact(SymTable_T oSymTable) {
+    size_t uNumSlots;
+
+    assert(oSymTable != NULL);
+
+    uNumSlots = SymTable_slotCountFor(oSymTable->uNumBindings);
+    if (uNumSlots == oSymTable->uNumSlots
+        && oSymTable->uNumBindings + oSymTable->uGrowthLeft
+           == uNumSlots - uNumSlots / 8)
+        return 1;
+    return SymTable_rehash(oSymTable, uNumSlots);
+}
+
+/*
+ * The hashes of the keys fix where each lookup probes, so the slots
+ * cannot be reordered for it; iPolicy is accepted and ignored.
+ */
+void SymTable_setPolicy(SymTable_T oSymTable, int iPolicy) {
+    assert(oSymTable != NULL);
+    (void)iPolicy;
+}
+
+/*
+ * The control bytes already act as a filter: a miss compares keys
+ * only in the slots whose tag matches, which are few; iEnable is
+ * accepted and ignored.
+ */
+int SymTable_setFilter(SymTable_T oSymTable, int iEnable) {
+    assert(oSymTable != NULL);
+    (void)iEnable;
+    return 1;
+}
+
+/*
+ * Free all memory associated with symbol table oSymTable.
+ * Thus key-value bindings as well as the symbol table itself
+ * are freed.
+ */
+void SymTable_free(SymTable_T oSymTable) {
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /* free the defensive copy of every key; interned keys belong
+       to the intern pool */
+    for (i = 0; i < oSymTable->uNumSlots; i++) {
+        if ((oSymTable->pucCtrl[i] & 0x80) == 0
+            && oSymTable->psSlots[i].oKey == NULL)
+            free(oSymTable->psSlots[i].pcKey);
+    }
+
+    free(oSymTable->pucCtrl);
+    free(oSymTable->psSlots);
+    free(oSymTable);
+}
+
+/* Returns number of bindings in oSymTable. */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->uNumBindings;
+}
+
+/*
+ * Helper function that returns the index of the slot of oSymTable
+ * holding the key made of the uLength characters at pcKey, whose
+ * hash code is uHash, adding a binding of the key and pvValue first
+ * if the key doesn't exist in oSymTable.
+ * If oKey is not NULL, pcKey is its string and a new slot refers to
+ * the handle instead of copying the key. Sets *piCreated to 1 if
+ * the binding was added and 0 otherwise. Returns uNumSlots if
+ * memory allocation fails.
+ */
+static size_t SymTable_findOrAddKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue, int *piCreated) {
+    size_t uIndex;
+    size_t uNewNumSlots;
+    char *pcKeyCopy;
+
+    *piCreated = 0;
+
+    /* does not insert key if it already exists */
+    uIndex = SymTable_find(oSymTable, pcKey, uLength, uHash, oKey);
+    if (uIndex != oSymTable->uNumSlots)
+        return uIndex;
+
+    /* out of empty slots: grow if the table is more than half
+       full of live bindings, otherwise just purge tombstones */
+    if (oSymTable->uGrowthLeft == 0) {
+        uNewNumSlots = oSymTable->uNumSlots;
+        if (oSymTable->uNumBindings >= uNewNumSlots / 2) {
+            if (uNewNumSlots > ((size_t)-1) / 2
+                               / sizeof(struct SymTableSlot))
+                return oSymTable->uNumSlots;
+            uNewNumSlots *= 2;
+        }
+        if (!SymTable_rehash(oSymTable, uNewNumSlots))
+            return oSymTable->uNumSlots;
+    }
+
+    /* defensive copy, unless the handle already is one */
+    if (oKey != NULL)
+        pcKeyCopy = (char *)oKey->acKey;
+    else {
+        if (uLength == (size_t)-1)
+            return oSymTable->uNumSlots;
+        pcKeyCopy = malloc(uLength + 1);
+        if (pcKeyCopy == NULL)
+            return oSymTable->uNumSlots;
+        memcpy(pcKeyCopy, pcKey, uLength);
+        pcKeyCopy[uLength] = '\0';
+    }
+
+    uIndex = SymTable_findFree(oSymTable, uHash);
+    /* reusing a tombstone does not consume an empty slot */
+    if (oSymTable->pucCtrl[uIndex] == CTRL_EMPTY)
+        oSymTable->uGrowthLeft--;
+    oSymTable->pucCtrl[uIndex] = SymTable_fingerprint(oSymTable, uHash);
+    oSymTable->psSlots[uIndex].pcKey = pcKeyCopy;
+    oSymTable->psSlots[uIndex].pvValue = (void *)pvValue;
+    oSymTable->psSlots[uIndex].uHash = uHash;
+    oSymTable->psSlots[uIndex].oKey = oKey;
+    oSymTable->uNumBindings++;
+    *piCreated = 1;
+    return uIndex;
+}
+
+/*
+ * Helper function that adds a binding of the key made of the
+ * uLength characters at pcKey, whose hash code is uHash, and
+ * pvValue to oSymTable if the key doesn't exist in oSymTable. If
+ * oKey is not NULL, pcKey is its string and the slot refers to the
+ * handle instead of copying the key.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, SymTableKey_T oKey,
+    const void *pvValue) {
+    int iCreated;
+
+    SymTable_findOrAddKey(oSymTable, pcKey, uLength, uHash, oKey,
+                          pvValue, &iCreated);
+    return iCreated;
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to symbol table (oSymTable)
+ * if the key pcKey doesn't exist in oSymTable.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL, pvValue);
+}
+
+/*
+ * Adds new binding of interned key oKey, pvValue to oSymTable
+ * if the key doesn't exist in oSymTable, using the handle's
+ * precomputed hash code. returns 1 if binding was added, returns 0
+ * if memory allocation fails or key already exists in oSymTable
+ */
+int SymTable_putInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_putKey(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey,
+                           pvValue);
+}
+
+/*
+ * Helper function that replaces the value in slot uIndex of
+ * oSymTable with pvValue and returns the old value. Returns NULL if
+ * uIndex is uNumSlots, i.e. the key was not found.
+ */
+static void *SymTable_replaceSlot(SymTable_T oSymTable, size_t uIndex,
+    const void *pvValue) {
+    void *pvOldValue;
+
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+
+    pvOldValue = oSymTable->psSlots[uIndex].pvValue;
+    oSymTable->psSlots[uIndex].pvValue = (void *)pvValue;
+    return pvOldValue;
+}
+
+/*
+ * replace old value (pvOldValue) of key pcKey in oSymTable
+ * with new value pvValue and returns pvOldValue.
+ * if the given pcKey doesn't exist within oSymTable,
+ * returns NULL
+ */
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_replaceSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength,
+                      SymTable_hash(oSymTable, pcKey, uLength), NULL),
+        pvValue);
+}
+
+/*
+ * replace old value of interned key oKey in oSymTable with new
+ * value pvValue and returns the old value. if the key doesn't
+ * exist within oSymTable, returns NULL
+ */
+void *SymTable_replaceInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_replaceSlot(oSymTable,
+        SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                      SymTable_handleHash(oSymTable, oKey), oKey),
+        pvValue);
+}
+
+/*
+ * Returns the address of the value of key pcKey in oSymTable,
+ * adding a binding of pcKey and pvValue first if pcKey doesn't
+ * exist. Sets *piCreated, unless piCreated is NULL, to 1 if the
+ * binding was added and 0 otherwise. The key is hashed only once.
+ * Slots move when the table is rehashed, so the address is only
+ * good until the next binding is added or removed.
+ * Returns NULL if memory allocation fails.
+ */
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piCreated) {
+    size_t uIndex;
+    size_t uLength;
+    int iCreated;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uIndex = SymTable_findOrAddKey(oSymTable, pcKey, uLength,
+                                   SymTable_hash(oSymTable, pcKey,
+                                                 uLength),
+                                   NULL, pvValue, &iCreated);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    if (piCreated != NULL)
+        *piCreated = iCreated;
+    return &oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Checks if given key pcKey exists within oSymTable.
+ * Returns 1 if pcKey exists, if else returns 0
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_find(oSymTable, pcKey, uLength,
+                         SymTable_hash(oSymTable, pcKey, uLength), NULL)
+           != oSymTable->uNumSlots;
+}
+
+/*
+ * Checks if interned key oKey exists within oSymTable.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                         SymTable_handleHash(oSymTable, oKey), oKey)
+           != oSymTable->uNumSlots;
+}
+
+/*
+ * Returns value associated with key pcKey if it exists
+ * within oSymTable, returns NULL if can't find given pcKey
+ * in oSymTable
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    size_t uIndex;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uIndex = SymTable_find(oSymTable, pcKey, uLength,
+                           SymTable_hash(oSymTable, pcKey, uLength),
+                           NULL);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Returns value associated with interned key oKey if it exists
+ * within oSymTable, returns NULL otherwise
+ */
+void *SymTable_getInterned(SymTable_T oSymTable, SymTableKey_T oKey) {
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    uIndex = SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                           SymTable_handleHash(oSymTable, oKey), oKey);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Stores the value of each of the uNumKeys keys in apcKeys within
+ * oSymTable at the same position of apvValues, or NULL if the key
+ * doesn't exist. The keys are taken BATCH_SIZE at a time: all of
+ * them are hashed and the control bytes of their home groups
+ * prefetched, then the slot of each key's first fingerprint match
+ * is prefetched, then that slot's key string, and only then is each
+ * key probed for. The misses on each of the three are waited for a
+ * batch at a time instead of one after another.
+ */
+void SymTable_getBatch(SymTable_T oSymTable,
+    const char *const apcKeys[], size_t uNumKeys, void *apvValues[]) {
+    size_t auHashes[BATCH_SIZE];
+    size_t auLengths[BATCH_SIZE];
+    size_t auCandidates[BATCH_SIZE];
+    size_t uFirst;
+    size_t uCount;
+    size_t uGroup;
+    size_t uIndex;
+    unsigned int uMatches;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL || uNumKeys == 0);
+    assert(apvValues != NULL || uNumKeys == 0);
+
+    for (uFirst = 0; uFirst < uNumKeys; uFirst += uCount) {
+        uCount = uNumKeys - uFirst;
+        if (uCount > BATCH_SIZE)
+            uCount = BATCH_SIZE;
+
+        for (i = 0; i < uCount; i++) {
+            assert(apcKeys[uFirst + i] != NULL);
+            auLengths[i] = strlen(apcKeys[uFirst + i]);
+            auHashes[i] = SymTable_hash(oSymTable, apcKeys[uFirst + i],
+                                        auLengths[i]);
+            __builtin_prefetch(oSymTable->pucCtrl
+                               + SymTable_homeGroup(oSymTable,
+                                                    auHashes[i])
+                                 * GROUP_SIZE);
+        }
+        /* uNumSlots marks a key with no match in its home group */
+        for (i = 0; i < uCount; i++) {
+            uGroup = SymTable_homeGroup(oSymTable, auHashes[i]);
+            uMatches = SymTable_matchByte(
+                oSymTable->pucCtrl + uGroup * GROUP_SIZE,
+                SymTable_fingerprint(oSymTable, auHashes[i]));
+            auCandidates[i] = oSymTable->uNumSlots;
+            if (uMatches != 0) {
+                auCandidates[i] = uGroup * GROUP_SIZE
+                                  + SymTable_lowestBit(uMatches);
+                __builtin_prefetch(
+                    &oSymTable->psSlots[auCandidates[i]]);
+            }
+        }
+        for (i = 0; i < uCount; i++) {
+            if (auCandidates[i] != oSymTable->uNumSlots)
+                __builtin_prefetch(
+                    oSymTable->psSlots[auCandidates[i]].pcKey);
+        }
+        for (i = 0; i < uCount; i++) {
+            uIndex = SymTable_find(oSymTable, apcKeys[uFirst + i],
+                                   auLengths[i], auHashes[i], NULL);
+            apvValues[uFirst + i] =
+                (uIndex == oSymTable->uNumSlots)
+                ? NULL : oSymTable->psSlots[uIndex].pvValue;
+        }
+    }
+}
+
+/*
+ * Helper function that removes the binding in slot uIndex of
+ * oSymTable and returns its value. Returns NULL if uIndex is
+ * uNumSlots, i.e. the key was not found.
+ */
+static void *SymTable_removeSlot(SymTable_T oSymTable, size_t uIndex) {
+    const unsigned char *pucGroup;
+    void *pvValue;
+
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+
+    /* store value so that it can be returned after removal */
+    pvValue = oSymTable->psSlots[uIndex].pvValue;
+    if (oSymTable->psSlots[uIndex].oKey == NULL)
+        free(oSymTable->psSlots[uIndex].pcKey);
+    oSymTable->psSlots[uIndex].pcKey = NULL;
+    oSymTable->psSlots[uIndex].oKey = NULL;
+
+    /* a group that still has an empty slot was never full, so no
+       probe continued past it and the slot can become empty again;
+       otherwise a tombstone keeps later probes going */
+    pucGroup = oSymTable->pucCtrl + uIndex / GROUP_SIZE * GROUP_SIZE;
+    if (SymTable_matchByte(pucGroup, CTRL_EMPTY) != 0) {
+        oSymTable->pucCtrl[uIndex] = CTRL_EMPTY;
+        oSymTable->uGrowthLeft++;
+    }
+    else
+        oSymTable->pucCtrl[uIndex] = CTRL_DELETED;
+
+    oSymTable->uNumBindings--;
+    return pvValue;
+}
+
+/*
+ * Removes binding associated with given pcKey from the
+ * symbol table (oSymTable) and frees memory.
+ * Return the value associated with removed key if key existed
+ * in oSymTable. return NULL otherwise.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength,
+                      SymTable_hash(oSymTable, pcKey, uLength), NULL));
+}
+
+/*
+ * Removes binding associated with interned key oKey from
+ * oSymTable and frees memory. Return the value associated with
+ * the removed key if it existed in oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeInterned(SymTable_T oSymTable,
+    SymTableKey_T oKey) {
+    assert(oSymTable != NULL);
+    assert(oKey != NULL);
+
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, oKey->acKey, oKey->uLength,
+                      SymTable_handleHash(oSymTable, oKey), oKey));
+}
+
+/*
+ * Adds new binding of the key made of the uLength characters at
+ * pcKey, and pvValue, to oSymTable if the key doesn't exist in
+ * oSymTable. The characters are copied, with a '\0' added.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (uLength == (size_t)-1
+        || !SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength,
+                               &uHash))
+        return 0;
+    return SymTable_putKey(oSymTable, pcKey, uLength, uHash, NULL,
+                           pvValue);
+}
+
+/*
+ * Checks if the key made of the uLength characters at pcKey exists
+ * within oSymTable, reading them in place.
+ * Returns 1 if it exists, if else returns 0
+ */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return 0;
+    return SymTable_find(oSymTable, pcKey, uLength, uHash, NULL)
+           != oSymTable->uNumSlots;
+}
+
+/*
+ * Returns value associated with the key made of the uLength
+ * characters at pcKey if it exists within oSymTable, reading them
+ * in place. Returns NULL otherwise
+ */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    uIndex = SymTable_find(oSymTable, pcKey, uLength, uHash, NULL);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Removes binding associated with the key made of the uLength
+ * characters at pcKey from oSymTable and frees memory. Return the
+ * value associated with the removed key if it existed in
+ * oSymTable. return NULL otherwise.
+ */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength) {
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_hashSlice(oSymTable->pfHash, pcKey, uLength, &uHash))
+        return NULL;
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength, uHash, NULL));
+}
+
+/*
+ * Adds new binding of pcKey, pvValue to oSymTable if the key pcKey
+ * doesn't exist in oSymTable, using uHash, the code SymTable_hashKey
+ * returns for pcKey, instead of hashing it again.
+ * returns 1 if binding was added, returns 0 if memory allocation
+ * fails or key already exists in oSymTable
+ */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, const void *pvValue) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+                           SymTable_givenHash(oSymTable, pcKey, uHash),
+                           NULL, pvValue);
+}
+
+/*
+ * Returns value associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, if it exists within oSymTable, returns NULL
+ * otherwise
+ */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash) {
+    size_t uIndex;
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    uIndex = SymTable_find(oSymTable, pcKey, uLength,
+                           SymTable_givenHash(oSymTable, pcKey, uHash),
+                           NULL);
+    if (uIndex == oSymTable->uNumSlots)
+        return NULL;
+    return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*
+ * Removes binding associated with key pcKey, whose SymTable_hashKey
+ * code is uHash, from oSymTable and frees memory. Return the value
+ * associated with the removed key if it existed in oSymTable.
+ * return NULL otherwise.
+ */
+void *SymTable_removeHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash) {
+    size_t uLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    return SymTable_removeSlot(oSymTable,
+        SymTable_find(oSymTable, pcKey, uLength,
+                      SymTable_givenHash(oSymTable, pcKey, uHash),
+                      NULL));
+}
+
+/*
+ * To each binding in oSymTable, apply function (pfApply) given by
+ * the user. user is able to input additional parameter pvExtra
+ * if needed for the user defined function.
+ */
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTable->uNumSlots; i++) {
+        if ((oSymTable->pucCtrl[i] & 0x80) == 0)
+            (*pfApply)(oSymTable->psSlots[i].pcKey,
+                       oSymTable->psSlots[i].pvValue, (void *)pvExtra);
+    }
+}
+
+/*
+ * Applies the function of mapping pvMapping to the bindings in the
+ * slots uFirst to uLimit - 1 of its table.
+ */
+static void SymTable_mapSlots(size_t uFirst, size_t uLimit,
+    void *pvMapping) {
+    struct SymTableMapping *psMapping = pvMapping;
+    SymTable_T oSymTable = psMapping->oSymTable;
+    size_t i;
+
+    for (i = uFirst; i < uLimit; i++) {
+        if ((oSymTable->pucCtrl[i] & 0x80) == 0)
+            (*psMapping->pfApply)(oSymTable->psSlots[i].pcKey,
+                                  oSymTable->psSlots[i].pvValue,
+                                  (void *)psMapping->pvExtra);
+    }
+}
+
+/*
+ * To each binding in oSymTable, apply function *pfApply with
+ * pvExtra as extra argument, in up to iThreadCount threads at once.
+ * The slots are split into runs, and a thread that is done with its
+ * own runs steals from the others, since some runs hold more
+ * bindings than others.
+ */
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount) {
+    struct SymTableMapping sMapping;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymTable_runParallel(oSymTable->uNumSlots, MAP_GRAIN, iThreadCount,
+                         SymTable_mapSlots, &sMapping);
+}
+
+/*
+ * To each binding of oSymTable whose key is at least pcLow and less
+ * than pcHigh, apply function *pfApply with pvExtra as extra
+ * argument, in key order. A NULL bound leaves that end open.
+ * Groups are filled in the order of the keys' hash codes, so
+ * every binding is looked at and those in range are sorted before
+ * pfApply sees them.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    return SymTable_mapSorted(oSymTable, pcLow, pcHigh, NULL, pfApply,
+                              pvExtra);
+}
+
+/*
+ * To each binding of oSymTable whose key starts with pcPrefix,
+ * apply function *pfApply with pvExtra as extra argument, in key
+ * order, collecting and sorting them like SymTable_mapRange.
+ * Returns 1 if successful, and 0 if memory allocation fails.
+ */
+int SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra) {
+    assert(pcPrefix != NULL);
+    return SymTable_mapSorted(oSymTable, NULL, NULL, pcPrefix, pfApply,
+                              pvExtra);
+}
+
+/*
+ * Opens cursor *psIter over the bindings of oSymTable. Removing a
+ * binding only changes its control byte, so no binding moves while
+ * the cursor walks the slots in order.
+ */
+void SymTable_begin(SymTable_T oSymTable, struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->uIndex = 0;
+}
+
+/*
+ * Moves cursor *psIter to the next binding and returns 1, setting
+ * *ppcKey and *ppvValue unless they are NULL. Returns 0 once every
+ * binding has been returned. uIndex is the next slot to look at.
+ */
+int SymTable_next(struct SymTableIter *psIter, const char **ppcKey,
+    void **ppvValue) {
+    SymTable_T oSymTable;
+    size_t i;
+
+    assert(psIter != NULL);
+
+    oSymTable = psIter->oSymTable;
+    for (i = psIter->uIndex; i < oSymTable->uNumSlots; i++) {
+        if ((oSymTable->pucCtrl[i] & 0x80) == 0)
+            break;
+    }
+    if (i == oSymTable->uNumSlots) {
+        psIter->uIndex = i;
+        return 0;
+    }
+    psIter->uIndex = i + 1;
+
+    if (ppcKey != NULL)
+        *ppcKey = oSymTable->psSlots[i].pcKey;
+    if (ppvValue != NULL)
+        *ppvValue = oSymTable->psSlots[i].pvValue;
+    return 1;
+}
+
+/* Closes cursor *psIter, which holds nothing to release. */
+void SymTable_end(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+    psIter->uIndex = psIter->oSymTable->uNumSlots;
+}
@@ -3,6 +3,9 @@
 /* Author: Bob Dondero                                                */
 /*--------------------------------------------------------------------*/
 
+/* for clock_gettime */
+#define _POSIX_C_SOURCE 200112L
+
 #include "symtable.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -51,6 +54,49 @@ static void setCpuTimeLimit(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Return the current wall-clock time in seconds. CPU time would add
+   up the time of all threads, hiding any speedup. */
+
+static double wallClock(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings a benchmark that looks up every key
+   of a table, on top of testLargeTable, should use: iBindingCount,
+   but at most MAX_BENCHMARK_COUNT. An implementation whose lookups
+   take time linear in the size of the table thus stays within the
+   CPU time limit at every binding count testLargeTable can handle. */
+
+static int benchmarkCount(int iBindingCount)
+{
+   enum {MAX_BENCHMARK_COUNT = 5000};
+
+   if (iBindingCount > MAX_BENCHMARK_COUNT)
+      return MAX_BENCHMARK_COUNT;
+   return iBindingCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if a benchmark that started at iInitialClock has consumed
+   less than MIN_BENCHMARK_CLOCKS of CPU time, too little for the
+   clock to measure well, and so should run another round. Return 0
+   otherwise. The clock may advance only every few milliseconds. */
+
+static int keepTiming(clock_t iInitialClock)
+{
+   enum {MIN_BENCHMARK_CLOCKS = CLOCKS_PER_SEC / 20};
+
+   return clock() - iInitialClock < MIN_BENCHMARK_CLOCKS;
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Write the binding whose key is pcKey and whose string value is
    pvValue using format string pvExtra. */
 
@@ -776,142 +822,2408 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
-/* Test the ability of a SymTable object to be large, that is, to
-   contain iBindingCount bindings. Write the time consumed to stdout. */
+/* Return the hash code of pcKey computed one character at a time,
+   as by the hash function from the assignment specification. */
 
-static void testLargeTable(int iBindingCount)
+static size_t hashBytewise(const char *pcKey)
 {
-   enum {MAX_KEY_LENGTH = 10};
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 0 for every key, so that all keys collide. */
+
+static size_t hashConstant(const char *pcKey)
+{
+   assert(pcKey != NULL);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable objects created with a hash function of the
+   client's choosing, including one under which all keys collide. */
+
+static void testNewWithHash(void)
+{
+   enum {KEY_COUNT = 100, MAX_KEY_LENGTH = 10};
 
    SymTable_T oSymTable;
-   SymTable_T oSymTableSmall;
+   SymTableKey_T oKey;
    char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
    char *pcValue;
    int i;
-   int iSmall;
-   int iLarge;
    int iSuccessful;
-   clock_t iInitialClock;
-   clock_t iFinalClock;
-   size_t uLength = 0;
-   size_t uLength2;
+   size_t uLength;
 
    printf("------------------------------------------------------\n");
-   printf("Testing a potentially large SymTable object.\n");
-   printf("No output except CPU time consumed should appear here:\n");
+   printf("Testing SymTable objects with client hash functions.\n");
+   printf("No output should appear here:\n");
    fflush(stdout);
 
-   /* Note the current time. */
-   iInitialClock = clock();
-
-   /* Create oSymTableSmall, and put a couple of bindings into it. */
-   oSymTableSmall = SymTable_new();
-   ASSURE(oSymTableSmall != NULL);
-   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
-   ASSURE(iSuccessful);
-   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
-   ASSURE(iSuccessful);
-
-   /* Create oSymTable, the primary SymTable object. */
-   oSymTable = SymTable_new();
+   oSymTable = SymTable_newWithHash(hashConstant);
    ASSURE(oSymTable != NULL);
 
-   /* Put iBindingCount new bindings into oSymTable.  Each binding's
-      key and value contain the same characters. */
-   for (i = 0; i < iBindingCount; i++)
+   for (i = 0; i < KEY_COUNT; i++)
    {
       sprintf(acKey, "%d", i);
-      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
-      ASSURE(pcValue != NULL);
-      strcpy(pcValue, acKey);
-      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
       ASSURE(iSuccessful);
-      uLength = SymTable_getLength(oSymTable);
-      ASSURE(uLength == (size_t)(i+1));
    }
+   iSuccessful = SymTable_put(oSymTable, "7", acShortstop);
+   ASSURE(! iSuccessful);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT);
 
-   /* Get each binding's value, and make sure that it contains
-      the same characters as its key. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
+   for (i = 0; i < KEY_COUNT; i++)
    {
-      /* Get the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iSmall++;
-      /* Get the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
+      sprintf(acKey, "%d", i);
       pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iLarge--;
+      ASSURE(pcValue == acShortstop);
    }
-   /* Get the middle binding -- if there is one. */
-   if (iSmall == iLarge)
+
+   /* Interned keys carry the default hash code, which a table with
+      another hash function must not rely on. */
+   oKey = SymTable_intern("42");
+   ASSURE(oKey != NULL);
+   ASSURE(SymTable_containsInterned(oSymTable, oKey));
+   pcValue = (char*)SymTable_removeInterned(oSymTable, oKey);
+   ASSURE(pcValue == acShortstop);
+   ASSURE(! SymTable_contains(oSymTable, "42"));
+
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_newWithHash(hashBytewise);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_putInterned(oSymTable, oKey, acShortstop);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "42");
+   ASSURE(pcValue == acShortstop);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put, get, and remove the iKeyCount keys in ppcKeys in a SymTable
+   object that uses hash function pfHash, or the built-in hash
+   function if pfHash is NULL, in as many rounds as the clock needs.
+   Return the CPU time consumed per round in seconds. */
+
+static double timeHashFunction(size_t (*pfHash)(const char *pcKey),
+   char **ppcKeys, int iKeyCount)
+{
+   SymTable_T oSymTable;
+   int i;
+   int iSuccessful;
+   int iRoundCount = 0;
+   void *pvValue;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   iInitialClock = clock();
+   do
    {
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      if (pfHash == NULL)
+         oSymTable = SymTable_new();
+      else
+         oSymTable = SymTable_newWithHash(pfHash);
+      ASSURE(oSymTable != NULL);
+      for (i = 0; i < iKeyCount; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable, ppcKeys[i],
+                                    ppcKeys[i]);
+         ASSURE(iSuccessful);
+      }
+      for (i = 0; i < iKeyCount; i++)
+      {
+         pvValue = SymTable_get(oSymTable, ppcKeys[i]);
+         ASSURE(pvValue == ppcKeys[i]);
+      }
+      for (i = 0; i < iKeyCount; i++)
+      {
+         pvValue = SymTable_remove(oSymTable, ppcKeys[i]);
+         ASSURE(pvValue == ppcKeys[i]);
+      }
+      SymTable_free(oSymTable);
+      iRoundCount++;
+   } while (iKeyCount > 0 && keepTiming(iInitialClock));
+   iFinalClock = clock();
+
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC
+      / (double)iRoundCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the built-in hash function with the one-character-at-a-
+   time hash function on short numeric keys like those of
+   testLargeTable, and on long keys like those of testLongKey.
+   benchmarkCount(iBindingCount) short keys and a sixteenth as many
+   long keys are used. Write the time consumed by each to stdout. */
+
+static void testHashFunctions(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 10, LONG_KEY_SIZE = 1000};
+
+   char **ppcKeys;
+   int iKeyCount;
+   int iLongKeyCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the speed of hash functions.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iBindingCount = benchmarkCount(iBindingCount);
+   iLongKeyCount = iBindingCount / 16;
+   iKeyCount = (iBindingCount > iLongKeyCount) ? iBindingCount
+                                               : iLongKeyCount;
+   ppcKeys = (char**)calloc((size_t)iKeyCount + 1, sizeof(char*));
+   ASSURE(ppcKeys != NULL);
+   if (ppcKeys == NULL)
+      return;
+
+   /* Short numeric keys. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      ppcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      ASSURE(ppcKeys[i] != NULL);
+      sprintf(ppcKeys[i], "%d", i);
    }
+   printf("CPU time (short keys, bytewise hash):  %f seconds\n",
+      timeHashFunction(hashBytewise, ppcKeys, iBindingCount));
+   printf("CPU time (short keys, built-in hash):  %f seconds\n",
+      timeHashFunction(NULL, ppcKeys, iBindingCount));
+   for (i = 0; i < iBindingCount; i++)
+      free(ppcKeys[i]);
 
-   /* Remove each binding. Also free each binding's value. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
+   /* Long keys that differ only in their last characters. */
+   for (i = 0; i < iLongKeyCount; i++)
    {
-      /* Remove the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iSmall++;
-      /* Remove the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iLarge--;
+      ppcKeys[i] = (char*)malloc(LONG_KEY_SIZE);
+      ASSURE(ppcKeys[i] != NULL);
+      memset(ppcKeys[i], 'a', LONG_KEY_SIZE - MAX_KEY_LENGTH);
+      sprintf(ppcKeys[i] + LONG_KEY_SIZE - MAX_KEY_LENGTH, "%d", i);
    }
-   /* Remove the middle binding -- if there is one. */
-   if (iSmall == iLarge)
+   printf("CPU time (long keys, bytewise hash):   %f seconds\n",
+      timeHashFunction(hashBytewise, ppcKeys, iLongKeyCount));
+   printf("CPU time (long keys, built-in hash):   %f seconds\n",
+      timeHashFunction(NULL, ppcKeys, iLongKeyCount));
+   for (i = 0; i < iLongKeyCount; i++)
+      free(ppcKeys[i]);
+
+   free(ppcKeys);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if an odd number of bits of iBits are set, and 0
+   otherwise. */
+
+static int bitParity(int iBits)
+{
+   int iParity = 0;
+
+   for (; iBits != 0; iBits >>= 1)
+      iParity ^= iBits & 1;
+   return iParity;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iKeyCount colliding keys into a SymTable object that uses hash
+   function pfHash, or the built-in hash function if pfHash is NULL,
+   and look each one up. Each key consists of iBlockCount
+   BLOCK_SIZE-character blocks, block j being the Thue-Morse
+   sequence over 'a' and 'b' if bit j of the key's number is 0 and
+   its complement otherwise. The two blocks have the same hash code
+   under the bytewise hash function, so all keys do. Return the CPU
+   time consumed per lookup in microseconds. */
+
+static double timeCollidingKeys(size_t (*pfHash)(const char *pcKey),
+   int iKeyCount, int iBlockCount)
+{
+   enum {BLOCK_SIZE = 256, LOOKUP_COUNT = 16384};
+
+   SymTable_T oSymTable;
+   char *pcKeys;
+   char *pcKey;
+   int i;
+   int iRound;
+   int iRoundCount;
+   int iBlock;
+   int iChar;
+   int iSuccessful;
+   void *pvValue;
+   size_t uKeySize = (size_t)iBlockCount * BLOCK_SIZE + 1;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   pcKeys = (char*)malloc(uKeySize * (size_t)iKeyCount);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return 0.0;
+   for (i = 0; i < iKeyCount; i++)
    {
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);  
+      pcKey = pcKeys + uKeySize * (size_t)i;
+      for (iBlock = 0; iBlock < iBlockCount; iBlock++)
+         for (iChar = 0; iChar < BLOCK_SIZE; iChar++)
+            pcKey[iBlock * BLOCK_SIZE + iChar] =
+               (bitParity(iChar) ^ ((i >> iBlock) & 1)) ? 'b' : 'a';
+      pcKey[uKeySize - 1] = '\0';
    }
 
-   /* Make sure oSymTableSmall hasn't been corrupted by expansion
-      of oSymTable. */
-   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
-   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+   if (pfHash == NULL)
+      oSymTable = SymTable_new();
+   else
+      oSymTable = SymTable_newWithHash(pfHash);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      pcKey = pcKeys + uKeySize * (size_t)i;
+      iSuccessful = SymTable_put(oSymTable, pcKey, pcKey);
+      ASSURE(iSuccessful);
+   }
+
+   /* Look every key up in enough rounds to make at least
+      LOOKUP_COUNT lookups, so that the clock can measure them. */
+   iRoundCount = (LOOKUP_COUNT + iKeyCount - 1) / iKeyCount;
+   iInitialClock = clock();
+   for (iRound = 0; iRound < iRoundCount; iRound++)
+      for (i = 0; i < iKeyCount; i++)
+      {
+         pcKey = pcKeys + uKeySize * (size_t)i;
+         pvValue = SymTable_get(oSymTable, pcKey);
+         ASSURE(pvValue == pcKey);
+      }
+   iFinalClock = clock();
 
-   /* Free both SymTable objects. */
    SymTable_free(oSymTable);
-   SymTable_free(oSymTableSmall);
+   free(pcKeys);
+   return ((double)(iFinalClock - iInitialClock)) * 1000000.0
+      / CLOCKS_PER_SEC / ((double)iRoundCount * iKeyCount);
+}
 
-   /* Note the current time, and print the time consumed to stdout. */
-   iFinalClock = clock();
-   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
-      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+/*--------------------------------------------------------------------*/
+
+/* Look up keys crafted to collide under the bytewise hash function,
+   in growing numbers up to iBindingCount. With the bytewise hash
+   function every key lands in the same bucket, so the cost per
+   lookup grows with the number of keys; with the built-in keyed
+   hash function it should stay flat, apart from the cost of hashing
+   keys that grow by one block each time the count doubles. Write
+   the time consumed per lookup to stdout. */
+
+static void testCollisionFlood(int iBindingCount)
+{
+   enum {MIN_BLOCK_COUNT = 8, MAX_BLOCK_COUNT = 12};
+
+   int iBlockCount;
+   int iKeyCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups of keys crafted to collide.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   for (iBlockCount = MIN_BLOCK_COUNT; iBlockCount <= MAX_BLOCK_COUNT;
+        iBlockCount++)
+   {
+      iKeyCount = 1 << iBlockCount;
+      if (iKeyCount > iBindingCount)
+         break;
+      printf("CPU time per lookup (%d keys, bytewise hash):  "
+         "%f microseconds\n", iKeyCount,
+         timeCollidingKeys(hashBytewise, iKeyCount, iBlockCount));
+      printf("CPU time per lookup (%d keys, built-in hash):  "
+         "%f microseconds\n", iKeyCount,
+         timeCollidingKeys(NULL, iKeyCount, iBlockCount));
+   }
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that the built-in hash function is keyed all the way through.
+   Each of KEY_COUNT keys consists of BLOCK_COUNT BLOCK_SIZE-character
+   blocks, block j having characters 7, 11 and 15 flipped by 0x80 if
+   bit j of the key's number is 1. A word-at-a-time multiplicative
+   hash with a secret folded in only at its ends gives all of them
+   the same code, whatever the secret. The built-in hash function
+   must give them distinct codes that spread evenly over KEY_COUNT
+   buckets. */
+
+static void testKeyedHash(void)
+{
+   enum {BLOCK_SIZE = 16, BLOCK_COUNT = 10,
+      KEY_COUNT = 1 << BLOCK_COUNT,
+      KEY_LENGTH = BLOCK_SIZE * BLOCK_COUNT, MAX_BUCKET_LOAD = 16};
+
+   unsigned char aucKey[KEY_LENGTH + 1];
+   size_t auHashes[KEY_COUNT];
+   int aiLoads[KEY_COUNT];
+   int iCollisions = 0;
+   int iMaxLoad = 0;
+   int iBlock;
+   int iChar;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing hash codes of keys crafted to collide.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   memset(aiLoads, 0, sizeof(aiLoads));
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      for (iChar = 0; iChar < KEY_LENGTH; iChar++)
+         aucKey[iChar] = (unsigned char)('a' + iChar % 26);
+      for (iBlock = 0; iBlock < BLOCK_COUNT; iBlock++)
+         if ((i >> iBlock) & 1)
+         {
+            aucKey[iBlock * BLOCK_SIZE + 7] ^= 0x80;
+            aucKey[iBlock * BLOCK_SIZE + 11] ^= 0x80;
+            aucKey[iBlock * BLOCK_SIZE + 15] ^= 0x80;
+         }
+      aucKey[KEY_LENGTH] = '\0';
+      auHashes[i] = SymTable_hashKey((const char*)aucKey);
+      aiLoads[auHashes[i] % KEY_COUNT]++;
+   }
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      for (j = 0; j < i; j++)
+         if (auHashes[j] == auHashes[i])
+            iCollisions++;
+      if (aiLoads[i] > iMaxLoad)
+         iMaxLoad = aiLoads[i];
+   }
+   ASSURE(iCollisions == 0);
+   ASSURE(iMaxLoad <= MAX_BUCKET_LOAD);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test interned keys: interning equal strings must return the same
+   handle, and a binding must be reachable both by its key string and
+   by its handle, in any number of SymTable objects. */
+
+static void testInterned(void)
+{
+   SymTable_T oSymTable1;
+   SymTable_T oSymTable2;
+   SymTableKey_T oKeyJeter;
+   SymTableKey_T oKeyMantle;
+   SymTableKey_T oKeyRet;
+   char acJeter[] = "Jeter";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "CenterField";
+   char acPitcher[] = "Pitcher";
+   char *pcValue;
+   int iSuccessful;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing interned keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oKeyJeter = SymTable_intern("Jeter");
+   ASSURE(oKeyJeter != NULL);
+   oKeyMantle = SymTable_intern("Mantle");
+   ASSURE(oKeyMantle != NULL);
+   ASSURE(oKeyJeter != oKeyMantle);
+
+   /* Interning an equal string in a different array returns the
+      same handle. */
+   oKeyRet = SymTable_intern(acJeter);
+   ASSURE(oKeyRet == oKeyJeter);
+   ASSURE(strcmp(SymTable_keyString(oKeyJeter), "Jeter") == 0);
+   ASSURE(SymTable_keyString(oKeyJeter) != acJeter);
+
+   oSymTable1 = SymTable_new();
+   ASSURE(oSymTable1 != NULL);
+   oSymTable2 = SymTable_new();
+   ASSURE(oSymTable2 != NULL);
+
+   /* A binding put by handle is found by handle and by string. */
+   iSuccessful = SymTable_putInterned(oSymTable1, oKeyJeter,
+      acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putInterned(oSymTable1, oKeyJeter,
+      acCenterField);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_put(oSymTable1, "Jeter", acCenterField);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_getInterned(oSymTable1, oKeyJeter);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable1, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   ASSURE(SymTable_containsInterned(oSymTable1, oKeyJeter));
+   ASSURE(! SymTable_containsInterned(oSymTable1, oKeyMantle));
+
+   /* A binding put by string is found by handle and by string. */
+   iSuccessful = SymTable_put(oSymTable1, "Mantle", acCenterField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putInterned(oSymTable1, oKeyMantle,
+      acShortstop);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_getInterned(oSymTable1, oKeyMantle);
+   ASSURE(pcValue == acCenterField);
+   uLength = SymTable_getLength(oSymTable1);
+   ASSURE(uLength == 2);
+
+   /* The same handle can be used in several tables. */
+   iSuccessful = SymTable_putInterned(oSymTable2, oKeyJeter, acPitcher);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_getInterned(oSymTable2, oKeyJeter);
+   ASSURE(pcValue == acPitcher);
+   pcValue = (char*)SymTable_getInterned(oSymTable1, oKeyJeter);
+   ASSURE(pcValue == acShortstop);
+
+   /* Replace and remove by handle. */
+   pcValue = (char*)SymTable_replaceInterned(oSymTable1, oKeyJeter,
+      acPitcher);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable1, "Jeter");
+   ASSURE(pcValue == acPitcher);
+   pcValue = (char*)SymTable_replaceInterned(oSymTable2, oKeyMantle,
+      acPitcher);
+   ASSURE(pcValue == NULL);
+
+   pcValue = (char*)SymTable_removeInterned(oSymTable1, oKeyMantle);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_removeInterned(oSymTable1, oKeyMantle);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_remove(oSymTable1, "Jeter");
+   ASSURE(pcValue == acPitcher);
+   uLength = SymTable_getLength(oSymTable1);
+   ASSURE(uLength == 0);
+
+   SymTable_free(oSymTable1);
+   SymTable_free(oSymTable2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare looking up benchmarkCount(iBindingCount) keys in several
+   SymTable objects by key string and by interned handle, as a
+   compiler looks up the same identifiers in nested scopes. Write the
+   CPU time consumed per lookup by each to stdout. */
+
+static void testInternedLookups(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 32, TABLE_COUNT = 8};
+
+   SymTable_T aoSymTables[TABLE_COUNT];
+   SymTableKey_T *poKeys;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iTable;
+   int iSuccessful;
+   int iFound;
+   int iRound;
+   int iRoundCount;
+   double dLookupCount;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups by key string and by interned handle.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iBindingCount = benchmarkCount(iBindingCount);
+
+   poKeys = (SymTableKey_T*)malloc(sizeof(SymTableKey_T)
+      * (size_t)(iBindingCount + 1));
+   ASSURE(poKeys != NULL);
+   if (poKeys == NULL)
+      return;
+
+   /* Table i holds every key whose number is a multiple of i+1. */
+   for (iTable = 0; iTable < TABLE_COUNT; iTable++)
+   {
+      aoSymTables[iTable] = SymTable_new();
+      ASSURE(aoSymTables[iTable] != NULL);
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "identifier_%d", i);
+      poKeys[i] = SymTable_intern(acKey);
+      ASSURE(poKeys[i] != NULL);
+      for (iTable = 0; iTable < TABLE_COUNT; iTable++)
+      {
+         if (i % (iTable + 1) == 0)
+         {
+            iSuccessful = SymTable_putInterned(aoSymTables[iTable],
+               poKeys[i], poKeys[i]);
+            ASSURE(iSuccessful);
+         }
+      }
+   }
+
+   /* Look every key up in every table by string, in as many rounds
+      as the clock needs to measure them... */
+   iRoundCount = 0;
+   iFound = 0;
+   iInitialClock = clock();
+   do
+   {
+      for (i = 0; i < iBindingCount; i++)
+         for (iTable = 0; iTable < TABLE_COUNT; iTable++)
+            iFound += SymTable_contains(aoSymTables[iTable],
+               SymTable_keyString(poKeys[i]));
+      iRoundCount++;
+   } while (iBindingCount > 0 && keepTiming(iInitialClock));
+   iFinalClock = clock();
+   dLookupCount = (double)iRoundCount * iBindingCount * TABLE_COUNT;
+   if (dLookupCount == 0.0)
+      dLookupCount = 1.0;
+   printf("CPU time per lookup (string):    %f microseconds\n",
+      ((double)(iFinalClock - iInitialClock)) * 1000000.0
+      / CLOCKS_PER_SEC / dLookupCount);
+
+   /* ...and then by handle, in as many rounds. */
+   iInitialClock = clock();
+   for (iRound = 0; iRound < iRoundCount; iRound++)
+      for (i = 0; i < iBindingCount; i++)
+         for (iTable = 0; iTable < TABLE_COUNT; iTable++)
+            iFound -= SymTable_containsInterned(aoSymTables[iTable],
+               poKeys[i]);
+   iFinalClock = clock();
+   printf("CPU time per lookup (interned):  %f microseconds\n",
+      ((double)(iFinalClock - iInitialClock)) * 1000000.0
+      / CLOCKS_PER_SEC / dLookupCount);
+   ASSURE(iFound == 0);
+
+   for (iTable = 0; iTable < TABLE_COUNT; iTable++)
+      SymTable_free(aoSymTables[iTable]);
+   free(poKeys);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_getBatch finds the same values as SymTable_get
+   in a SymTable object with benchmarkCount(iBindingCount) bindings,
+   for keys that are bound and keys that are not, in batches of
+   several sizes. Then compare the time consumed by looking up every
+   key in random order one at a time and in one batch, and write
+   both to stdout. */
+
+static void testBatchLookups(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 16, SMALL_BATCH = 7};
+
+   SymTable_T oSymTable;
+   char *pcKeys;
+   const char **ppcQueries;
+   void **ppvValues;
+   const char *pcSwap;
+   const char *apcDuplicates[3];
+   void *apvDuplicates[3];
+   int iQueryCount = 2 * benchmarkCount(iBindingCount);
+   int i;
+   int j;
+   int iSuccessful;
+   int iRound;
+   int iRoundCount;
+   unsigned long ulRandom = 1;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing batched lookups.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = (char*)malloc((size_t)MAX_KEY_LENGTH
+      * (size_t)(iQueryCount + 1));
+   ppcQueries = (const char**)malloc(sizeof(const char*)
+      * (size_t)(iQueryCount + 1));
+   ppvValues = (void**)malloc(sizeof(void*)
+      * (size_t)(iQueryCount + 1));
+   oSymTable = SymTable_new();
+   ASSURE(pcKeys != NULL && ppcQueries != NULL && ppvValues != NULL
+      && oSymTable != NULL);
+   if (pcKeys == NULL || ppcQueries == NULL || ppvValues == NULL
+      || oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   /* Bind every even-numbered key to itself; odd ones stay unbound. */
+   for (i = 0; i < iQueryCount; i++)
+   {
+      ppcQueries[i] = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "batch_%d", i);
+      if (i % 2 == 0)
+      {
+         iSuccessful = SymTable_put(oSymTable, ppcQueries[i],
+            ppcQueries[i]);
+         ASSURE(iSuccessful);
+      }
+   }
+
+   /* Shuffle the keys, so that lookups do not follow insertion. */
+   for (i = iQueryCount - 1; i > 0; i--)
+   {
+      ulRandom = ulRandom * 1103515245UL + 12345UL;
+      j = (int)((ulRandom >> 8) % (unsigned long)(i + 1));
+      pcSwap = ppcQueries[i];
+      ppcQueries[i] = ppcQueries[j];
+      ppcQueries[j] = pcSwap;
+   }
+
+   /* An empty batch touches nothing. */
+   SymTable_getBatch(oSymTable, NULL, 0, NULL);
+
+   /* Batches smaller than, equal to, and larger than any internal
+      batch, and repeated keys within one batch. */
+   for (i = 0; i < iQueryCount; i += SMALL_BATCH)
+   {
+      j = (iQueryCount - i < SMALL_BATCH) ? iQueryCount - i
+                                           : SMALL_BATCH;
+      SymTable_getBatch(oSymTable, ppcQueries + i, (size_t)j,
+         ppvValues + i);
+   }
+   for (i = 0; i < iQueryCount; i++)
+      ASSURE(ppvValues[i] == SymTable_get(oSymTable, ppcQueries[i]));
+   if (iQueryCount > 0)
+   {
+      apcDuplicates[0] = ppcQueries[0];
+      apcDuplicates[1] = "not a key";
+      apcDuplicates[2] = ppcQueries[0];
+      SymTable_getBatch(oSymTable, apcDuplicates, 3, apvDuplicates);
+      ASSURE(apvDuplicates[0] == SymTable_get(oSymTable,
+         ppcQueries[0]));
+      ASSURE(apvDuplicates[1] == NULL);
+      ASSURE(apvDuplicates[2] == apvDuplicates[0]);
+   }
+
+   /* Time every key looked up one at a time, in as many rounds as
+      the clock needs to measure them... */
+   iRoundCount = 0;
+   iInitialClock = clock();
+   do
+   {
+      for (i = 0; i < iQueryCount; i++)
+         ppvValues[i] = SymTable_get(oSymTable, ppcQueries[i]);
+      iRoundCount++;
+   } while (iQueryCount > 0 && keepTiming(iInitialClock));
+   iFinalClock = clock();
+   printf("CPU time (one at a time):  %f seconds\n",
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC
+      / iRoundCount);
+
+   /* ... and in one batch, in as many rounds. */
+   iInitialClock = clock();
+   for (iRound = 0; iRound < iRoundCount; iRound++)
+      SymTable_getBatch(oSymTable, ppcQueries, (size_t)iQueryCount,
+         ppvValues);
+   iFinalClock = clock();
+   printf("CPU time (one batch):      %f seconds\n",
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC
+      / iRoundCount);
+   for (i = 0; i < iQueryCount; i++)
+      ASSURE(ppvValues[i] == SymTable_get(oSymTable, ppcQueries[i]));
+
+   SymTable_free(oSymTable);
+   free(ppvValues);
+   free(ppcQueries);
+   free(pcKeys);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_findOrInsert: that it adds a missing key once, that
+   it returns the address of the existing value otherwise, and that
+   writing through that address changes the binding. Then count the
+   occurrences of keys that repeat, as a word counter would, growing
+   the table on the way. */
+
+static void testFindOrInsert(void)
+{
+   enum {KEY_COUNT = 2000, MAX_REPEAT = 3};
+
+   SymTable_T oSymTable;
+   char acKey[32];
+   char acCounts[MAX_REPEAT];
+   void **ppvValue;
+   void **ppvOther;
+   char *pcValue;
+   size_t uLength;
+   int iCreated;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_findOrInsert.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* A missing key is added with the given value. */
+   strcpy(acKey, "Ruth");
+   ppvValue = SymTable_findOrInsert(oSymTable, acKey, "Right Field",
+      &iCreated);
+   ASSURE(ppvValue != NULL);
+   ASSURE(iCreated == 1);
+   ASSURE(strcmp((char*)*ppvValue, "Right Field") == 0);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   /* The key was copied, and finding it again adds nothing. */
+   strcpy(acKey, "XXXX");
+   ppvOther = SymTable_findOrInsert(oSymTable, "Ruth", "Pitcher",
+      &iCreated);
+   ASSURE(ppvOther == ppvValue);
+   ASSURE(iCreated == 0);
+   ASSURE(strcmp((char*)*ppvOther, "Right Field") == 0);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   /* Writing through the address replaces the value. */
+   *ppvValue = "Pitcher";
+   pcValue = (char*)SymTable_get(oSymTable, "Ruth");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Pitcher") == 0);
+
+   /* piCreated may be NULL, and NULL values are fine. */
+   ppvValue = SymTable_findOrInsert(oSymTable, "Gehrig", NULL, NULL);
+   ASSURE(ppvValue != NULL && *ppvValue == NULL);
+   ASSURE(SymTable_contains(oSymTable, "Gehrig"));
+
+   SymTable_free(oSymTable);
+
+   /* Key i occurs i % MAX_REPEAT + 1 times; its value ends up
+      pointing at acCounts[occurrences - 1]. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (j = 0; j < MAX_REPEAT; j++)
+   {
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         if (i % MAX_REPEAT < j)
+            continue;
+         sprintf(acKey, "word_%d", i);
+         ppvValue = SymTable_findOrInsert(oSymTable, acKey, acCounts,
+            &iCreated);
+         ASSURE(ppvValue != NULL);
+         ASSURE(iCreated == (j == 0));
+         if (ppvValue != NULL && !iCreated)
+            *ppvValue = (char*)*ppvValue + 1;
+      }
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "word_%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue == acCounts + i % MAX_REPEAT);
+   }
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_putN, SymTable_containsN, SymTable_getN, and
+   SymTable_removeN on keys that are slices of a larger buffer and
+   so are not followed by '\0', in tables using the built-in hash
+   function and a client hash function. Keys given by length and
+   keys given as strings must name the same bindings. */
+
+static void testLengthKeys(void)
+{
+   enum {LONG_KEY_LENGTH = 300};
+
+   SymTable_T oSymTable;
+   const char *pcLine = "Ruth Gehrig Mantle";
+   char acLong[LONG_KEY_LENGTH + 2];
+   char *pcValue;
+   size_t uLength;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys given by their length.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < 2; i++)
+   {
+      if (i == 0)
+         oSymTable = SymTable_new();
+      else
+         oSymTable = SymTable_newWithHash(hashBytewise);
+      ASSURE(oSymTable != NULL);
+
+      /* "Ruth" and "Gehrig", taken from the middle of pcLine. */
+      iSuccessful = SymTable_putN(oSymTable, pcLine, 4, "Right Field");
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_putN(oSymTable, pcLine + 5, 6,
+         "First Base");
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable, "Ruth", "Pitcher");
+      ASSURE(! iSuccessful);
+      iSuccessful = SymTable_putN(oSymTable, "Gehrigs", 6, "Pitcher");
+      ASSURE(! iSuccessful);
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == 2);
+
+      /* A prefix or an extension of a key is a different key. */
+      ASSURE(SymTable_containsN(oSymTable, pcLine, 4));
+      ASSURE(! SymTable_containsN(oSymTable, pcLine, 3));
+      ASSURE(! SymTable_containsN(oSymTable, pcLine, 5));
+      ASSURE(SymTable_contains(oSymTable, "Gehrig"));
+      ASSURE(! SymTable_contains(oSymTable, "Gehrig Mantle"));
+
+      pcValue = (char*)SymTable_getN(oSymTable, pcLine + 5, 6);
+      ASSURE(pcValue != NULL && strcmp(pcValue, "First Base") == 0);
+      pcValue = (char*)SymTable_get(oSymTable, "Ruth");
+      ASSURE(pcValue != NULL && strcmp(pcValue, "Right Field") == 0);
+      pcValue = (char*)SymTable_getN(oSymTable, pcLine + 12, 6);
+      ASSURE(pcValue == NULL);
+
+      /* The empty slice is the empty string. */
+      iSuccessful = SymTable_putN(oSymTable, pcLine, 0, "Nobody");
+      ASSURE(iSuccessful);
+      pcValue = (char*)SymTable_get(oSymTable, "");
+      ASSURE(pcValue != NULL && strcmp(pcValue, "Nobody") == 0);
+
+      /* A key longer than any stack copy of it. */
+      memset(acLong, 'x', sizeof(acLong));
+      iSuccessful = SymTable_putN(oSymTable, acLong, LONG_KEY_LENGTH,
+         "Long");
+      ASSURE(iSuccessful);
+      ASSURE(! SymTable_containsN(oSymTable, acLong,
+         LONG_KEY_LENGTH + 1));
+      acLong[LONG_KEY_LENGTH] = '\0';
+      pcValue = (char*)SymTable_get(oSymTable, acLong);
+      ASSURE(pcValue != NULL && strcmp(pcValue, "Long") == 0);
+
+      pcValue = (char*)SymTable_removeN(oSymTable, pcLine, 4);
+      ASSURE(pcValue != NULL && strcmp(pcValue, "Right Field") == 0);
+      ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+      pcValue = (char*)SymTable_removeN(oSymTable, pcLine, 4);
+      ASSURE(pcValue == NULL);
+      pcValue = (char*)SymTable_remove(oSymTable, "Gehrig");
+      ASSURE(pcValue != NULL && strcmp(pcValue, "First Base") == 0);
+      ASSURE(! SymTable_containsN(oSymTable, pcLine + 5, 6));
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == 2);
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_hashKey and the functions that take its result,
+   looking a key up in a chain of scopes as a compiler would, with
+   one scope using a client hash function. */
+
+static void testHashedKeys(void)
+{
+   enum {SCOPE_COUNT = 3, KEY_COUNT = 500};
+
+   SymTable_T aoScopes[SCOPE_COUNT];
+   char acKey[32];
+   char acCopy[32];
+   char *pcValue;
+   size_t uHash;
+   size_t uLength;
+   int iSuccessful;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys hashed in advance.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* The code depends only on the characters of the key. */
+   strcpy(acKey, "Ruth");
+   strcpy(acCopy, "Ruth");
+   ASSURE(SymTable_hashKey(acKey) == SymTable_hashKey(acCopy));
+
+   aoScopes[0] = SymTable_new();
+   aoScopes[1] = SymTable_newWithHash(hashBytewise);
+   aoScopes[2] = SymTable_new();
+   for (j = 0; j < SCOPE_COUNT; j++)
+      ASSURE(aoScopes[j] != NULL);
+
+   /* Key i is declared in scope i % SCOPE_COUNT only. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "name_%d", i);
+      uHash = SymTable_hashKey(acKey);
+      iSuccessful = SymTable_putHashed(aoScopes[i % SCOPE_COUNT],
+         acKey, uHash, aoScopes + i % SCOPE_COUNT);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_putHashed(aoScopes[i % SCOPE_COUNT],
+         acKey, uHash, NULL);
+      ASSURE(! iSuccessful);
+   }
+
+   /* Each key is hashed once and found in the innermost scope that
+      declares it, and nowhere else. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "name_%d", i);
+      uHash = SymTable_hashKey(acKey);
+      pcValue = NULL;
+      for (j = SCOPE_COUNT - 1; j >= 0 && pcValue == NULL; j--)
+         pcValue = (char*)SymTable_getHashed(aoScopes[j], acKey, uHash);
+      ASSURE(pcValue == (char*)(aoScopes + i % SCOPE_COUNT));
+      pcValue = (char*)SymTable_get(aoScopes[i % SCOPE_COUNT], acKey);
+      ASSURE(pcValue == (char*)(aoScopes + i % SCOPE_COUNT));
+   }
+
+   /* Bindings put by string can be removed by hash, and the other
+      way around. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "name_%d", i);
+      pcValue = (char*)SymTable_removeHashed(aoScopes[i % SCOPE_COUNT],
+         acKey, SymTable_hashKey(acKey));
+      ASSURE(pcValue == (char*)(aoScopes + i % SCOPE_COUNT));
+   }
+   for (j = 0; j < SCOPE_COUNT; j++)
+   {
+      uLength = SymTable_getLength(aoScopes[j]);
+      ASSURE(uLength == 0);
+      iSuccessful = SymTable_put(aoScopes[j], "Gehrig", "First Base");
+      ASSURE(iSuccessful);
+      pcValue = (char*)SymTable_removeHashed(aoScopes[j], "Gehrig",
+         SymTable_hashKey("Gehrig"));
+      ASSURE(pcValue != NULL && strcmp(pcValue, "First Base") == 0);
+      ASSURE(! SymTable_contains(aoScopes[j], "Gehrig"));
+      SymTable_free(aoScopes[j]);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newWithCapacity and SymTable_reserve: that tables
+   sized in advance hold their bindings like any other, and that
+   reserving room, more or less than there is, keeps every binding. */
+
+static void testCapacity(void)
+{
+   enum {KEY_COUNT = 3000};
+
+   SymTable_T oSymTable;
+   char acKey[32];
+   char *pcValue;
+   size_t uLength;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects sized in advance.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithCapacity(0);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", "Right Field");
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Ruth");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Right Field") == 0);
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_newWithCapacity(KEY_COUNT);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+      ASSURE(iSuccessful);
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+   }
+   SymTable_free(oSymTable);
+
+   /* Reserving room in a table that has bindings keeps them, and a
+      smaller capacity than the table has changes nothing. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEY_COUNT / 2; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_reserve(oSymTable, KEY_COUNT * 4);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_reserve(oSymTable, 1);
+   ASSURE(iSuccessful);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT / 2);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i < KEY_COUNT / 2)
+      {
+         ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+         pcValue = (char*)SymTable_remove(oSymTable, acKey);
+         ASSURE(pcValue == (char*)oSymTable);
+      }
+      else
+      {
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+         iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+         ASSURE(iSuccessful);
+      }
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT - KEY_COUNT / 2);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable objects that shrink as most of their bindings are
+   removed, and that are compacted afterwards. */
+
+static void testCompact(void)
+{
+   enum {KEY_COUNT = 1000};
+   enum {KEPT_EVERY = 50};
+
+   SymTable_T oSymTable;
+   SymTableKey_T oKey;
+   char acKey[32];
+   char *pcValue;
+   size_t uLength;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects that shrink and are compacted.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Compacting an empty table leaves a table that still works. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", "Right Field");
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Ruth");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Right Field") == 0);
+   SymTable_free(oSymTable);
+
+   /* Removing most of the bindings, some of them interned, keeps
+      the rest, before and after compacting. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % 3 == 0)
+      {
+         oKey = SymTable_intern(acKey);
+         ASSURE(oKey != NULL);
+         iSuccessful = SymTable_putInterned(oSymTable, oKey, oSymTable);
+      }
+      else
+         iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      if (i % KEPT_EVERY == 0)
+         continue;
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue == (char*)oSymTable);
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT / KEPT_EVERY);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey)
+             == (i % KEPT_EVERY == 0));
+   }
+
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT / KEPT_EVERY);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % KEPT_EVERY == 0)
+      {
+         ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+         if (i % 3 == 0)
+         {
+            oKey = SymTable_intern(acKey);
+            ASSURE(SymTable_getInterned(oSymTable, oKey) == oSymTable);
+         }
+      }
+      else
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+
+   /* A compacted table grows again as bindings are put. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      if (i % KEPT_EVERY == 0)
+         continue;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acKey);
+      ASSURE(iSuccessful);
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 0);
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(! SymTable_contains(oSymTable, "0"));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test walking the bindings of SymTable objects with cursors,
+   removing some of the bindings along the way. */
+
+static void testCursor(void)
+{
+   enum {KEY_COUNT = 1000};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   struct SymTableIter sCopy;
+   SymTableKey_T oKey;
+   char acKey[32];
+   const char *pcKey;
+   void *pvValue;
+   int *piSeen;
+   int iSuccessful;
+   int iCount;
+   int iKey;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing walking SymTable objects with cursors.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   piSeen = (int*)calloc(KEY_COUNT, sizeof(int));
+   ASSURE(piSeen != NULL);
+   if (piSeen == NULL)
+      return;
+
+   /* A cursor over an empty table returns nothing. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_begin(oSymTable, &sIter);
+   ASSURE(! SymTable_next(&sIter, &pcKey, &pvValue));
+   ASSURE(! SymTable_next(&sIter, NULL, NULL));
+   SymTable_end(&sIter);
+
+   /* Every binding, interned or not, is returned exactly once, with
+      its value. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % 4 == 0)
+      {
+         oKey = SymTable_intern(acKey);
+         ASSURE(oKey != NULL);
+         iSuccessful = SymTable_putInterned(oSymTable, oKey,
+                                            &piSeen[i]);
+      }
+      else
+         iSuccessful = SymTable_put(oSymTable, acKey, &piSeen[i]);
+      ASSURE(iSuccessful);
+   }
+   iCount = 0;
+   SymTable_begin(oSymTable, &sIter);
+   while (SymTable_next(&sIter, &pcKey, &pvValue))
+   {
+      iKey = atoi(pcKey);
+      ASSURE(iKey >= 0 && iKey < KEY_COUNT);
+      ASSURE(pvValue == &piSeen[iKey]);
+      piSeen[iKey]++;
+      iCount++;
+   }
+   ASSURE(! SymTable_next(&sIter, &pcKey, &pvValue));
+   SymTable_end(&sIter);
+   ASSURE(iCount == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(piSeen[i] == 1);
+
+   /* A copy of a cursor goes on from the same place. */
+   SymTable_begin(oSymTable, &sIter);
+   for (i = 0; i < KEY_COUNT / 2; i++)
+      ASSURE(SymTable_next(&sIter, NULL, NULL));
+   sCopy = sIter;
+   for (i = 0; i < KEY_COUNT / 4; i++)
+   {
+      ASSURE(SymTable_next(&sIter, &pcKey, NULL));
+      ASSURE(SymTable_next(&sCopy, NULL, &pvValue));
+      ASSURE(pvValue == SymTable_get(oSymTable, pcKey));
+   }
+   SymTable_end(&sCopy);
+
+   /* Removing the binding returned last, until most of the table is
+      gone, still returns every binding once; tables that shrink as
+      bindings are removed do so along the way. */
+   memset(piSeen, 0, KEY_COUNT * sizeof(int));
+   iCount = 0;
+   SymTable_begin(oSymTable, &sIter);
+   while (SymTable_next(&sIter, &pcKey, &pvValue))
+   {
+      iKey = atoi(pcKey);
+      ASSURE(iKey >= 0 && iKey < KEY_COUNT);
+      piSeen[iKey]++;
+      if (iKey % 10 != 0)
+      {
+         sprintf(acKey, "%d", iKey);
+         pvValue = SymTable_remove(oSymTable, acKey);
+         ASSURE(pvValue == &piSeen[iKey]);
+      }
+      else
+         (void)SymTable_replace(oSymTable, pcKey, oSymTable);
+      iCount++;
+   }
+   SymTable_end(&sIter);
+   ASSURE(iCount == KEY_COUNT);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT / 10);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      ASSURE(piSeen[i] == 1);
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 10 == 0));
+   }
+
+   /* The table works as usual once its cursors are closed. */
+   iCount = 0;
+   SymTable_begin(oSymTable, &sIter);
+   while (SymTable_next(&sIter, NULL, &pvValue))
+   {
+      ASSURE(pvValue == oSymTable);
+      iCount++;
+   }
+   SymTable_end(&sIter);
+   ASSURE(iCount == KEY_COUNT / 10);
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % 10 != 0)
+      {
+         iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+         ASSURE(iSuccessful);
+      }
+      ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+   }
+
+   SymTable_free(oSymTable);
+   free(piSeen);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Keys seen by a scan of a SymTable object in key order. */
+
+struct KeyScan
+{
+   /* Number of bindings visited. */
+   int iCount;
+   /* 1 while each key visited was greater than the one before. */
+   int iInOrder;
+   /* First and last keys visited. */
+   char acFirst[32];
+   char acLast[32];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Start scan *psScan over, with no keys seen. */
+
+static void startScan(struct KeyScan *psScan)
+{
+   assert(psScan != NULL);
+
+   psScan->iCount = 0;
+   psScan->iInOrder = 1;
+   psScan->acFirst[0] = '\0';
+   psScan->acLast[0] = '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record a visit of key pcKey in scan pvExtra, a struct KeyScan.
+   pvValue is unused. */
+
+static void scanKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct KeyScan *psScan = (struct KeyScan*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(psScan != NULL);
+   (void)pvValue;
+
+   if (psScan->iCount == 0)
+   {
+      strncpy(psScan->acFirst, pcKey, sizeof(psScan->acFirst) - 1);
+      psScan->acFirst[sizeof(psScan->acFirst) - 1] = '\0';
+   }
+   else if (strcmp(psScan->acLast, pcKey) >= 0)
+      psScan->iInOrder = 0;
+   strncpy(psScan->acLast, pcKey, sizeof(psScan->acLast) - 1);
+   psScan->acLast[sizeof(psScan->acLast) - 1] = '\0';
+   psScan->iCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapRange and SymTable_mapPrefix, which must visit
+   the bindings of a key range or prefix in key order whatever the
+   implementation. */
+
+static void testOrderedScans(void)
+{
+   enum {KEY_COUNT = 2000};
+   enum {STRIDE = 7919};
+
+   static const char *apcWords[] = {"", "a", "ab", "b", "abcdefg",
+      "abcdefgh", "abcdefgha", "abcdefghi", "abcdefgi", "z",
+      "\xc3\xa9t\xc3\xa9", "\x7f"};
+
+   SymTable_T oSymTable;
+   struct KeyScan sScan;
+   char acKey[32];
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing range and prefix scans in key order.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Keys of different lengths, some sharing their first eight
+      characters and some with characters above 127, come in the
+      order of strcmp. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < (int)(sizeof(apcWords) / sizeof(apcWords[0])); i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcWords[i], NULL);
+      ASSURE(iSuccessful);
+   }
+   startScan(&sScan);
+   iSuccessful = SymTable_mapRange(oSymTable, NULL, NULL, scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount
+          == (int)(sizeof(apcWords) / sizeof(apcWords[0])));
+   ASSURE(sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "") == 0);
+   ASSURE(strcmp(sScan.acLast, "\xc3\xa9t\xc3\xa9") == 0);
+
+   startScan(&sScan);
+   iSuccessful = SymTable_mapPrefix(oSymTable, "abcdefgh", scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 3 && sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "abcdefgh") == 0);
+   ASSURE(strcmp(sScan.acLast, "abcdefghi") == 0);
+
+   startScan(&sScan);
+   iSuccessful = SymTable_mapRange(oSymTable, "ab", "abcdefgi", scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 5 && sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "ab") == 0);
+   ASSURE(strcmp(sScan.acLast, "abcdefghi") == 0);
+   SymTable_free(oSymTable);
+
+   /* Many keys, put out of order. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%05d", (int)((long)i * STRIDE % KEY_COUNT));
+      iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+      ASSURE(iSuccessful);
+   }
+
+   startScan(&sScan);
+   iSuccessful = SymTable_mapRange(oSymTable, NULL, NULL, scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == KEY_COUNT && sScan.iInOrder);
+
+   startScan(&sScan);
+   iSuccessful = SymTable_mapRange(oSymTable, "00100", "00200", scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 100 && sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "00100") == 0);
+   ASSURE(strcmp(sScan.acLast, "00199") == 0);
+
+   /* Bounds need not be keys of the table. */
+   startScan(&sScan);
+   iSuccessful = SymTable_mapRange(oSymTable, "0150", NULL, scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == KEY_COUNT - 1500 && sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "01500") == 0);
+
+   /* An empty range visits nothing. */
+   startScan(&sScan);
+   iSuccessful = SymTable_mapRange(oSymTable, "00200", "00100", scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 0);
+
+   startScan(&sScan);
+   iSuccessful = SymTable_mapPrefix(oSymTable, "012", scanKey, &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 100 && sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "01200") == 0);
+   ASSURE(strcmp(sScan.acLast, "01299") == 0);
+
+   startScan(&sScan);
+   iSuccessful = SymTable_mapPrefix(oSymTable, "", scanKey, &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == KEY_COUNT && sScan.iInOrder);
+
+   startScan(&sScan);
+   iSuccessful = SymTable_mapPrefix(oSymTable, "x", scanKey, &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 0);
+
+   /* Scans skip removed bindings, before and after compacting. */
+   for (i = 0; i < KEY_COUNT; i += 2)
+   {
+      sprintf(acKey, "%05d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == oSymTable);
+   }
+   startScan(&sScan);
+   iSuccessful = SymTable_mapPrefix(oSymTable, "0019", scanKey, &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 5 && sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "00191") == 0);
+   ASSURE(strcmp(sScan.acLast, "00199") == 0);
+
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   startScan(&sScan);
+   iSuccessful = SymTable_mapRange(oSymTable, "00001", "01001", scanKey,
+      &sScan);
+   ASSURE(iSuccessful);
+   ASSURE(sScan.iCount == 500 && sScan.iInOrder);
+   ASSURE(strcmp(sScan.acFirst, "00001") == 0);
+   ASSURE(strcmp(sScan.acLast, "00999") == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a new SymTable object, sized for
+   them in advance if iPresized is 1, and free it. Return the CPU
+   time consumed in seconds. */
+
+static double timeBulkLoad(int iBindingCount, int iPresized)
+{
+   /* room for any int, down to "-2147483648", and its '\0' */
+   enum {MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   iInitialClock = clock();
+
+   if (iPresized)
+      oSymTable = SymTable_newWithCapacity((size_t)iBindingCount);
+   else
+      oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      snprintf(acKey, sizeof(acKey), "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acKey);
+      ASSURE(iSuccessful);
+   }
+   SymTable_free(oSymTable);
+
+   iFinalClock = clock();
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count a visit of the binding whose value pvValue is the binding's
+   own counter. pvExtra is unused. */
+
+static void countVisit(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra == NULL);
+
+   (*(int*)pvValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a checksum of key pcKey, the kind of work a pass over a table
+   does, to the binding's own counter pvValue. Only the binding's own
+   memory is written, so many threads can do this at once. pvExtra
+   is unused. */
+
+static void weighKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   enum {KEY_PASSES = 16};
+
+   unsigned int uSum = 0;
+   const char *pc;
+   int iPass;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra == NULL);
+
+   for (iPass = 0; iPass < KEY_PASSES; iPass++)
+      for (pc = pcKey; *pc != '\0'; pc++)
+         uSum = uSum * 31 + (unsigned char)*pc;
+   *(int*)pvValue += (int)(uSum & 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapParallel on a SymTable object containing
+   iBindingCount bindings, and write the wall-clock time it takes
+   with more and more threads to stdout. */
+
+static void testMapParallel(int iBindingCount)
+{
+   enum {MAX_THREAD_COUNT = 8};
+   enum {MAP_ROUNDS = 10};
+
+   SymTable_T oSymTable;
+   char acKey[32];
+   int *piCounts;
+   int iThreadCount;
+   int iSuccessful;
+   int iRound;
+   int i;
+   double dStart;
+   double dSerial = 0.0;
+   double dElapsed;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapParallel.\n");
+   printf("No output except wall-clock time consumed should appear "
+      "here:\n");
+   fflush(stdout);
+
+   piCounts = (int*)calloc((size_t)iBindingCount + 1, sizeof(int));
+   ASSURE(piCounts != NULL);
+   if (piCounts == NULL)
+      return;
+
+   /* Mapping an empty table applies nothing. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_mapParallel(oSymTable, countVisit, NULL, MAX_THREAD_COUNT);
+
+   /* Every binding is visited once by each call, whatever the
+      number of threads. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &piCounts[i]);
+      ASSURE(iSuccessful);
+   }
+   for (iThreadCount = 0; iThreadCount <= MAX_THREAD_COUNT;
+      iThreadCount++)
+      SymTable_mapParallel(oSymTable, countVisit, NULL, iThreadCount);
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(piCounts[i] == MAX_THREAD_COUNT + 1);
+   ASSURE(piCounts[iBindingCount] == 0);
+
+   /* Time a pass that only reads the keys. */
+   for (iThreadCount = 1; iThreadCount <= MAX_THREAD_COUNT;
+      iThreadCount *= 2)
+   {
+      dStart = wallClock();
+      for (iRound = 0; iRound < MAP_ROUNDS; iRound++)
+         SymTable_mapParallel(oSymTable, weighKey, NULL, iThreadCount);
+      dElapsed = wallClock() - dStart;
+      if (iThreadCount == 1)
+         dSerial = dElapsed;
+      printf("Wall-clock time to map %d bindings %d times with %d "
+         "thread(s): %f seconds (speedup %.2f)\n", iBindingCount,
+         MAP_ROUNDS, iThreadCount, dElapsed,
+         dElapsed > 0.0 ? dSerial / dElapsed : 0.0);
+   }
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(piCounts);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of a key drawn at random from the iKeyCount keys
+   whose cumulative weights are in adCumulative, using and updating
+   the generator state *pulRandom. */
+
+static int drawKey(const double adCumulative[], int iKeyCount,
+   unsigned long *pulRandom)
+{
+   double dTarget;
+   int iLow = 0;
+   int iHigh = iKeyCount - 1;
+   int iMiddle;
+
+   *pulRandom = *pulRandom * 1103515245UL + 12345UL;
+   dTarget = (double)((*pulRandom >> 8) % 1000000UL) / 1000000.0
+      * adCumulative[iKeyCount - 1];
+   while (iLow < iHigh)
+   {
+      iMiddle = (iLow + iHigh) / 2;
+      if (adCumulative[iMiddle] <= dTarget)
+         iLow = iMiddle + 1;
+      else
+         iHigh = iMiddle;
+   }
+   return iLow;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if a SymTable object with lookup policy
+   SYMTABLE_POLICY_MOVE_TO_FRONT moves the key looked up last to the
+   front of its cursor order, and 0 if it ignores the policy. */
+
+static int movesToFront(void)
+{
+   enum {KEY_COUNT = 3};
+
+   static const char *apcKeys[KEY_COUNT] = {"Ruth", "Gehrig", "Mantle"};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   const char *pcKey;
+   char acLast[16] = "";
+   int iSuccessful;
+   int iMoved;
+   int i;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return 0;
+   SymTable_setPolicy(oSymTable, SYMTABLE_POLICY_MOVE_TO_FRONT);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], NULL);
+      ASSURE(iSuccessful);
+   }
+
+   SymTable_begin(oSymTable, &sIter);
+   while (SymTable_next(&sIter, &pcKey, NULL))
+      strcpy(acLast, pcKey);
+   SymTable_end(&sIter);
+
+   /* A cursor's keys may not outlive it, so the last one is copied. */
+   ASSURE(SymTable_contains(oSymTable, acLast));
+   SymTable_begin(oSymTable, &sIter);
+   iMoved = SymTable_next(&sIter, &pcKey, NULL)
+      && strcmp(pcKey, acLast) == 0;
+   SymTable_end(&sIter);
+
+   SymTable_free(oSymTable);
+   return iMoved;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the iKeyCount keys of pcKeys, MAX_KEY_LENGTH characters apart,
+   into a new SymTable object with lookup policy iPolicy, in the
+   order of the key numbers in aiOrder, each bound to its number in
+   aiNumbers. Then look up iLookupCount keys drawn from the
+   cumulative weights adCumulative, the same sequence for every
+   policy. Store at *pdPosition the position of a key looked up in
+   the table's cursor order, averaged by weight, and return the CPU
+   time consumed per lookup in microseconds. */
+
+static double timeSkewedLookups(int iPolicy, const char *pcKeys,
+   const int aiOrder[], int aiNumbers[], const double adCumulative[],
+   int iKeyCount, int iLookupCount, double *pdPosition)
+{
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   unsigned long ulRandom = 1;
+   void *pvValue;
+   double dWeighted = 0.0;
+   int iPosition;
+   int iKey;
+   int iSuccessful;
+   int i;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return 0.0;
+   SymTable_setPolicy(oSymTable, iPolicy);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      iKey = aiOrder[i];
+      iSuccessful = SymTable_put(oSymTable,
+         pcKeys + (size_t)iKey * MAX_KEY_LENGTH, &aiNumbers[iKey]);
+      ASSURE(iSuccessful);
+   }
+
+   iInitialClock = clock();
+   for (i = 0; i < iLookupCount; i++)
+   {
+      iKey = drawKey(adCumulative, iKeyCount, &ulRandom);
+      pvValue = SymTable_get(oSymTable,
+         pcKeys + (size_t)iKey * MAX_KEY_LENGTH);
+      ASSURE(pvValue == &aiNumbers[iKey]);
+   }
+   iFinalClock = clock();
+
+   /* A key at position p in the list is found after p comparisons. */
+   iPosition = 0;
+   SymTable_begin(oSymTable, &sIter);
+   while (SymTable_next(&sIter, NULL, &pvValue))
+   {
+      iKey = *(int*)pvValue;
+      iPosition++;
+      dWeighted += (adCumulative[iKey]
+         - (iKey > 0 ? adCumulative[iKey - 1] : 0.0)) * iPosition;
+   }
+   SymTable_end(&sIter);
+   ASSURE(iPosition == iKeyCount);
+   *pdPosition = dWeighted / adCumulative[iKeyCount - 1];
+
+   SymTable_free(oSymTable);
+   return ((double)(iFinalClock - iInitialClock)) * 1000000.0
+      / CLOCKS_PER_SEC / (double)iLookupCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test lookups with each policy of SymTable_setPolicy: that lookups
+   of every kind still find every binding however the table reorders
+   them, and that cursors open meanwhile still return every binding
+   once. Then look up keys drawn from a Zipf distribution, the way a
+   compiler looks up the few hot locals of a function far more often
+   than the rest, with the keys put in random order, and write the
+   CPU time per lookup for each policy to stdout. Where lookups move
+   keys to the front, as in the linked list, whose cursor order is
+   the order its lookups search in, also write the average position
+   of the key looked up, the number of keys a lookup compares. */
+
+static void testLookupPolicies(void)
+{
+   enum {MAX_KEY_LENGTH = 16, KEY_COUNT = 256, LOOKUP_COUNT = 200000};
+   enum {POLICY_COUNT = 3};
+
+   static const int aiPolicies[POLICY_COUNT] = {
+      SYMTABLE_POLICY_STATIC, SYMTABLE_POLICY_MOVE_TO_FRONT,
+      SYMTABLE_POLICY_TRANSPOSE};
+   static const char *apcNames[POLICY_COUNT] = {
+      "static", "move to front", "transpose"};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   char *pcKeys;
+   int *aiNumbers;
+   int *aiOrder;
+   int *piSeen;
+   double *adCumulative;
+   unsigned long ulRandom = 7;
+   void *pvValue;
+   double dPosition = 0.0;
+   double dTime;
+   int iPolicy;
+   int iReorders;
+   int iSuccessful;
+   int iKey;
+   int iCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups that reorder the bindings.\n");
+   printf("No output except CPU time consumed and keys compared "
+      "should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = (char*)malloc((size_t)MAX_KEY_LENGTH * KEY_COUNT);
+   aiNumbers = (int*)malloc(sizeof(int) * KEY_COUNT);
+   aiOrder = (int*)malloc(sizeof(int) * KEY_COUNT);
+   piSeen = (int*)malloc(sizeof(int) * KEY_COUNT);
+   adCumulative = (double*)malloc(sizeof(double) * KEY_COUNT);
+   ASSURE(pcKeys != NULL && aiNumbers != NULL && aiOrder != NULL
+      && piSeen != NULL && adCumulative != NULL);
+   if (pcKeys == NULL || aiNumbers == NULL || aiOrder == NULL
+      || piSeen == NULL || adCumulative == NULL)
+      exit(EXIT_FAILURE);
+
+   /* Key i is looked up with weight 1 / (i + 1). */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "local_%d", i);
+      aiNumbers[i] = i;
+      aiOrder[i] = i;
+      adCumulative[i] = 1.0 / (i + 1) + (i > 0 ? adCumulative[i - 1]
+                                               : 0.0);
+   }
+
+   /* Shuffle the order the keys are put in, which has nothing to do
+      with how often they are looked up. */
+   for (i = KEY_COUNT - 1; i > 0; i--)
+   {
+      ulRandom = ulRandom * 1103515245UL + 12345UL;
+      iKey = (int)((ulRandom >> 8) % (unsigned long)(i + 1));
+      iCount = aiOrder[i];
+      aiOrder[i] = aiOrder[iKey];
+      aiOrder[iKey] = iCount;
+   }
+
+   for (iPolicy = 0; iPolicy < POLICY_COUNT; iPolicy++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      SymTable_setPolicy(oSymTable, aiPolicies[iPolicy]);
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH, &aiNumbers[i]);
+         ASSURE(iSuccessful);
+      }
+
+      /* Lookups of every kind, each moving the key found. */
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         iKey = drawKey(adCumulative, KEY_COUNT, &ulRandom);
+         ASSURE(SymTable_contains(oSymTable,
+            pcKeys + (size_t)iKey * MAX_KEY_LENGTH));
+         ASSURE(SymTable_replace(oSymTable,
+            pcKeys + (size_t)iKey * MAX_KEY_LENGTH, &aiNumbers[iKey])
+            == &aiNumbers[iKey]);
+         ASSURE(SymTable_getN(oSymTable,
+            pcKeys + (size_t)iKey * MAX_KEY_LENGTH,
+            strlen(pcKeys + (size_t)iKey * MAX_KEY_LENGTH))
+            == &aiNumbers[iKey]);
+         ASSURE(! SymTable_contains(oSymTable, "not a key"));
+      }
+      for (i = 0; i < KEY_COUNT; i++)
+         ASSURE(SymTable_get(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH) == &aiNumbers[i]);
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+      /* Lookups while a cursor is open leave it on course. */
+      memset(piSeen, 0, sizeof(int) * KEY_COUNT);
+      iCount = 0;
+      SymTable_begin(oSymTable, &sIter);
+      while (SymTable_next(&sIter, NULL, &pvValue))
+      {
+         piSeen[*(int*)pvValue]++;
+         iCount++;
+         iKey = drawKey(adCumulative, KEY_COUNT, &ulRandom);
+         ASSURE(SymTable_get(oSymTable,
+            pcKeys + (size_t)iKey * MAX_KEY_LENGTH)
+            == &aiNumbers[iKey]);
+      }
+      SymTable_end(&sIter);
+      ASSURE(iCount == KEY_COUNT);
+      for (i = 0; i < KEY_COUNT; i++)
+         ASSURE(piSeen[i] == 1);
+
+      /* The table reorders again once the cursor is closed, and
+         removals find their keys wherever they moved. */
+      for (i = 0; i < KEY_COUNT; i += 2)
+      {
+         (void)SymTable_get(oSymTable,
+            pcKeys + (size_t)(KEY_COUNT - 1 - i) * MAX_KEY_LENGTH);
+         ASSURE(SymTable_remove(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH) == &aiNumbers[i]);
+      }
+      for (i = 0; i < KEY_COUNT; i++)
+         ASSURE(SymTable_contains(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH) == (i % 2 == 1));
+      SymTable_free(oSymTable);
+   }
+
+   /* The position says how many keys a lookup compares only where
+      lookups reorder the cursor order; elsewhere it just follows the
+      table's hash seed. */
+   iReorders = movesToFront();
+   for (iPolicy = 0; iPolicy < POLICY_COUNT; iPolicy++)
+   {
+      dTime = timeSkewedLookups(aiPolicies[iPolicy], pcKeys, aiOrder,
+         aiNumbers, adCumulative, KEY_COUNT, LOOKUP_COUNT, &dPosition);
+      if (iReorders)
+         printf("CPU time per lookup (%s):  %f microseconds, "
+            "average position %.1f\n", apcNames[iPolicy], dTime,
+            dPosition);
+      else
+         printf("CPU time per lookup (%s):  %f microseconds, "
+            "policy ignored\n", apcNames[iPolicy], dTime);
+   }
+   fflush(stdout);
+
+   free(adCumulative);
+   free(piSeen);
+   free(aiOrder);
+   free(aiNumbers);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTable holds key i of the iKeyCount keys of pcKeys,
+   MAX_KEY_LENGTH characters apart, bound to &aiNumbers[i] exactly
+   when aiPresent[i] is not 0, looking each key up in every way that
+   a filter may answer for. */
+
+static void checkFilteredKeys(SymTable_T oSymTable, const char *pcKeys,
+   int aiNumbers[], const int aiPresent[], int iKeyCount)
+{
+   enum {MAX_KEY_LENGTH = 16, BATCH_COUNT = 16};
+
+   const char *apcBatch[BATCH_COUNT];
+   void *apvBatch[BATCH_COUNT];
+   const char *pcKey;
+   void *pvExpected;
+   int iBatchCount = 0;
+   int iFirst = 0;
+   int i;
+   int j;
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      pcKey = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      pvExpected = aiPresent[i] ? &aiNumbers[i] : NULL;
+      ASSURE(SymTable_contains(oSymTable, pcKey)
+             == (aiPresent[i] != 0));
+      ASSURE(SymTable_get(oSymTable, pcKey) == pvExpected);
+      ASSURE(SymTable_getN(oSymTable, pcKey, strlen(pcKey))
+         == pvExpected);
+      ASSURE(SymTable_getHashed(oSymTable, pcKey,
+         SymTable_hashKey(pcKey)) == pvExpected);
+
+      apcBatch[iBatchCount++] = pcKey;
+      if (iBatchCount == BATCH_COUNT || i == iKeyCount - 1)
+      {
+         SymTable_getBatch(oSymTable, apcBatch, (size_t)iBatchCount,
+            apvBatch);
+         for (j = 0; j < iBatchCount; j++)
+            ASSURE(apvBatch[j] == (aiPresent[iFirst + j]
+               ? &aiNumbers[iFirst + j] : NULL));
+         iFirst = i + 1;
+         iBatchCount = 0;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the first iBindingCount keys of pcKeys, MAX_KEY_LENGTH
+   characters apart, into a new SymTable object whose filter is on
+   if iFiltered is not 0, each bound to its number in aiNumbers.
+   Then call SymTable_contains on each of the next iBindingCount
+   keys, which are not in the table, in as many rounds as the clock
+   needs to measure the calls, and return the CPU time consumed per
+   call in microseconds. */
+
+static double timeMisses(int iFiltered, const char *pcKeys,
+   int aiNumbers[], int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTable_T oSymTable;
+   int iSuccessful;
+   int iRoundCount = 0;
+   int iFound = 0;
+   int i;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return 0.0;
+   iSuccessful = SymTable_setFilter(oSymTable, iFiltered);
+   ASSURE(iSuccessful);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable,
+         pcKeys + (size_t)i * MAX_KEY_LENGTH, &aiNumbers[i]);
+      ASSURE(iSuccessful);
+   }
+
+   iInitialClock = clock();
+   do
+   {
+      for (i = iBindingCount; i < 2 * iBindingCount; i++)
+         iFound += SymTable_contains(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH);
+      iRoundCount++;
+   } while (iBindingCount > 0 && keepTiming(iInitialClock));
+   iFinalClock = clock();
+   ASSURE(iFound == 0);
+
+   SymTable_free(oSymTable);
+   if (iBindingCount == 0)
+      return 0.0;
+   return ((double)(iFinalClock - iInitialClock)) * 1000000.0
+      / CLOCKS_PER_SEC / ((double)iBindingCount * iRoundCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_setFilter: that a SymTable object with its filter on
+   finds every key it holds and no other, with the default hash
+   function and a weak one, while it grows with a cursor open,
+   shrinks as keys are removed, takes them back and is compacted,
+   and with its filter turned off and on again. Then compare the
+   CPU time consumed by SymTable_contains on keys that are not in a
+   table of benchmarkCount(iBindingCount) bindings without and with
+   the filter, and write both to stdout. */
+
+static void testFilter(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 16, CHECK_COUNT = 500};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   char *pcKeys;
+   int *aiNumbers;
+   int *aiPresent;
+   void **ppvValue;
+   int iKeyCount = 2 * CHECK_COUNT;
+   int iTable;
+   int iCreated;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the filter of missing keys.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iBindingCount = benchmarkCount(iBindingCount);
+   if (iKeyCount < 2 * iBindingCount)
+      iKeyCount = 2 * iBindingCount;
+   pcKeys = (char*)malloc((size_t)MAX_KEY_LENGTH
+      * (size_t)(iKeyCount + 1));
+   aiNumbers = (int*)malloc(sizeof(int) * (size_t)(iKeyCount + 1));
+   aiPresent = (int*)calloc((size_t)(iKeyCount + 1), sizeof(int));
+   ASSURE(pcKeys != NULL && aiNumbers != NULL && aiPresent != NULL);
+   if (pcKeys == NULL || aiNumbers == NULL || aiPresent == NULL)
+      exit(EXIT_FAILURE);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "filter_%d", i);
+      aiNumbers[i] = i;
+   }
+
+   for (iTable = 0; iTable < 2; iTable++)
+   {
+      oSymTable = (iTable == 0) ? SymTable_new()
+                                : SymTable_newWithHash(hashBytewise);
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         exit(EXIT_FAILURE);
+      iSuccessful = SymTable_setFilter(oSymTable, 1);
+      ASSURE(iSuccessful);
+      memset(aiPresent, 0, sizeof(int) * 2 * CHECK_COUNT);
+      checkFilteredKeys(oSymTable, pcKeys, aiNumbers, aiPresent,
+         2 * CHECK_COUNT);
+
+      /* A cursor open over part of the puts holds back rehashes. */
+      for (i = 0; i < CHECK_COUNT; i++)
+      {
+         if (i == CHECK_COUNT / 2)
+            SymTable_begin(oSymTable, &sIter);
+         iSuccessful = SymTable_put(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH, &aiNumbers[i]);
+         ASSURE(iSuccessful);
+         aiPresent[i] = 1;
+         if (i == 3 * CHECK_COUNT / 4)
+            SymTable_end(&sIter);
+      }
+      checkFilteredKeys(oSymTable, pcKeys, aiNumbers, aiPresent,
+         2 * CHECK_COUNT);
+
+      /* Removing most keys shrinks the table and refills the filter
+         without them. */
+      for (i = 0; i < CHECK_COUNT; i++)
+      {
+         if (i % 4 == 0)
+            continue;
+         ASSURE(SymTable_remove(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH) == &aiNumbers[i]);
+         aiPresent[i] = 0;
+      }
+      checkFilteredKeys(oSymTable, pcKeys, aiNumbers, aiPresent,
+         2 * CHECK_COUNT);
+
+      /* Keys added back by SymTable_findOrInsert pass the filter. */
+      for (i = 0; i < CHECK_COUNT; i += 2)
+      {
+         ppvValue = SymTable_findOrInsert(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH, &aiNumbers[i],
+            &iCreated);
+         ASSURE(ppvValue != NULL && *ppvValue == &aiNumbers[i]);
+         ASSURE(iCreated == (aiPresent[i] == 0));
+         aiPresent[i] = 1;
+      }
+      checkFilteredKeys(oSymTable, pcKeys, aiNumbers, aiPresent,
+         2 * CHECK_COUNT);
+
+      iSuccessful = SymTable_compact(oSymTable);
+      ASSURE(iSuccessful);
+      checkFilteredKeys(oSymTable, pcKeys, aiNumbers, aiPresent,
+         2 * CHECK_COUNT);
+
+      /* Keys put while the filter is off are found once it is back
+         on. */
+      iSuccessful = SymTable_setFilter(oSymTable, 0);
+      ASSURE(iSuccessful);
+      for (i = 1; i < CHECK_COUNT; i += 2)
+      {
+         iSuccessful = SymTable_put(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH, &aiNumbers[i]);
+         ASSURE(iSuccessful);
+         aiPresent[i] = 1;
+      }
+      checkFilteredKeys(oSymTable, pcKeys, aiNumbers, aiPresent,
+         2 * CHECK_COUNT);
+      iSuccessful = SymTable_setFilter(oSymTable, 1);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_setFilter(oSymTable, 1);
+      ASSURE(iSuccessful);
+      checkFilteredKeys(oSymTable, pcKeys, aiNumbers, aiPresent,
+         2 * CHECK_COUNT);
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)CHECK_COUNT);
+      SymTable_free(oSymTable);
+   }
+
+   printf("CPU time per missing key (no filter):  %f microseconds\n",
+      timeMisses(0, pcKeys, aiNumbers, iBindingCount));
+   printf("CPU time per missing key (filter):  %f microseconds\n",
+      timeMisses(1, pcKeys, aiNumbers, iBindingCount));
+   fflush(stdout);
+
+   free(aiPresent);
+   free(aiNumbers);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ability of a SymTable object to be large, that is, to
+   contain iBindingCount bindings. Write the time consumed to stdout. */
+
+static void testLargeTable(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   SymTable_T oSymTableSmall;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   int i;
+   int iSmall;
+   int iLarge;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   size_t uLength = 0;
+   size_t uLength2;
+   double dGrowing;
+   double dPresized;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large SymTable object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* Note the current time. */
+   iInitialClock = clock();
+
+   /* Create oSymTableSmall, and put a couple of bindings into it. */
+   oSymTableSmall = SymTable_new();
+   ASSURE(oSymTableSmall != NULL);
+   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
+   ASSURE(iSuccessful);
+
+   /* Create oSymTable, the primary SymTable object. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Put iBindingCount new bindings into oSymTable.  Each binding's
+      key and value contain the same characters. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
+      ASSURE(pcValue != NULL);
+      strcpy(pcValue, acKey);
+      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
+      ASSURE(iSuccessful);
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == (size_t)(i+1));
+   }
+
+   /* Get each binding's value, and make sure that it contains
+      the same characters as its key. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Get the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iSmall++;
+      /* Get the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iLarge--;
+   }
+   /* Get the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+   }
+
+   /* Remove each binding. Also free each binding's value. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Remove the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iSmall++;
+      /* Remove the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iLarge--;
+   }
+   /* Remove the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);  
+   }
+
+   /* Make sure oSymTableSmall hasn't been corrupted by expansion
+      of oSymTable. */
+   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
+   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+
+   /* Free both SymTable objects. */
+   SymTable_free(oSymTable);
+   SymTable_free(oSymTableSmall);
+
+   /* Note the current time, and print the time consumed to stdout. */
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+
+   /* Each binding is put, gotten, and removed once, so a flat
+      per-binding cost across binding counts means O(1) operations. */
+   if (iBindingCount > 0)
+      printf("CPU time per binding:  %f microseconds\n",
+         ((double)(iFinalClock - iInitialClock)) * 1000000.0
+         / CLOCKS_PER_SEC / iBindingCount);
+
+   /* A table sized for the bindings in advance never has to grow
+      while they are put. */
+   dGrowing = timeBulkLoad(iBindingCount, 0);
+   dPresized = timeBulkLoad(iBindingCount, 1);
+   printf("CPU time to put %d bindings:  %f seconds growing, "
+      "%f seconds sized in advance\n", iBindingCount, dGrowing,
+      dPresized);
    fflush(stdout);
 }
 
@@ -960,7 +3272,24 @@ int main(int argc, char *argv[])
    testLongKey();
    testTableOfTables();
    testCollisions();
+   testInterned();
+   testNewWithHash();
+   testFindOrInsert();
+   testLengthKeys();
+   testHashedKeys();
+   testCapacity();
+   testCompact();
+   testCursor();
+   testOrderedScans();
    testLargeTable(iBindingCount);
+   testInternedLookups(iBindingCount);
+   testBatchLookups(iBindingCount);
+   testHashFunctions(iBindingCount);
+   testCollisionFlood(iBindingCount);
+   testKeyedHash();
+   testMapParallel(iBindingCount);
+   testLookupPolicies();
+   testFilter(iBindingCount);
 
    printf("------------------------------------------------------\n");
    printf("End of %s.\n", argv[0]);
@@ -0,0 +1,883 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablethreads.c                                              */
+/* Multi-threaded tests of a thread-safe SymTable implementation      */
+/*--------------------------------------------------------------------*/
+
+/* for clock_gettime */
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current wall-clock time in seconds. CPU time would add
+   up the time of all threads, hiding any speedup. */
+
+static double wallClock(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next pseudo-random number of the xorshift generator
+   whose state is *puState. */
+
+static unsigned long nextRandom(unsigned long *puState)
+{
+   unsigned long uState = *puState;
+   uState ^= uState << 13;
+   uState ^= uState >> 7;
+   uState ^= uState << 17;
+   *puState = uState;
+   return uState;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iKeyCount key strings "key_0", "key_1", ...
+   stored in one block, or NULL if memory allocation fails. */
+
+static char **makeKeys(int iKeyCount)
+{
+   enum {MAX_KEY_LENGTH = 16};
+
+   char **ppcKeys;
+   char *pcBlock;
+   int i;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)(iKeyCount + 1));
+   if (ppcKeys == NULL)
+      return NULL;
+   pcBlock = (char*)malloc((size_t)MAX_KEY_LENGTH
+      * (size_t)(iKeyCount + 1));
+   if (pcBlock == NULL)
+   {
+      free(ppcKeys);
+      return NULL;
+   }
+   for (i = 0; i < iKeyCount; i++)
+   {
+      ppcKeys[i] = pcBlock + (size_t)i * MAX_KEY_LENGTH;
+      sprintf(ppcKeys[i], "key_%d", i);
+   }
+   ppcKeys[iKeyCount] = pcBlock;
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the array ppcKeys of iKeyCount keys made by makeKeys. */
+
+static void freeKeys(char **ppcKeys, int iKeyCount)
+{
+   free(ppcKeys[iKeyCount]);
+   free(ppcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The work of one thread of testConcurrentUpdates. */
+
+struct UpdateWork
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   int iKeyCount;
+   int iThread;
+   int iThreadCount;
+   int iFailures;
+};
+
+/* Put every key that belongs to the thread described by pvWork,
+   looking up every other key as it goes, then remove the thread's
+   odd-numbered keys again. Count unexpected results in iFailures. */
+
+static void *updateKeys(void *pvWork)
+{
+   struct UpdateWork *psWork = (struct UpdateWork*)pvWork;
+   void *pvValue;
+   int i;
+
+   for (i = psWork->iThread; i < psWork->iKeyCount;
+      i += psWork->iThreadCount)
+   {
+      if (! SymTable_put(psWork->oSymTable, psWork->ppcKeys[i],
+         psWork->ppcKeys[i]))
+         psWork->iFailures++;
+      /* another thread's key is either absent or bound correctly */
+      pvValue = SymTable_get(psWork->oSymTable,
+         psWork->ppcKeys[psWork->iKeyCount - 1 - i]);
+      if (pvValue != NULL
+         && pvValue != psWork->ppcKeys[psWork->iKeyCount - 1 - i])
+         psWork->iFailures++;
+   }
+   for (i = psWork->iThread; i < psWork->iKeyCount;
+      i += psWork->iThreadCount)
+   {
+      if (i % 2 == 1
+         && SymTable_remove(psWork->oSymTable, psWork->ppcKeys[i])
+            != psWork->ppcKeys[i])
+         psWork->iFailures++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that iThreadCount threads can put, get and remove iKeyCount
+   keys at the same time, starting from an empty table so that the
+   table grows while they run. */
+
+static void testConcurrentUpdates(int iKeyCount, int iThreadCount)
+{
+   SymTable_T oSymTable;
+   struct UpdateWork *psWorks;
+   pthread_t *psThreads;
+   char **ppcKeys;
+   int iThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing concurrent puts, gets and removes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ppcKeys = makeKeys(iKeyCount);
+   psWorks = (struct UpdateWork*)malloc(sizeof(struct UpdateWork)
+      * (size_t)iThreadCount);
+   psThreads = (pthread_t*)malloc(sizeof(pthread_t)
+      * (size_t)iThreadCount);
+   oSymTable = SymTable_new();
+   ASSURE(ppcKeys != NULL && psWorks != NULL && psThreads != NULL
+      && oSymTable != NULL);
+   if (ppcKeys == NULL || psWorks == NULL || psThreads == NULL
+      || oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      psWorks[iThread].oSymTable = oSymTable;
+      psWorks[iThread].ppcKeys = ppcKeys;
+      psWorks[iThread].iKeyCount = iKeyCount;
+      psWorks[iThread].iThread = iThread;
+      psWorks[iThread].iThreadCount = iThreadCount;
+      psWorks[iThread].iFailures = 0;
+      ASSURE(pthread_create(&psThreads[iThread], NULL, updateKeys,
+         &psWorks[iThread]) == 0);
+   }
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      ASSURE(pthread_join(psThreads[iThread], NULL) == 0);
+      ASSURE(psWorks[iThread].iFailures == 0);
+   }
+
+   /* Exactly the even-numbered keys remain. */
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)(iKeyCount + 1) / 2);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      if (i % 2 == 0)
+         ASSURE(SymTable_get(oSymTable, ppcKeys[i]) == ppcKeys[i]);
+      else
+         ASSURE(! SymTable_contains(oSymTable, ppcKeys[i]));
+   }
+
+   SymTable_free(oSymTable);
+   free(psThreads);
+   free(psWorks);
+   freeKeys(ppcKeys, iKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The work of one thread of testConcurrentReads. */
+
+struct ReadWork
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   int iKeyCount;
+   int iThread;
+   int iThreadCount;
+   int iFailures;
+};
+
+/* If the thread described by pvWork is a writer, put and remove its
+   share of the second half of the keys, twice; if it is a reader,
+   repeatedly look up the keys of the first half, which stay bound
+   throughout. Count unexpected results in iFailures. */
+
+static void *readOrChurnKeys(void *pvWork)
+{
+   enum {CHURN_ROUNDS = 2, READ_ROUNDS = 4};
+
+   struct ReadWork *psWork = (struct ReadWork*)pvWork;
+   int iHalf = psWork->iKeyCount / 2;
+   int iRound;
+   int i;
+
+   /* Even-numbered threads write, odd-numbered ones read. */
+   if (psWork->iThread % 2 == 0)
+   {
+      for (iRound = 0; iRound < CHURN_ROUNDS; iRound++)
+      {
+         for (i = iHalf + psWork->iThread; i < psWork->iKeyCount;
+            i += psWork->iThreadCount)
+            if (! SymTable_put(psWork->oSymTable, psWork->ppcKeys[i],
+               psWork->ppcKeys[i]))
+               psWork->iFailures++;
+         for (i = iHalf + psWork->iThread; i < psWork->iKeyCount;
+            i += psWork->iThreadCount)
+            if (SymTable_remove(psWork->oSymTable, psWork->ppcKeys[i])
+               != psWork->ppcKeys[i])
+               psWork->iFailures++;
+      }
+      return NULL;
+   }
+
+   for (iRound = 0; iRound < READ_ROUNDS; iRound++)
+   {
+      for (i = 0; i < iHalf; i++)
+         if (SymTable_get(psWork->oSymTable, psWork->ppcKeys[i])
+            != psWork->ppcKeys[i])
+            psWork->iFailures++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that lookups by iThreadCount / 2 threads always find keys
+   that stay bound, while as many other threads grow the table and
+   remove bindings around them. */
+
+static void testConcurrentReads(int iKeyCount, int iThreadCount)
+{
+   SymTable_T oSymTable;
+   struct ReadWork *psWorks;
+   pthread_t *psThreads;
+   char **ppcKeys;
+   int iThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups during concurrent growth and removes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* At least one writer and one reader. */
+   if (iThreadCount < 2)
+      iThreadCount = 2;
+
+   ppcKeys = makeKeys(iKeyCount);
+   psWorks = (struct ReadWork*)malloc(sizeof(struct ReadWork)
+      * (size_t)iThreadCount);
+   psThreads = (pthread_t*)malloc(sizeof(pthread_t)
+      * (size_t)iThreadCount);
+   oSymTable = SymTable_new();
+   ASSURE(ppcKeys != NULL && psWorks != NULL && psThreads != NULL
+      && oSymTable != NULL);
+   if (ppcKeys == NULL || psWorks == NULL || psThreads == NULL
+      || oSymTable == NULL)
+      exit(EXIT_FAILURE);
+   for (i = 0; i < iKeyCount / 2; i++)
+      ASSURE(SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]));
+
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      psWorks[iThread].oSymTable = oSymTable;
+      psWorks[iThread].ppcKeys = ppcKeys;
+      psWorks[iThread].iKeyCount = iKeyCount;
+      psWorks[iThread].iThread = iThread;
+      psWorks[iThread].iThreadCount = iThreadCount;
+      psWorks[iThread].iFailures = 0;
+      ASSURE(pthread_create(&psThreads[iThread], NULL, readOrChurnKeys,
+         &psWorks[iThread]) == 0);
+   }
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      ASSURE(pthread_join(psThreads[iThread], NULL) == 0);
+      ASSURE(psWorks[iThread].iFailures == 0);
+   }
+
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)(iKeyCount / 2));
+
+   SymTable_free(oSymTable);
+   free(psThreads);
+   free(psWorks);
+   freeKeys(ppcKeys, iKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that cursors opened by the main thread return every key that
+   stays bound exactly once, and no other key more than once, while
+   iThreadCount threads look keys up, grow the table and remove
+   bindings around them. */
+
+static void testConcurrentCursors(int iKeyCount, int iThreadCount)
+{
+   enum {CURSOR_ROUNDS = 4};
+
+   SymTable_T oSymTable;
+   struct ReadWork *psWorks;
+   struct SymTableIter sIter;
+   pthread_t *psThreads;
+   char **ppcKeys;
+   int *piSeen;
+   const char *pcKey;
+   void *pvValue;
+   int iThread;
+   int iRound;
+   int iKey;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing cursors during concurrent growth and removes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* At least one writer and one reader. */
+   if (iThreadCount < 2)
+      iThreadCount = 2;
+
+   ppcKeys = makeKeys(iKeyCount);
+   psWorks = (struct ReadWork*)malloc(sizeof(struct ReadWork)
+      * (size_t)iThreadCount);
+   psThreads = (pthread_t*)malloc(sizeof(pthread_t)
+      * (size_t)iThreadCount);
+   piSeen = (int*)malloc(sizeof(int) * (size_t)iKeyCount);
+   oSymTable = SymTable_new();
+   ASSURE(ppcKeys != NULL && psWorks != NULL && psThreads != NULL
+      && piSeen != NULL && oSymTable != NULL);
+   if (ppcKeys == NULL || psWorks == NULL || psThreads == NULL
+      || piSeen == NULL || oSymTable == NULL)
+      exit(EXIT_FAILURE);
+   for (i = 0; i < iKeyCount / 2; i++)
+      ASSURE(SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]));
+
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      psWorks[iThread].oSymTable = oSymTable;
+      psWorks[iThread].ppcKeys = ppcKeys;
+      psWorks[iThread].iKeyCount = iKeyCount;
+      psWorks[iThread].iThread = iThread;
+      psWorks[iThread].iThreadCount = iThreadCount;
+      psWorks[iThread].iFailures = 0;
+      ASSURE(pthread_create(&psThreads[iThread], NULL, readOrChurnKeys,
+         &psWorks[iThread]) == 0);
+   }
+
+   for (iRound = 0; iRound < CURSOR_ROUNDS; iRound++)
+   {
+      memset(piSeen, 0, sizeof(int) * (size_t)iKeyCount);
+      SymTable_begin(oSymTable, &sIter);
+      while (SymTable_next(&sIter, &pcKey, &pvValue))
+      {
+         iKey = atoi(pcKey + strlen("key_"));
+         ASSURE(iKey >= 0 && iKey < iKeyCount);
+         if (iKey < 0 || iKey >= iKeyCount)
+            continue;
+         ASSURE(pvValue == ppcKeys[iKey]);
+         piSeen[iKey]++;
+      }
+      SymTable_end(&sIter);
+      for (i = 0; i < iKeyCount; i++)
+         ASSURE(piSeen[i] == 1
+                || (i >= iKeyCount / 2 && piSeen[i] == 0));
+   }
+
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      ASSURE(pthread_join(psThreads[iThread], NULL) == 0);
+      ASSURE(psWorks[iThread].iFailures == 0);
+   }
+
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)(iKeyCount / 2));
+
+   SymTable_free(oSymTable);
+   free(piSeen);
+   free(psThreads);
+   free(psWorks);
+   freeKeys(ppcKeys, iKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The work of one thread of testConcurrentInterning. */
+
+struct InternWork
+{
+   char **ppcKeys;
+   int iKeyCount;
+   int iThread;
+   SymTableKey_T *poKeys;
+};
+
+/* Intern every key, starting at a different key in each thread so
+   that threads race to create the same handles, and store key i's
+   handle in poKeys[i]. */
+
+static void *internKeys(void *pvWork)
+{
+   struct InternWork *psWork = (struct InternWork*)pvWork;
+   int iStart;
+   int i;
+   int j;
+
+   iStart = (int)(((long)psWork->iThread * 7919) % psWork->iKeyCount);
+   for (j = 0; j < psWork->iKeyCount; j++)
+   {
+      i = (iStart + j) % psWork->iKeyCount;
+      psWork->poKeys[i] = SymTable_intern(psWork->ppcKeys[i]);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that iThreadCount threads interning the same iKeyCount keys
+   at the same time all get the same handle for each key. */
+
+static void testConcurrentInterning(int iKeyCount, int iThreadCount)
+{
+   struct InternWork *psWorks;
+   pthread_t *psThreads;
+   SymTableKey_T *poKeys;
+   char **ppcKeys;
+   int iThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing concurrent interning.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ppcKeys = makeKeys(iKeyCount);
+   psWorks = (struct InternWork*)malloc(sizeof(struct InternWork)
+      * (size_t)iThreadCount);
+   psThreads = (pthread_t*)malloc(sizeof(pthread_t)
+      * (size_t)iThreadCount);
+   poKeys = (SymTableKey_T*)malloc(sizeof(SymTableKey_T)
+      * (size_t)iKeyCount * (size_t)iThreadCount);
+   ASSURE(ppcKeys != NULL && psWorks != NULL && psThreads != NULL
+      && poKeys != NULL);
+   if (ppcKeys == NULL || psWorks == NULL || psThreads == NULL
+      || poKeys == NULL)
+      exit(EXIT_FAILURE);
+
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      psWorks[iThread].ppcKeys = ppcKeys;
+      psWorks[iThread].iKeyCount = iKeyCount;
+      psWorks[iThread].iThread = iThread;
+      psWorks[iThread].poKeys = poKeys + (size_t)iThread * iKeyCount;
+      ASSURE(pthread_create(&psThreads[iThread], NULL, internKeys,
+         &psWorks[iThread]) == 0);
+   }
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+      ASSURE(pthread_join(psThreads[iThread], NULL) == 0);
+
+   /* Every thread got the one canonical handle of every key. */
+   for (i = 0; i < iKeyCount; i++)
+   {
+      ASSURE(poKeys[i] != NULL);
+      ASSURE(poKeys[i] == SymTable_intern(ppcKeys[i]));
+      ASSURE(strcmp(SymTable_keyString(poKeys[i]), ppcKeys[i]) == 0);
+      for (iThread = 1; iThread < iThreadCount; iThread++)
+         ASSURE(poKeys[(size_t)iThread * iKeyCount + i] == poKeys[i]);
+   }
+
+   free(poKeys);
+   free(psThreads);
+   free(psWorks);
+   freeKeys(ppcKeys, iKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The work of one thread of testStress. */
+
+struct StressWork
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   int iKeyCount;
+   int iOperationCount;
+   unsigned long uSeed;
+   long lNetPuts;
+   int iFailures;
+};
+
+/* Put, replace, remove and look up random keys of the thread
+   described by pvWork, all of which every other thread uses too.
+   Count successful puts minus successful removes in lNetPuts, and
+   unexpected results in iFailures. Every value bound to a key is the
+   key itself. */
+
+static void *stressKeys(void *pvWork)
+{
+   struct StressWork *psWork = (struct StressWork*)pvWork;
+   unsigned long uState = psWork->uSeed;
+   unsigned long uRandom;
+   char *pcKey;
+   void *pvValue;
+   int i;
+
+   for (i = 0; i < psWork->iOperationCount; i++)
+   {
+      uRandom = nextRandom(&uState);
+      pcKey = psWork->ppcKeys[(uRandom >> 2)
+         % (unsigned long)psWork->iKeyCount];
+      switch (uRandom & 3)
+      {
+         case 0:
+            if (SymTable_put(psWork->oSymTable, pcKey, pcKey))
+               psWork->lNetPuts++;
+            break;
+         case 1:
+            pvValue = SymTable_remove(psWork->oSymTable, pcKey);
+            if (pvValue != NULL)
+               psWork->lNetPuts--;
+            if (pvValue != NULL && pvValue != pcKey)
+               psWork->iFailures++;
+            break;
+         case 2:
+            pvValue = SymTable_replace(psWork->oSymTable, pcKey, pcKey);
+            if (pvValue != NULL && pvValue != pcKey)
+               psWork->iFailures++;
+            break;
+         default:
+            pvValue = SymTable_get(psWork->oSymTable, pcKey);
+            if (pvValue != NULL && pvValue != pcKey)
+               psWork->iFailures++;
+            break;
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Increment the count *pvExtra of bindings. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that iThreadCount threads hammering a small set of keys with
+   random puts, replaces, removes and lookups leave the table
+   consistent: once they stop, SymTable_getLength, SymTable_contains
+   and SymTable_map all agree with the puts and removes that
+   succeeded. The operations add up to 4 * iKeyCount. */
+
+static void testStress(int iKeyCount, int iThreadCount)
+{
+   enum {OPERATIONS_PER_KEY = 4, KEYS_PER_SHARED_KEY = 8};
+
+   SymTable_T oSymTable;
+   struct StressWork *psWorks;
+   pthread_t *psThreads;
+   char **ppcKeys;
+   int iSharedKeyCount = iKeyCount / KEYS_PER_SHARED_KEY + 1;
+   long lNetPuts = 0;
+   size_t uContained = 0;
+   size_t uMapped = 0;
+   int iThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing consistency under random concurrent updates.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ppcKeys = makeKeys(iSharedKeyCount);
+   psWorks = (struct StressWork*)malloc(sizeof(struct StressWork)
+      * (size_t)iThreadCount);
+   psThreads = (pthread_t*)malloc(sizeof(pthread_t)
+      * (size_t)iThreadCount);
+   oSymTable = SymTable_new();
+   ASSURE(ppcKeys != NULL && psWorks != NULL && psThreads != NULL
+      && oSymTable != NULL);
+   if (ppcKeys == NULL || psWorks == NULL || psThreads == NULL
+      || oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      psWorks[iThread].oSymTable = oSymTable;
+      psWorks[iThread].ppcKeys = ppcKeys;
+      psWorks[iThread].iKeyCount = iSharedKeyCount;
+      psWorks[iThread].iOperationCount =
+         iKeyCount * OPERATIONS_PER_KEY / iThreadCount;
+      psWorks[iThread].uSeed = 2463534242UL + (unsigned long)iThread;
+      psWorks[iThread].lNetPuts = 0;
+      psWorks[iThread].iFailures = 0;
+      ASSURE(pthread_create(&psThreads[iThread], NULL, stressKeys,
+         &psWorks[iThread]) == 0);
+   }
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      ASSURE(pthread_join(psThreads[iThread], NULL) == 0);
+      ASSURE(psWorks[iThread].iFailures == 0);
+      lNetPuts += psWorks[iThread].lNetPuts;
+   }
+
+   /* The table is quiet now, so every count must agree. */
+   for (i = 0; i < iSharedKeyCount; i++)
+   {
+      if (SymTable_contains(oSymTable, ppcKeys[i]))
+      {
+         uContained++;
+         ASSURE(SymTable_get(oSymTable, ppcKeys[i]) == ppcKeys[i]);
+      }
+   }
+   SymTable_map(oSymTable, countBinding, &uMapped);
+   ASSURE(lNetPuts >= 0);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)lNetPuts);
+   ASSURE(uContained == (size_t)lNetPuts);
+   ASSURE(uMapped == (size_t)lNetPuts);
+
+   SymTable_free(oSymTable);
+   free(psThreads);
+   free(psWorks);
+   freeKeys(ppcKeys, iSharedKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The work of one thread of timeMixedWorkload. If psGlobalLock is
+   not NULL, every call into the table is made holding it, as a
+   program would have to with a table that is not thread-safe. */
+
+struct MixedWork
+{
+   SymTable_T oSymTable;
+   pthread_mutex_t *psGlobalLock;
+   char **ppcKeys;
+   int iKeyCount;
+   int iOperationCount;
+   int iUpdatePercent;
+   unsigned long uRandomState;
+   int iFound;
+};
+
+/* Perform the random operations of the thread described by pvWork:
+   gets of random keys, and puts and removes, half each, for
+   iUpdatePercent percent of the operations. */
+
+static void *mixOperations(void *pvWork)
+{
+   struct MixedWork *psWork = (struct MixedWork*)pvWork;
+   unsigned long uRandom;
+   const char *pcKey;
+   int iOperation;
+   int i;
+
+   for (i = 0; i < psWork->iOperationCount; i++)
+   {
+      uRandom = nextRandom(&psWork->uRandomState);
+      pcKey = psWork->ppcKeys[(uRandom >> 8)
+         % (unsigned long)psWork->iKeyCount];
+      iOperation = (int)(uRandom % 100);
+
+      if (psWork->psGlobalLock != NULL)
+         pthread_mutex_lock(psWork->psGlobalLock);
+      if (iOperation * 2 < psWork->iUpdatePercent)
+         (void)SymTable_put(psWork->oSymTable, pcKey, pcKey);
+      else if (iOperation < psWork->iUpdatePercent)
+         (void)SymTable_remove(psWork->oSymTable, pcKey);
+      else if (SymTable_get(psWork->oSymTable, pcKey) == pcKey)
+         psWork->iFound++;
+      if (psWork->psGlobalLock != NULL)
+         pthread_mutex_unlock(psWork->psGlobalLock);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run iOperationCount random operations, iUpdatePercent percent of
+   them updates, split evenly between iThreadCount threads, against a
+   table holding about half of the iKeyCount keys of ppcKeys.
+   Serialize every call with one global mutex if iGlobalLock is 1.
+   Return the wall-clock time consumed. */
+
+static double timeMixedWorkload(char **ppcKeys, int iKeyCount,
+   int iOperationCount, int iUpdatePercent, int iThreadCount,
+   int iGlobalLock)
+{
+   SymTable_T oSymTable;
+   pthread_mutex_t sGlobalLock;
+   struct MixedWork *psWorks;
+   pthread_t *psThreads;
+   double dInitialTime;
+   double dFinalTime;
+   int iThread;
+   int i;
+
+   psWorks = (struct MixedWork*)malloc(sizeof(struct MixedWork)
+      * (size_t)iThreadCount);
+   psThreads = (pthread_t*)malloc(sizeof(pthread_t)
+      * (size_t)iThreadCount);
+   oSymTable = SymTable_new();
+   ASSURE(psWorks != NULL && psThreads != NULL && oSymTable != NULL);
+   if (psWorks == NULL || psThreads == NULL || oSymTable == NULL)
+      exit(EXIT_FAILURE);
+   for (i = 0; i < iKeyCount; i += 2)
+      ASSURE(SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]));
+   pthread_mutex_init(&sGlobalLock, NULL);
+
+   dInitialTime = wallClock();
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+   {
+      psWorks[iThread].oSymTable = oSymTable;
+      psWorks[iThread].psGlobalLock = iGlobalLock ? &sGlobalLock : NULL;
+      psWorks[iThread].ppcKeys = ppcKeys;
+      psWorks[iThread].iKeyCount = iKeyCount;
+      psWorks[iThread].iOperationCount = iOperationCount / iThreadCount;
+      psWorks[iThread].iUpdatePercent = iUpdatePercent;
+      psWorks[iThread].uRandomState =
+         2463534242UL + (unsigned long)iThread;
+      psWorks[iThread].iFound = 0;
+      ASSURE(pthread_create(&psThreads[iThread], NULL, mixOperations,
+         &psWorks[iThread]) == 0);
+   }
+   for (iThread = 0; iThread < iThreadCount; iThread++)
+      ASSURE(pthread_join(psThreads[iThread], NULL) == 0);
+   dFinalTime = wallClock();
+
+   pthread_mutex_destroy(&sGlobalLock);
+   SymTable_free(oSymTable);
+   free(psThreads);
+   free(psWorks);
+   return dFinalTime - dInitialTime;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the throughput of workloads on iKeyCount keys run
+   by 1, 2, 4, ... up to iMaxThreadCount threads, both with the
+   table's own locking and with one global mutex around every call.
+   One workload is read-mostly and one has 20% updates. */
+
+static void testThroughput(int iKeyCount, int iMaxThreadCount)
+{
+   enum {OPERATIONS_PER_KEY = 8, MIX_COUNT = 2};
+
+   static const int aiUpdatePercents[MIX_COUNT] = {2, 20};
+   char **ppcKeys;
+   int iOperationCount;
+   int iThreadCount;
+   int iMix;
+   double dStripedTime;
+   double dGlobalTime;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing throughput as threads are added.\n");
+   printf("No output except wall-clock time consumed should appear "
+      "here:\n");
+   fflush(stdout);
+
+   ppcKeys = makeKeys(iKeyCount);
+   ASSURE(ppcKeys != NULL);
+   if (ppcKeys == NULL)
+      return;
+   iOperationCount = iKeyCount * OPERATIONS_PER_KEY;
+
+   for (iMix = 0; iMix < MIX_COUNT; iMix++)
+   {
+      printf("%d%% updates:\n", aiUpdatePercents[iMix]);
+      for (iThreadCount = 1; iThreadCount <= iMaxThreadCount;
+         iThreadCount *= 2)
+      {
+         dStripedTime = timeMixedWorkload(ppcKeys, iKeyCount,
+            iOperationCount, aiUpdatePercents[iMix], iThreadCount, 0);
+         dGlobalTime = timeMixedWorkload(ppcKeys, iKeyCount,
+            iOperationCount, aiUpdatePercents[iMix], iThreadCount, 1);
+         printf("%2d threads: %f seconds (global mutex: %f seconds), "
+            "%.0f operations per second\n", iThreadCount,
+            dStripedTime, dGlobalTime, dStripedTime > 0.0
+               ? (double)iOperationCount / dStripedTime : 0.0);
+      }
+   }
+
+   freeKeys(ppcKeys, iKeyCount);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a thread-safe SymTable implementation. The first command-line
+   argument is the number of bindings to use, and the optional second
+   one the largest number of threads. Return 0, or EXIT_FAILURE if the
+   arguments are invalid. */
+
+int main(int argc, char *argv[])
+{
+   enum {DEFAULT_MAX_THREAD_COUNT = 8};
+
+   int iBindingCount;
+   int iMaxThreadCount = DEFAULT_MAX_THREAD_COUNT;
+
+   if (argc != 2 && argc != 3)
+   {
+      fprintf(stderr, "Usage: %s bindingcount [maxthreads]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1
+      || (argc == 3 && sscanf(argv[2], "%d", &iMaxThreadCount) != 1))
+   {
+      fprintf(stderr, "arguments must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 1 || iMaxThreadCount < 1)
+   {
+      fprintf(stderr, "arguments must be positive\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testConcurrentUpdates(iBindingCount, iMaxThreadCount);
+   testConcurrentReads(iBindingCount, iMaxThreadCount);
+   testConcurrentCursors(iBindingCount, iMaxThreadCount);
+   testConcurrentInterning(iBindingCount, iMaxThreadCount);
+   testStress(iBindingCount, iMaxThreadCount);
+   testThroughput(iBindingCount, iMaxThreadCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}